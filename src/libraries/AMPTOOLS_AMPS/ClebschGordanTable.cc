@@ -0,0 +1,39 @@
+
+#include <pthread.h>
+
+#include "AMPTOOLS_AMPS/ClebschGordanTable.h"
+
+using namespace std;
+
+static pthread_mutex_t instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+const ClebschGordanTable* ClebschGordanTable::Get( int jMax ) {
+
+	// a function-local map, so that tables can be created during static initialization
+	static map< int, ClebschGordanTable* > instances;
+
+	// instances are never deleted, so the pointer stays valid for the life of the process
+	pthread_mutex_lock(&instancesMutex);
+	ClebschGordanTable *table = instances[jMax];
+	if(!table) {
+		table = new ClebschGordanTable(jMax);
+		instances[jMax] = table;
+	}
+	pthread_mutex_unlock(&instancesMutex);
+
+	return table;
+}
+
+ClebschGordanTable::ClebschGordanTable( int jMax ) :
+	mJMax(jMax),
+	mN((jMax+1)*(jMax+1)) {
+
+	mTable.assign((jMax+1)*mN*mN, 0.);
+	for(int j=0; j<=jMax; j++)
+		for(int j1=0; j1<=jMax; j1++)
+			for(int m1=-j1; m1<=j1; m1++)
+				for(int j2=0; j2<=jMax; j2++)
+					for(int m2=-j2; m2<=j2; m2++)
+						mTable[(j*mN + j1*j1 + m1 + j1)*mN + j2*j2 + m2 + j2] =
+							clebschGordan(j1, j2, m1, m2, j, m1 + m2);
+}
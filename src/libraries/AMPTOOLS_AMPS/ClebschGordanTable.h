@@ -0,0 +1,53 @@
+#if !defined(CLEBSCHGORDANTABLE)
+#define CLEBSCHGORDANTABLE
+
+/*
+ *  ClebschGordanTable.h
+ *
+ *  Tabulated Clebsch-Gordan coefficients for integer spins up to jMax, for use by
+ *  amplitudes that need them for every event.  The table holds clebschGordan( j1, j2,
+ *  m1, m2, j, m1+m2 ) for all j1, j2, j <= jMax and all m1, m2, so a lookup returns
+ *  exactly the value of clebschGordan.  Arguments outside the table are passed on to
+ *  clebschGordan.  Instances are shared, one per jMax, and are never deleted.
+ */
+
+#include <vector>
+#include <map>
+#include <math.h>
+#include <stdlib.h>
+
+#include "AMPTOOLS_AMPS/clebschGordan.h"
+
+class ClebschGordanTable {
+
+public:
+
+  // shared table for all spins j1, j2, j <= jMax, created on first use
+  static const ClebschGordanTable* Get( int jMax );
+
+  int jMax() const { return mJMax; }
+
+  // same as clebschGordan( j1, j2, m1, m2, j, m )
+  inline double cg( int j1, int j2, int m1, int m2, int j, int m ) const {
+    if( j1 > mJMax || j2 > mJMax || j > mJMax || j1 < 0 || j2 < 0 || j < 0 )
+      return clebschGordan( j1, j2, m1, m2, j, m );
+    if( m != m1 + m2 || abs( m1 ) > j1 || abs( m2 ) > j2 || abs( m ) > j ) return 0;
+    return mTable[ ( j * mN + j1*j1 + m1 + j1 ) * mN + j2*j2 + m2 + j2 ];
+  }
+
+  // Wigner 3j symbol, the same as s3j( j1, j2, j3, m1, m2, m3 ) for integer spins
+  inline double threeJ( int j1, int j2, int j3, int m1, int m2, int m3 ) const {
+    double c = cg( j1, j2, m1, m2, j3, -m3 ) / sqrt( 2.0*j3 + 1 );
+    return ( ( j1 - j2 - m3 ) % 2 == 0 ? c : -c );
+  }
+
+private:
+
+  ClebschGordanTable( int jMax );
+
+  int mJMax;
+  int mN;                      // number of (j, m) states with j <= jMax
+  std::vector<double> mTable;  // indexed by j and the (j1, m1) and (j2, m2) states
+};
+
+#endif
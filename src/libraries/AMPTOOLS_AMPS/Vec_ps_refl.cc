@@ -10,12 +10,10 @@
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Vec_ps_refl.h"
-#include "AMPTOOLS_AMPS/clebschGordan.h"
-#include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/ClebschGordanTable.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
 #include "AMPTOOLS_AMPS/omegapiAngles.h"
 
-#include "UTILITIES/BeamProperties.h"
-
 Vec_ps_refl::Vec_ps_refl( const vector< string >& args ) :
 UserAmplitude< Vec_ps_refl >( args )
 {
@@ -33,10 +31,9 @@ UserAmplitude< Vec_ps_refl >( args )
   polFraction = atof(args[6].c_str());
   
   // BeamProperties configuration file
+  beamPol = NULL;
   if (polFraction == 0){
-    TString beamConfigFile = args[6].c_str();
-    BeamProperties beamProp(beamConfigFile);
-    polFrac_vs_E = (TH1D*)beamProp.GetPolFrac();
+    beamPol = BeamPolarization::Get( args[6] );
   }
 
   if(args.size() == (11)){
@@ -62,7 +59,15 @@ UserAmplitude< Vec_ps_refl >( args )
   // m_s = +1 for 1 + Pgamma
   // m_s = -1 for 1 - Pgamma
   assert( abs( m_s ) == 1 );
-  
+
+  // the angular factors of calcAmplitude: D-functions up to spin J and the vector
+  // helicity couplings, which only depend on the wave
+  int jMax = ( m_j > m_l ? m_j : m_l );
+  if( jMax < 1 ) jMax = 1;
+  m_wignerD = WignerDTable::Get( jMax );
+  const ClebschGordanTable *cgTable = ClebschGordanTable::Get( jMax );
+  for (int lambda = -1; lambda <= 1; lambda++)
+	  m_helAmp[lambda+1] = cgTable->cg(m_l, 1, 0, lambda, m_j, lambda);
 }
 
 void
@@ -116,17 +121,8 @@ Vec_ps_refl::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
   GDouble Pgamma=polFraction;//fixed beam polarization fraction
   if(polAngle == -1)
 	  Pgamma = 0.;//if beam is amorphous set polarization fraction to 0
-  else if(0) { //polFrac_vs_E!=NULL){
-	  //This part causes seg fault with 34 amplitudes or more with gen_amp and gen_omegapi.
-	  //Not needed for fixed beam pol angle and frac.
-	  int bin = polFrac_vs_E->GetXaxis()->FindBin(beam.E());
-	  
-	  if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-		  Pgamma = 0.;
-	  }
-	  else
-		  Pgamma = polFrac_vs_E->GetBinContent(bin);
-  }
+  else if(beamPol != NULL)
+	  Pgamma = beamPol->Fraction(beam.E());
 
   // Calculate decay angles in helicity frame (same for all vectors)
   vector <double> locthetaphi = getomegapiAngles(polAngle, vec, X, beam, Gammap);
@@ -171,8 +167,8 @@ Vec_ps_refl::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
   complex <GDouble> i(0,1);
 
   for (int lambda = -1; lambda <= 1; lambda++) { // sum over vector helicity
-	  GDouble hel_amp = clebschGordan(m_l, 1, 0, lambda, m_j, lambda);
-	  amplitude += conj(wignerD( m_j, m_m, lambda, cosTheta, Phi )) * hel_amp * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) * G;
+	  GDouble hel_amp = m_helAmp[lambda+1];
+	  amplitude += conj(m_wignerD->D( m_j, m_m, lambda, cosTheta, Phi )) * hel_amp * conj(m_wignerD->D( 1, lambda, 0, cosThetaH, PhiH )) * G;
   } 
   
   GDouble Factor = sqrt(1 + m_s * polfrac);
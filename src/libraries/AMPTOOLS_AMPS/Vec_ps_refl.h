@@ -5,8 +5,9 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "UTILITIES/BeamPolarization.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
 
-#include "TH1D.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -66,6 +67,9 @@ private:
 	int m_r;
 	int m_s;
 	int m_3pi;
+
+	const WignerDTable *m_wignerD;
+	GDouble m_helAmp[3];  // clebschGordan(m_l, 1, 0, lambda, m_j, lambda) for lambda = -1, 0, 1
 	
 	AmpParameter dalitz_alpha;
 	AmpParameter dalitz_beta;
@@ -75,7 +79,7 @@ private:
 	AmpParameter polAngle;
 	
 	double polFraction;
-	TH1D *polFrac_vs_E;
+	BeamPolarization *beamPol;
 };
 
 #endif
@@ -0,0 +1,85 @@
+
+#include <pthread.h>
+
+#include "AMPTOOLS_AMPS/WignerDTable.h"
+
+using namespace std;
+
+static pthread_mutex_t instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+const WignerDTable* WignerDTable::Get( int jMax ) {
+
+	// a function-local map, so that tables can be created during static initialization
+	static map< int, WignerDTable* > instances;
+
+	// instances are never deleted, so the pointer stays valid for the life of the process
+	pthread_mutex_lock(&instancesMutex);
+	WignerDTable *table = instances[jMax];
+	if(!table) {
+		table = new WignerDTable(jMax);
+		instances[jMax] = table;
+	}
+	pthread_mutex_unlock(&instancesMutex);
+
+	return table;
+}
+
+WignerDTable::WignerDTable( int jMax ) :
+	mJMax(jMax) {
+
+	vector<long double> fact(1, 1.0L);
+	for(int i=1; i<=2*jMax+1; i++)
+		fact.push_back(fact[i-1] * i);
+
+	for(int j=0; j<=jMax; j++) {
+		mFirst.push_back(mEntries.size());
+		for(int m=-j; m<=j; m++) {
+			for(int n=-j; n<=j; n++) {
+
+				// The terms of the series in wignerDSmall are
+				//
+				//   (-1)^(k+j+m) sqrt((j+m)!(j-m)!(j+n)!(j-n)!) / (k!(j+m-k)!(j+n-k)!(k-m-n)!)
+				//      * cos(theta/2)^(2k-m-n) * sin(theta/2)^(2j+m+n-2k)
+				//
+				// With cos^2(theta/2) = (1+x)/2, sin^2(theta/2) = (1-x)/2 and, for
+				// m+n odd, cos(theta/2)sin(theta/2) = sin(theta)/2, each term is a
+				// polynomial in x = cos(theta).  The sum is done in long double, so
+				// that the cancellations between terms cost no double precision.
+
+				int jpm = j+m, jmm = j-m, jpn = j+n, jmn = j-n, mpn = m+n;
+				int odd = (mpn % 2 != 0);
+				int degree = j - odd;
+				long double norm = sqrtl(fact[jpm] * fact[jmm] * fact[jpn] * fact[jmn]) / powl(2.0L, j);
+
+				vector<long double> poly(degree+1, 0.0L);
+				int k0 = (0 > mpn ? 0 : mpn);
+				int k1 = (jpm < jpn ? jpm : jpn);
+				for(int k=k0; k<=k1; k++) {
+					long double a = norm / (fact[k] * fact[jpm-k] * fact[jpn-k] * fact[k-mpn]);
+					if((k + jpm) % 2 != 0) a = -a;
+
+					// a * (1+x)^p * (1-x)^q
+					int p = (2*k - mpn - odd) / 2;
+					int q = (jpm + jpn - 2*k - odd) / 2;
+					vector<long double> term(1, a);
+					for(int i=0; i<p+q; i++) {
+						long double s = (i < p ? 1.0L : -1.0L);
+						term.push_back(0.0L);
+						for(int l=(int)term.size()-1; l>0; l--)
+							term[l] += s * term[l-1];
+					}
+					for(int l=0; l<=degree; l++)
+						poly[l] += term[l];
+				}
+
+				Entry e;
+				e.first = mCoefs.size();
+				e.degree = degree;
+				e.sinTheta = odd;
+				for(int l=0; l<=degree; l++)
+					mCoefs.push_back(poly[l]);
+				mEntries.push_back(e);
+			}
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#if !defined(WIGNERDTABLE)
+#define WIGNERDTABLE
+
+/*
+ *  WignerDTable.h
+ *
+ *  Tabulated Wigner D-functions for integer spins up to jMax, for use by amplitudes
+ *  that evaluate them for every event.  When the table is created, each reduced
+ *  d^j_mn(theta) is expanded into
+ *
+ *      d^j_mn(theta) = P(cos theta)                     for m+n even
+ *      d^j_mn(theta) = sin(theta) * P(cos theta)        for m+n odd
+ *
+ *  with P a polynomial of degree at most j, summed from the same series as
+ *  wignerDSmall.  Evaluating D is then a Horner sum and one complex phase.  The
+ *  result agrees with wignerD to better than 1e-12 for j <= 10; above that the
+ *  difference is mostly the rounding error of wignerDSmall, which grows faster than
+ *  that of the table.  Spins above jMax are passed on to wignerDSmall.  Instances
+ *  are shared, one per jMax, and are never deleted.
+ */
+
+#include <vector>
+#include <map>
+#include <complex>
+#include <math.h>
+#include <stdlib.h>
+
+#include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/wignerD.h"
+
+using std::complex;
+
+class WignerDTable {
+
+public:
+
+  // shared table for all spins j <= jMax, created on first use
+  static const WignerDTable* Get( int jMax );
+
+  int jMax() const { return mJMax; }
+
+  // same as wignerDSmall( j, m, n, theta ) with theta = acos( cosTheta ) in degrees,
+  // including 0 for |m| > j or |n| > j
+  inline GDouble d( int j, int m, int n, GDouble cosTheta ) const {
+    if( abs( m ) > j || abs( n ) > j ) return 0;
+    if( j > mJMax ) return wignerDSmall( j, m, n, acos( cosTheta ) * 180.0 / PI );
+    const Entry& e = mEntries[mFirst[j] + (m+j)*(2*j+1) + (n+j)];
+    const GDouble *c = &mCoefs[e.first];
+    GDouble p = c[e.degree];
+    for( int i = e.degree - 1; i >= 0; --i ) p = p * cosTheta + c[i];
+    if( e.sinTheta ) p *= sqrt( 1 - cosTheta * cosTheta );
+    return p;
+  }
+
+  // same as wignerD( j, m, n, cosTheta, phi )
+  inline complex< GDouble > D( int j, int m, int n, GDouble cosTheta, GDouble phi ) const {
+    GDouble dpart = d( j, m, n, cosTheta );
+    return complex< GDouble >( cos( -1.0 * m * phi ) * dpart,
+                               sin( -1.0 * m * phi ) * dpart );
+  }
+
+  // same as Y( l, m, cosTheta, phi )
+  inline complex< GDouble > Y( int l, int m, GDouble cosTheta, GDouble phi ) const {
+    return ( (GDouble)sqrt( (2*l+1) / (4*PI) ) ) * conj( D( l, m, 0, cosTheta, phi ) );
+  }
+
+private:
+
+  WignerDTable( int jMax );
+
+  struct Entry {
+    int first;      // index of the constant term in mCoefs
+    int degree;
+    bool sinTheta;  // true if P(cos theta) is multiplied by sin(theta)
+  };
+
+  int mJMax;
+  std::vector<int> mFirst;        // index in mEntries of (j, -j, -j)
+  std::vector<Entry> mEntries;    // indexed by (j, m, n)
+  std::vector<GDouble> mCoefs;    // polynomial coefficients, lowest power first
+};
+
+#endif
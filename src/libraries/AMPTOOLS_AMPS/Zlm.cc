@@ -5,16 +5,13 @@
 #include <sstream>
 #include <cstdlib>
 
-#include "TLorentzVector.h"
-#include "TLorentzRotation.h"
+#include "TMath.h"
 
 #include "IUAmpTools/Kinematics.h"
 #include "AMPTOOLS_AMPS/Zlm.h"
 #include "AMPTOOLS_AMPS/clebschGordan.h"
 #include "AMPTOOLS_AMPS/wignerD.h"
 
-#include "UTILITIES/BeamProperties.h"
-
 Zlm::Zlm( const vector< string >& args ) :
 UserAmplitude< Zlm >( args )
 {
@@ -31,10 +28,9 @@ UserAmplitude< Zlm >( args )
   polFraction = atof(args[5].c_str());
   
   // BeamProperties configuration file
+  beamPol = NULL;
   if (polFraction == 0){
-    TString beamConfigFile = args[5].c_str();
-    BeamProperties beamProp(beamConfigFile);
-    polFrac_vs_E = (TH1D*)beamProp.GetPolFrac();
+    beamPol = BeamPolarization::Get( args[5] );
   }
 
   // make sure values are reasonable
@@ -49,53 +45,96 @@ UserAmplitude< Zlm >( args )
 }
 
 
-complex< GDouble >
-Zlm::calcAmplitude( GDouble** pKin ) const {
-  
-  TLorentzVector beam   ( pKin[0][1], pKin[0][2], pKin[0][3], pKin[0][0] ); 
-  TLorentzVector recoil ( pKin[1][1], pKin[1][2], pKin[1][3], pKin[1][0] ); 
-  TLorentzVector p1     ( pKin[2][1], pKin[2][2], pKin[2][3], pKin[2][0] ); 
-  TLorentzVector p2     ( pKin[3][1], pKin[3][2], pKin[3][3], pKin[3][0] ); 
-  
-  TLorentzVector resonance = p1 + p2;
-  
-  TLorentzRotation resRestBoost( -resonance.BoostVector() );
-  
-  TLorentzVector beam_res   = resRestBoost * beam;
-  TLorentzVector recoil_res = resRestBoost * recoil;
-  TLorentzVector p1_res = resRestBoost * p1;
-  
-  // Helicity frame
-  TVector3 z = -1. * recoil_res.Vect().Unit();
-  // or GJ frame?
-  // TVector3 z = beam_res.Vect().Unit();
+void
+Zlm::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 
-  // normal to the production plane
-  TVector3 y = (beam.Vect().Unit().Cross(-recoil.Vect().Unit())).Unit();
+  // Same frame as before (helicity frame of p1+p2, y normal to the
+  // production plane), written out component by component rather
+  // than with TLorentzVector/TLorentzRotation: this is called for
+  // every event and every Zlm term when the data are loaded.
 
-  TVector3 x = y.Cross(z);
-  
-  TVector3 angles( (p1_res.Vect()).Dot(x),
-                   (p1_res.Vect()).Dot(y),
-                   (p1_res.Vect()).Dot(z) );
-  
-  GDouble cosTheta = angles.CosTheta();
-  GDouble phi = angles.Phi();
+  const GDouble* beam   = pKin[0];   // E, px, py, pz
+  const GDouble* recoil = pKin[1];
+  const GDouble* p1     = pKin[2];
+  const GDouble* p2     = pKin[3];
 
-  GDouble Pgamma;  
-  TVector3 eps(cos(polAngle*TMath::DegToRad()), sin(polAngle*TMath::DegToRad()), 0.0); // beam polarization vector
-  GDouble Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
-  
+  // boost to the resonance rest frame
+  GDouble resE = p1[0] + p2[0];
+  GDouble bx = -( p1[1] + p2[1] ) / resE;
+  GDouble by = -( p1[2] + p2[2] ) / resE;
+  GDouble bz = -( p1[3] + p2[3] ) / resE;
+  GDouble b2 = bx*bx + by*by + bz*bz;
+  GDouble gamma = 1. / sqrt( 1. - b2 );
+  GDouble gamma2 = ( b2 > 0 ? ( gamma - 1. ) / b2 : 0. );
+
+  GDouble bpRecoil = bx*recoil[1] + by*recoil[2] + bz*recoil[3];
+  GDouble fRecoil = gamma2*bpRecoil + gamma*recoil[0];
+  GDouble rx = recoil[1] + fRecoil*bx;
+  GDouble ry = recoil[2] + fRecoil*by;
+  GDouble rz = recoil[3] + fRecoil*bz;
+
+  GDouble bpP1 = bx*p1[1] + by*p1[2] + bz*p1[3];
+  GDouble fP1 = gamma2*bpP1 + gamma*p1[0];
+  GDouble ax = p1[1] + fP1*bx;
+  GDouble ay = p1[2] + fP1*by;
+  GDouble az = p1[3] + fP1*bz;
+
+  // helicity frame: z opposite to the recoil
+  GDouble rmag = sqrt( rx*rx + ry*ry + rz*rz );
+  GDouble zx = -rx/rmag, zy = -ry/rmag, zz = -rz/rmag;
+
+  // normal to the production plane, beam x (-recoil)
+  GDouble beamMag = sqrt( beam[1]*beam[1] + beam[2]*beam[2] + beam[3]*beam[3] );
+  GDouble ux = beam[1]/beamMag, uy = beam[2]/beamMag, uz = beam[3]/beamMag;
+  GDouble recoilMag = sqrt( recoil[1]*recoil[1] + recoil[2]*recoil[2] + recoil[3]*recoil[3] );
+  GDouble vx = -recoil[1]/recoilMag, vy = -recoil[2]/recoilMag, vz = -recoil[3]/recoilMag;
+  GDouble yx = uy*vz - uz*vy;
+  GDouble yy = uz*vx - ux*vz;
+  GDouble yz = ux*vy - uy*vx;
+  GDouble ymag = sqrt( yx*yx + yy*yy + yz*yz );
+  yx /= ymag; yy /= ymag; yz /= ymag;
+
+  GDouble xx = yy*zz - yz*zy;
+  GDouble xy = yz*zx - yx*zz;
+  GDouble xz = yx*zy - yy*zx;
+
+  GDouble px = ax*xx + ay*xy + az*xz;
+  GDouble py = ax*yx + ay*yy + az*yz;
+  GDouble pz = ax*zx + ay*zy + az*zz;
+  GDouble pmag = sqrt( px*px + py*py + pz*pz );
+
+  userVars[uv_cosTheta] = ( pmag > 0 ? pz/pmag : 1. );
+  userVars[uv_phi] = ( px == 0 && py == 0 ? 0. : atan2( py, px ) );
+
+  // Phi = atan2( y.eps, beam.(eps x y) ) = atan2( y.eps, (y x beam).eps )
+  // and eps lies in the x-y plane
+  userVars[uv_normX] = yx;
+  userVars[uv_normY] = yy;
+  userVars[uv_crossX] = yy*uz - yz*uy;
+  userVars[uv_crossY] = yz*ux - yx*uz;
+
+  GDouble Pgamma;
   if(polFraction > 0.) { // for fitting with constant polarization 
     Pgamma = polFraction;
   }
   else{
-    int bin = polFrac_vs_E->GetXaxis()->FindBin(pKin[0][0]);
-    if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-      Pgamma = 0.;
-    }
-    else Pgamma = polFrac_vs_E->GetBinContent(bin);
+    Pgamma = beamPol->Fraction( beam[0] );
   }
+  userVars[uv_Pgamma] = Pgamma;
+}
+
+
+complex< GDouble >
+Zlm::calcAmplitude( GDouble** pKin, GDouble* userVars ) const {
+  
+  GDouble cosTheta = userVars[uv_cosTheta];
+  GDouble phi = userVars[uv_phi];
+  GDouble Pgamma = userVars[uv_Pgamma];
+
+  GDouble cosEps = cos(polAngle*TMath::DegToRad());
+  GDouble sinEps = sin(polAngle*TMath::DegToRad());
+  GDouble Phi = atan2( userVars[uv_normX]*cosEps + userVars[uv_normY]*sinEps,
+                       userVars[uv_crossX]*cosEps + userVars[uv_crossY]*sinEps );
   
   GDouble Factor = sqrt(1 + m_s * Pgamma);
   GDouble zlm = 0;
@@ -107,4 +146,3 @@ Zlm::calcAmplitude( GDouble** pKin ) const {
 
   return complex< GDouble >( static_cast< GDouble>( Factor ) * zlm );
 }
-
@@ -5,8 +5,8 @@
 #include "IUAmpTools/UserAmplitude.h"
 #include "IUAmpTools/AmpParameter.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "UTILITIES/BeamPolarization.h"
 
-#include "TH1D.h"
 #include <string>
 #include <complex>
 #include <vector>
@@ -34,7 +34,22 @@ public:
 	
 	string name() const { return "Zlm"; }
     
-	complex< GDouble > calcAmplitude( GDouble** pKin ) const;
+	complex< GDouble > calcAmplitude( GDouble** pKin, GDouble* userVars ) const;
+
+	// The decay angles and beam polarization are the same for every
+	// Zlm term, and do not depend on the fit parameters, so they are
+	// computed once per event. The production-plane normal y and
+	// y x beam are kept (x and y components only) so that the angle
+	// Phi to the polarization vector can follow polAngle if it floats.
+	
+	enum UserVars { uv_cosTheta = 0, uv_phi = 1, uv_Pgamma = 2,
+	                uv_normX = 3, uv_normY = 4, uv_crossX = 5, uv_crossY = 6,
+	                kNumUserVars };
+	unsigned int numUserVars() const { return kNumUserVars; }
+	
+	void calcUserVars( GDouble** pKin, GDouble* userVars ) const;
+	
+	bool needsUserVarsOnly() const { return true; }
 	
 private:
         
@@ -46,7 +61,7 @@ private:
   AmpParameter polAngle;
 
   double polFraction;
-  TH1D *polFrac_vs_E;
+  BeamPolarization *beamPol;
 };
 
 #endif
@@ -13,8 +13,8 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "b1piAngAmp.h"
 #include "AMPTOOLS_AMPS/barrierFactor.h"
-#include "AMPTOOLS_AMPS/clebschGordan.h"
-#include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/ClebschGordanTable.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
 #include "AMPTOOLS_AMPS/breakupMomentum.h"
 
 b1piAngAmp::b1piAngAmp( const vector< string >& args ):
@@ -97,6 +97,11 @@ b1piAngAmp::b1piAngAmp( const vector< string >& args ):
   mIz[3]=Iz_b1;
   mIz[5]=-1;
   mIz[6]=+1;
+
+  // spins of the D-functions and couplings in calcAmplitude: J_X, L_X and L_b1 <= 2
+  int jMax = ( mL_X > 2 ? mL_X : 2 );
+  m_wignerD = WignerDTable::Get( jMax );
+  m_clebschGordan = ClebschGordanTable::Get( jMax );
 }
 
 void PrintHEPvector(TLorentzVector &v){
@@ -206,7 +211,7 @@ inline GDouble b1piAngAmp::CB(int j1, int j2, int m1, int m2, int J, int M) cons
    
   //printf("Resorting to clebschGordan(%3d,%3d,%3d,%3d,%3d,%3d)\n",
   //j1, j2, m1, m2, J, M);
-  return clebschGordan(j1, j2, m1, m2, J, M);
+  return m_clebschGordan->cg(j1, j2, m1, m2, J, M);
 }
 
 
@@ -445,11 +450,11 @@ b1piAngAmp::calcAmplitude( GDouble** pKin ) const
 			l_rho != List_l_rho.end() ; l_rho++){
 		      //shortcut CB(1,1,0,0;1,0)=0
 		      if(*L_omega==1 && *J_rho==1 && *l_rho==0) continue;
-		      l_rhoDepTerm+= conj(wignerD(1, *l_omega, *l_rho,
-						  rho_omegaRF_cosTheta, 
-						  rho_omegaRF_phi))*
+		      l_rhoDepTerm+= conj(m_wignerD->D(1, *l_omega, *l_rho,
+						       rho_omegaRF_cosTheta, 
+						       rho_omegaRF_phi))*
 			CB(*L_omega, *J_rho, 0, *l_rho, 1, *l_rho) *
-			Y(*J_rho, *l_rho, rhos_pip_rhoRF_cosTheta, rhos_pip_rhoRF_phi);
+			m_wignerD->Y(*J_rho, *l_rho, rhos_pip_rhoRF_cosTheta, rhos_pip_rhoRF_phi);
 		      
 		      IMLnum++;
 		    }
@@ -466,8 +471,8 @@ b1piAngAmp::calcAmplitude( GDouble** pKin ) const
 		
 		l_omegaDepTerm += 
 		  L_omegaDepTerm *
-		  conj(wignerD(1, *l_b1, *l_omega, omega_b1RF.CosTheta(), 
-			       omega_b1RF.Phi())) *
+		  conj(m_wignerD->D(1, *l_b1, *l_omega, omega_b1RF.CosTheta(), 
+			            omega_b1RF.Phi())) *
 		  CB(*L_b1, 1, 0, *l_omega, 1, *l_omega);
 	      }
 	      
@@ -479,7 +484,7 @@ b1piAngAmp::calcAmplitude( GDouble** pKin ) const
 	    
 	    l_b1DepTerm += 
 	      L_b1DepTerm * CB(mL_X, 1, 0, *l_b1, mJ_X, *l_b1)*
-	      conj(wignerD(mJ_X, m_X, *l_b1, ang_b1.CosTheta(), ang_b1.Phi()));
+	      conj(m_wignerD->D(mJ_X, m_X, *l_b1, ang_b1.CosTheta(), ang_b1.Phi()));
 	    
 	    
 	  }
@@ -12,6 +12,8 @@
 #include "TLorentzVector.h"
 
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
+#include "AMPTOOLS_AMPS/ClebschGordanTable.h"
 
 using std::complex;
 using namespace std;
@@ -71,6 +73,9 @@ private:
 
   vector< int > mIz;
 
+  const WignerDTable *m_wignerD;
+  const ClebschGordanTable *m_clebschGordan;
+
 #ifdef GPU_ACCELERATION
   
   void launchGPUKernel( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO ) const;
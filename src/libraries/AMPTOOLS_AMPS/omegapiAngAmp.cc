@@ -8,7 +8,6 @@
 #include <string>
 #include <sstream>
  #include "UTILITIES/CobremsGeneration.hh"
- #include "UTILITIES/BeamProperties.h"
 
 #include "TLorentzVector.h"
 #include "TLorentzRotation.h"
@@ -16,8 +15,8 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "omegapiAngAmp.h"
 #include "barrierFactor.h"
-#include "clebschGordan.h"
-#include "wignerD.h"
+#include "ClebschGordanTable.h"
+#include "WignerDTable.h"
 #include "breakupMomentum.h"
 #include "omegapiAngles.h"
 
@@ -30,6 +29,10 @@ TLorentzVector targetopi(0,0,0,0.938);
 
  double pararray[22];
 
+// D-functions and Clebsch-Gordan coefficients of the moments, all spins are <= 2
+static const WignerDTable *wignerDTable = WignerDTable::Get(2);
+static const ClebschGordanTable *cgTable = ClebschGordanTable::Get(2);
+
 //Create array of lmLM:
 int lmLM[25][4] = {{0,0,0,0}, {0,0,2,0}, {0,0,2,1}, {0,0,2,2}, {2,0,0,0}, {2,0,2,0}, {2,0,2,1}, {2,0,2,2}, {2,1,2,0}, {2,1,2,1}, {2,1,2,2}, {2,2,2,0}, {2,2,2,1}, {2,2,2,2}, {2,1,1,1}, {0,0,1,0}, {0,0,1,1}, {2,1,1,0}, {2,1,1,1}, {2,1,2,1}, {2,1,2,2}, {2,2,2,1}, {2,2,2,2}, {2,0,1,0}, {2,0,1,1}};
 
@@ -75,9 +78,9 @@ double hmoment(int alpha, vector<double> vector)
    double moment = 0.0;
   if (alpha < 15)
   {
-    moment = 0.5 * std::real(wignerD(L, M, m, loccostheta, locphi) * wignerD(l, m, 0, loccosthetaH, locphiH) + pow(-1.0,L+M) * wignerD(L, -M, m, loccostheta, locphi) * wignerD(l, m, 0, loccosthetaH, locphiH));
+    moment = 0.5 * std::real(wignerDTable->D(L, M, m, loccostheta, locphi) * wignerDTable->D(l, m, 0, loccosthetaH, locphiH) + pow(-1.0,L+M) * wignerDTable->D(L, -M, m, loccostheta, locphi) * wignerDTable->D(l, m, 0, loccosthetaH, locphiH));
   }
-  else {moment = 0.5 * std::real(wignerD(L, M, m, loccostheta, locphi) * wignerD(l, m, 0, loccosthetaH, locphiH) - pow(-1.0,L+M) * wignerD(L, -M, m, loccostheta, locphi) * wignerD(l, m, 0, loccosthetaH, locphiH));}
+  else {moment = 0.5 * std::real(wignerDTable->D(L, M, m, loccostheta, locphi) * wignerDTable->D(l, m, 0, loccosthetaH, locphiH) - pow(-1.0,L+M) * wignerDTable->D(L, -M, m, loccostheta, locphi) * wignerDTable->D(l, m, 0, loccosthetaH, locphiH));}
 
   return moment;
 }
@@ -90,20 +93,16 @@ omegapiAngAmp::omegapiAngAmp( const vector< string >& args ):
 	if(args.size() == 25){
 		polAngle  = atof(args[23].c_str() ); // azimuthal angle of the photon polarization vector in the lab measured in degrees.
 		polFraction = AmpParameter( args[24] ); // polarization fraction
+		beamPol = NULL;
 		std::cout << "Fixed polarization fraction =" << polFraction << " and pol.angle= " << polAngle << " degrees." << std::endl;
 	}
 	else if (args.size() == 24){
 		// BeamProperties configuration file
-		TString beamConfigFile = args[23].c_str();
-		BeamProperties beamProp(beamConfigFile);
-		polFrac_vs_E = (TH1D*)beamProp.GetPolFrac();
-		polAngle = beamProp.GetPolAngle();
+		beamPol = BeamPolarization::Get( args[23] );
+		polAngle = beamPol->GetPolAngle();
 		std::cout << "Polarisation angle of " << polAngle << " from BeamProperties." << std::endl;
 		if(polAngle == -1)
 			std::cout << "This is an amorphous run. Set beam polarisation to 0." << std::endl;
-		for(Int_t i=0; i<polFrac_vs_E->GetXaxis()->GetNbins()+2; i++){
-			//cout << polFrac_vs_E->GetBinContent(i) << endl;
-		}
 	}
 	else
 	assert(0);
@@ -240,7 +239,7 @@ double lsum(double x, double resonancemass, int ialpha, int lambda, double Dover
       c_alpha = 1;
     else 
       c_alpha = 0; 
-    lsum += TMath::Sqrt((2.0*l + 1.0)/(2.0*J_spin(ialpha) + 1.0)) * clebschGordan(l, 1, 0, lambda, J_spin(ialpha), lambda) * c_alpha * barrierratio(x, resonancemass, l);
+    lsum += TMath::Sqrt((2.0*l + 1.0)/(2.0*J_spin(ialpha) + 1.0)) * cgTable->cg(l, 1, 0, lambda, J_spin(ialpha), lambda) * c_alpha * barrierratio(x, resonancemass, l);
   }
   return lsum;
 }
@@ -258,7 +257,7 @@ std::complex<double> f_Llm(double x, double resonancemass, double resonancewidth
 	continue;
       if (ialpha == 2 && lambda != 0)
 	continue;
-      fsum += F_alpha_lambda(x, resonancemass, resonancewidth, G_alpha, ialpha, lambda, DoverS, l) * std::conj(F_alpha_lambda(x, resonancemass2, resonancewidth2, G_beta, ibeta, lambdaprime, DoverS, l)) * clebschGordan(J_spin(ibeta), L, lambdaprime, m, J_spin(ialpha), lambda) * clebschGordan(1, l, lambdaprime, m, 1, lambda);
+      fsum += F_alpha_lambda(x, resonancemass, resonancewidth, G_alpha, ialpha, lambda, DoverS, l) * std::conj(F_alpha_lambda(x, resonancemass2, resonancewidth2, G_beta, ibeta, lambdaprime, DoverS, l)) * cgTable->cg(J_spin(ibeta), L, lambdaprime, m, J_spin(ialpha), lambda) * cgTable->cg(1, l, lambdaprime, m, 1, lambda);
     }
   }
   return fsum;
@@ -333,7 +332,7 @@ std::complex<double> HelicitySum(double phi0, double theta, double phiplus, doub
 	continue;
       if (ibeta == 2 && iHPrime > 0)
 	continue;
-      sumH += rho(phi0, theta, phiplus, phiminus, psi, phi02, theta2, phiplus2, phiminus2, psi2, iH, iHPrime, ialpha, ibeta) * clebschGordan(J_spin(ibeta), L, Lambda_H(iHPrime), M, J_spin(ialpha), Lambda_H(iH));
+      sumH += rho(phi0, theta, phiplus, phiminus, psi, phi02, theta2, phiplus2, phiminus2, psi2, iH, iHPrime, ialpha, ibeta) * cgTable->cg(J_spin(ibeta), L, Lambda_H(iHPrime), M, J_spin(ialpha), Lambda_H(iH));
     }
   }
   
@@ -370,7 +369,7 @@ double SingleIntensity(double x, double *pararray, int l, int m, int L, int M, i
       psi_beta = pararray[5*ibeta + 14];
     }
 
-    single_intensity = std::real(t_star_LM(pararray[5*ialpha + 10], pararray[5*ialpha + 11], phiplus_alpha, phiminus_alpha, psi_alpha, pararray[5*ibeta + 10], pararray[5*ibeta + 11], phiplus_beta, phiminus_beta, psi_beta, ialpha, ibeta, L, M) * f_Llm(x, pararray[3*ialpha + 0], pararray[3*ialpha + 1], pararray[3*ialpha + 2], ialpha, pararray[3*ibeta + 0], pararray[3*ibeta + 1], pararray[3*ibeta + 2], ibeta, pararray[9], l, m, L) * clebschGordan(1, l, 0, 0, 1, 0));
+    single_intensity = std::real(t_star_LM(pararray[5*ialpha + 10], pararray[5*ialpha + 11], phiplus_alpha, phiminus_alpha, psi_alpha, pararray[5*ibeta + 10], pararray[5*ibeta + 11], phiplus_beta, phiminus_beta, psi_beta, ialpha, ibeta, L, M) * f_Llm(x, pararray[3*ialpha + 0], pararray[3*ialpha + 1], pararray[3*ialpha + 2], ialpha, pararray[3*ibeta + 0], pararray[3*ibeta + 1], pararray[3*ibeta + 2], ibeta, pararray[9], l, m, L) * cgTable->cg(1, l, 0, 0, 1, 0));
     //cout << "single intensity = " << single_intensity << endl;
 
   return single_intensity;
@@ -419,15 +418,8 @@ omegapiAngAmp::calcUserVars( GDouble** pKin, GDouble* userVars ) const {
 	GDouble Pgamma=polFraction;//fixed beam polarization fraction
 	if(polAngle == -1)
 	Pgamma = 0.;//if beam is amorphous set polarization fraction to 0
-	else if(polFrac_vs_E!=NULL){
-	int bin = polFrac_vs_E->GetXaxis()->FindBin(beam.E());
-
-	if (bin == 0 || bin > polFrac_vs_E->GetXaxis()->GetNbins()){
-		Pgamma = 0.;
-	}
-	else
-	 Pgamma = polFrac_vs_E->GetBinContent(bin);
-	}
+	else if(beamPol!=NULL)
+	Pgamma = beamPol->Fraction(beam.E());
    double mx = X.M();
 
   vector <double> locthetaphi = getomegapiAngles(polAngle, omega, X, beam, Gammap);
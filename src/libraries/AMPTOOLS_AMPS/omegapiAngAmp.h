@@ -15,6 +15,8 @@
 #include "TH1D.h"
 #include "TFile.h"
 
+#include "UTILITIES/BeamPolarization.h"
+
 #ifdef GPU_ACCELERATION
 void GPUomegapiAngAmp_exec( dim3 dimGrid, dim3 dimBlock, GPU_AMP_PROTO,
 			    GDouble m_1p, GDouble m_w_1p, GDouble m_n_1p, GDouble m_1m, GDouble m_w_1m, GDouble m_n_1m,
@@ -155,7 +157,7 @@ private:
   
   TH1D *totalFlux_vs_E;
   TH1D *polFlux_vs_E;
-  TH1D *polFrac_vs_E;
+  BeamPolarization *beamPol;
 
 };
 
@@ -16,8 +16,8 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "omegapi_amplitude.h"
 #include "barrierFactor.h"
-#include "clebschGordan.h"
-#include "wignerD.h"
+#include "ClebschGordanTable.h"
+#include "WignerDTable.h"
 #include "breakupMomentum.h"
 #include "omegapiAngles.h"
 
@@ -72,6 +72,14 @@ omegapi_amplitude::omegapi_amplitude( const vector< string >& args ):
    registerParameter(dalitz_gamma);
    registerParameter(dalitz_delta);
 
+   // the angular factors of calcAmplitude: D-functions up to the resonance spin and
+   // the omega helicity couplings, which only depend on the wave
+   int jMax = ( spin > l ? spin : l );
+   if( jMax < 1 ) jMax = 1;
+   m_wignerD = WignerDTable::Get( jMax );
+   const ClebschGordanTable *cgTable = ClebschGordanTable::Get( jMax );
+   for (int lambda = -1; lambda <= 1; lambda++)
+	   m_helAmp[lambda+1] = cgTable->cg(l, 1, 0, lambda, spin, lambda);
 }
 ////////////////////////////////////////////////// User Vars //////////////////////////////////
 void
@@ -171,8 +179,8 @@ omegapi_amplitude::calcAmplitude( GDouble** pKin, GDouble* userVars ) const
  
    for (int lambda = -1; lambda <= 1; lambda++)//omega helicity
 	      {
-		  GDouble hel_amp = clebschGordan(l, 1, 0, lambda, spin, lambda);
-		  amplitude += conj(wignerD( spin, spin_proj, lambda, cosTheta, Phi )) * hel_amp * conj(wignerD( 1, lambda, 0, cosThetaH, PhiH )) * G;
+		  GDouble hel_amp = m_helAmp[lambda+1];
+		  amplitude += conj(m_wignerD->D( spin, spin_proj, lambda, cosTheta, Phi )) * hel_amp * conj(m_wignerD->D( 1, lambda, 0, cosThetaH, PhiH )) * G;
 		}//loop over lambda
 		
    // multiply by square root of photon spin density matrix in helicity basis
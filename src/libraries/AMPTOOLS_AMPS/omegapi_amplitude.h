@@ -6,6 +6,7 @@
 #include "IUAmpTools/AmpParameter.h"
 #include "IUAmpTools/UserAmplitude.h"
 #include "GPUManager/GPUCustomTypes.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
 
 #include <string>
 #include <complex>
@@ -81,6 +82,9 @@ private:
   int spin_proj;
   int l;
   int nat_sign;
+
+  const WignerDTable *m_wignerD;
+  GDouble m_helAmp[3];  // clebschGordan(l, 1, 0, lambda, spin, lambda) for lambda = -1, 0, 1
 	AmpParameter dalitz_alpha;
 	AmpParameter dalitz_beta;
 	AmpParameter dalitz_gamma;
@@ -4,6 +4,7 @@
 #include <cassert>
 
 #include "AMPTOOLS_MCGEN/BreitWignerGenerator.h"
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
 
 const double BreitWignerGenerator::kPi = 3.14159;
 
@@ -61,5 +62,5 @@ BreitWignerGenerator::pdf( double s ) const {
 double
 BreitWignerGenerator::random( double low, double hi ) const {
 	
-	return( ( hi - low ) * drand48() + low );
+	return( ( hi - low ) * generatorRandom()->Uniform() + low );
 }
@@ -5,6 +5,7 @@
 #include <cassert>
 
 #include "AMPTOOLS_MCGEN/DecayChannelGenerator.h"
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
 
 DecayChannelGenerator::DecayChannelGenerator() :
 m_bfTotal( 0 ),
@@ -60,7 +61,7 @@ DecayChannelGenerator::operator()(){
         m_probRenormalized = true;
     }
     
-    double rand = drand48();
+    double rand = generatorRandom()->Uniform();
     for( unsigned int i = 0; i < m_upperBound.size(); ++i ){
         
         if( rand < m_upperBound[i] ){
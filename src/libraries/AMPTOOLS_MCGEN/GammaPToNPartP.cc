@@ -12,6 +12,7 @@
 #include "NBodyPhaseSpaceFactory.h"
 #include "TLorentzVector.h"
 #include "IUAmpTools/Kinematics.h"
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
 
 #include "UTILITIES/BeamProperties.h"
 
@@ -46,6 +47,9 @@ GammaPToNPartP::GammaPToNPartP( float lowMass, float highMass,
   BeamProperties beamProp(beamConfigFile);
   cobrem_vs_E = (TH1D*)beamProp.GetFlux();
   cobrem_vs_E->GetName();
+  // fill the cumulative integral now, so that copies of this generator can
+  // sample the beam energy on several threads at once
+  cobrem_vs_E->GetIntegral();
 
 }
 
@@ -57,7 +61,7 @@ GammaPToNPartP::GammaPToNPartP( float lowMass, float highMass,
 Kinematics* 
 GammaPToNPartP::generate(){
 
-  double beamE = cobrem_vs_E->GetRandom();
+  double beamE = randomFromHistogram( cobrem_vs_E );
   m_beam.SetPxPyPzE(0,0,beamE,beamE);
 
   TLorentzVector resonance;
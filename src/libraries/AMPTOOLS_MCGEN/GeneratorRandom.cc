@@ -0,0 +1,46 @@
+
+#include <pthread.h>
+
+#include "TMath.h"
+
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
+
+static pthread_key_t threadRandomKey;
+static pthread_once_t threadRandomOnce = PTHREAD_ONCE_INIT;
+
+static void makeThreadRandomKey(){
+
+  pthread_key_create( &threadRandomKey, NULL );
+}
+
+TRandom*
+generatorRandom(){
+
+  pthread_once( &threadRandomOnce, makeThreadRandomKey );
+  TRandom* rand = (TRandom*)pthread_getspecific( threadRandomKey );
+  return( rand ? rand : gRandom );
+}
+
+void
+setThreadRandom( TRandom* rand ){
+
+  pthread_once( &threadRandomOnce, makeThreadRandomKey );
+  pthread_setspecific( threadRandomKey, rand );
+}
+
+double
+randomFromHistogram( TH1* hist ){
+
+  int nbins = hist->GetNbinsX();
+  double* integral = hist->GetIntegral();
+  if( integral[nbins] == 0 ) return 0;
+
+  double r1 = generatorRandom()->Rndm();
+  int ibin = TMath::BinarySearch( nbins, integral, r1 );
+  double x = hist->GetBinLowEdge( ibin+1 );
+  if( r1 > integral[ibin] )
+    x += hist->GetBinWidth( ibin+1 ) * ( r1 - integral[ibin] ) /
+      ( integral[ibin+1] - integral[ibin] );
+
+  return x;
+}
@@ -0,0 +1,24 @@
+#if !defined(GENERATORRANDOM)
+#define GENERATORRANDOM
+
+#include "TRandom.h"
+#include "TH1.h"
+
+/*
+ *  Random number generator used by the MC generation classes.  This is
+ *  ROOT's gRandom unless the calling thread has installed a generator of
+ *  its own with setThreadRandom, which allows several threads to generate
+ *  events at the same time, each from an independent, reproducible stream.
+ */
+
+TRandom* generatorRandom();
+
+// install rand as the generator of the calling thread (NULL restores gRandom);
+// the caller keeps ownership
+void setThreadRandom( TRandom* rand );
+
+// same as hist->GetRandom(), drawing from generatorRandom(); the integral
+// of hist must not change once events are generated on several threads
+double randomFromHistogram( TH1* hist );
+
+#endif
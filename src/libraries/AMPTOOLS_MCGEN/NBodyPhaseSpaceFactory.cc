@@ -18,6 +18,7 @@
 #include "TMath.h"
 
 #include "AMPTOOLS_MCGEN/NBodyPhaseSpaceFactory.h"
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
 
 const double NBodyPhaseSpaceFactory::kPi = 3.14159;
 
@@ -120,5 +121,5 @@ NBodyPhaseSpaceFactory::pdk( double a, double b, double c ) const {
 double
 NBodyPhaseSpaceFactory::random( double low, double hi ) const {
 	
-  return( ( hi - low ) * gRandom->Uniform() + low );
+  return( ( hi - low ) * generatorRandom()->Uniform() + low );
 }
@@ -0,0 +1,519 @@
+// Calibration snapshot file: reader, generator and writer
+//
+// See JCalibrationSnapshot.h for a description.
+//
+// File layout (native byte order, recorded in the header):
+//
+//    header       snapshot_header_t
+//    payload      context, source URL, then for each table:
+//                    namepath
+//                    uint32 mask of the forms stored (bit = form_t)
+//                    each stored form in form_t order
+//
+// Strings are a uint32 length followed by the characters. The forms
+// are encoded as
+//
+//    kKeyValue    uint32 n, n x (key, value)
+//    kVector      uint32 n, n x value
+//    kRows        uint32 nrows, nrows x (uint32 n, n x (key, value))
+//    kRowVectors  uint32 nrows, nrows x (uint32 n, n x value)
+//
+// The checksum is the 64 bit FNV-1a hash of the payload.
+
+#include "JCalibrationSnapshot.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iostream>
+#include <set>
+
+#include <JANA/JException.h>
+
+static const char snapshot_magic[8] = {'H','D','C','A','L','S','N','P'};
+static const uint32_t snapshot_version = 1;
+static const uint32_t snapshot_byte_order = 0x01020304;
+
+struct snapshot_header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	int32_t run;
+	uint32_t ntables;
+	uint64_t payload_size;
+	uint64_t checksum;
+};
+
+static const string snapshot_url_prefix = "snapshot://";
+
+//-----------
+// SnapshotChecksum
+//-----------
+static uint64_t SnapshotChecksum(const char *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+//-----------
+// NormalizeNamepath
+//-----------
+static string NormalizeNamepath(const string &namepath)
+{
+	// The database accepts namepaths with or without a leading slash
+	// and callers use both, so they are stored without it.
+	size_t start = namepath.find_first_not_of('/');
+	return (start == string::npos)? string() : namepath.substr(start);
+}
+
+//-----------
+// SnapshotReader
+//-----------
+// Bounds-checked decoding of the payload. Once a read runs past the
+// end of the mapped data ok() stays false and all reads return empty.
+class SnapshotReader {
+	public:
+		SnapshotReader(const char *in_ptr, const char *in_end)
+			: ptr(in_ptr), end(in_end), good(true) {}
+
+		bool ok(void) const {return good;}
+		const char *pos(void) const {return ptr;}
+
+		uint32_t u32(void) {
+			uint32_t val = 0;
+			if (!good || (size_t)(end - ptr) < sizeof(val)) {
+				good = false;
+				return 0;
+			}
+			memcpy(&val, ptr, sizeof(val));
+			ptr += sizeof(val);
+			return val;
+		}
+
+		string str(void) {
+			uint32_t len = u32();
+			if (!good || (size_t)(end - ptr) < len) {
+				good = false;
+				return string();
+			}
+			string val(ptr, len);
+			ptr += len;
+			return val;
+		}
+
+		void skip_str(void) {
+			uint32_t len = u32();
+			if (!good || (size_t)(end - ptr) < len) {
+				good = false;
+				return;
+			}
+			ptr += len;
+		}
+
+		void skip_form(int form) {
+			uint32_t n = u32();
+			for (uint32_t i = 0; i < n && good; ++i) {
+				switch (form) {
+					case JCalibrationSnapshot::kKeyValue:
+						skip_str();
+						skip_str();
+						break;
+					case JCalibrationSnapshot::kVector:
+						skip_str();
+						break;
+					case JCalibrationSnapshot::kRows: {
+						uint32_t ncols = u32();
+						for (uint32_t j = 0; j < ncols && good; ++j) {
+							skip_str();
+							skip_str();
+						}
+						break;
+					}
+					case JCalibrationSnapshot::kRowVectors: {
+						uint32_t ncols = u32();
+						for (uint32_t j = 0; j < ncols && good; ++j)
+							skip_str();
+						break;
+					}
+				}
+			}
+		}
+
+	private:
+		const char *ptr;
+		const char *end;
+		bool good;
+};
+
+//-----------
+// SnapshotWriter
+//-----------
+class SnapshotWriter {
+	public:
+		string buffer;
+
+		void u32(uint32_t val) {
+			buffer.append((const char*)&val, sizeof(val));
+		}
+
+		void str(const string &val) {
+			u32(val.size());
+			buffer.append(val);
+		}
+
+		void form(const map<string, string> &svals) {
+			u32(svals.size());
+			for (map<string, string>::const_iterator iter = svals.begin(); iter != svals.end(); ++iter) {
+				str(iter->first);
+				str(iter->second);
+			}
+		}
+
+		void form(const vector<string> &svals) {
+			u32(svals.size());
+			for (size_t i = 0; i < svals.size(); ++i)
+				str(svals[i]);
+		}
+
+		void form(const vector< map<string, string> > &svals) {
+			u32(svals.size());
+			for (size_t i = 0; i < svals.size(); ++i)
+				form(svals[i]);
+		}
+
+		void form(const vector< vector<string> > &svals) {
+			u32(svals.size());
+			for (size_t i = 0; i < svals.size(); ++i)
+				form(svals[i]);
+		}
+};
+
+
+//-----------
+// JCalibrationSnapshot (constructor)
+//-----------
+JCalibrationSnapshot::JCalibrationSnapshot(string url, int32_t run, string context)
+	: JCalibration(url, run, context), fd(-1), mapped(NULL), mapped_size(0),
+	  snapshot_run(0), snapshot_ntables(0)
+{
+	string filename = url.substr(snapshot_url_prefix.size());
+	string error = Open(filename);
+	if (error.empty() && snapshot_run != run) {
+		error = "was made for run " + to_string(snapshot_run) + ", not for run " + to_string(run);
+	}
+	if (!error.empty()) {
+		Close();
+		throw JException("JCalibrationSnapshot: " + filename + " " + error);
+	}
+
+	if (snapshot_context != context) {
+		cerr << "JCalibrationSnapshot: warning, " << filename << " was made with context \""
+		     << snapshot_context << "\" but the context is now \"" << context << "\"" << endl;
+	}
+	cout << "Using calibration snapshot " << filename << " for run " << snapshot_run
+	     << " (" << snapshot_ntables << " tables from " << snapshot_source << ")" << endl;
+}
+
+//-----------
+// JCalibrationSnapshot (destructor)
+//-----------
+JCalibrationSnapshot::~JCalibrationSnapshot()
+{
+	Close();
+}
+
+//-----------
+// Open
+//-----------
+string JCalibrationSnapshot::Open(string filename)
+{
+	/// Map the snapshot file, check it and index its tables. Returns
+	/// an empty string on success and the reason otherwise.
+
+	fd = open(filename.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+		return "could not be opened";
+	mapped_size = st.st_size;
+	if (mapped_size < sizeof(snapshot_header_t))
+		return "is not a calibration snapshot";
+	void *addr = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED)
+		return "could not be mapped";
+	mapped = (const char*)addr;
+
+	snapshot_header_t header;
+	memcpy(&header, mapped, sizeof(header));
+	if (memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0)
+		return "is not a calibration snapshot";
+	if (header.version != snapshot_version || header.byte_order != snapshot_byte_order)
+		return "was written in an incompatible format";
+	const char *payload = mapped + sizeof(header);
+	if (header.payload_size != mapped_size - sizeof(header) ||
+	    SnapshotChecksum(payload, header.payload_size) != header.checksum)
+		return "is truncated or corrupted (checksum mismatch)";
+
+	// Only the start of each form is recorded here, the strings
+	// are decoded when a table is requested.
+	SnapshotReader reader(payload, payload + header.payload_size);
+	snapshot_context = reader.str();
+	snapshot_source = reader.str();
+	for (uint32_t i = 0; i < header.ntables && reader.ok(); ++i) {
+		string namepath = reader.str();
+		uint32_t mask = reader.u32();
+		for (int form = 0; form < kNforms; ++form) {
+			if (mask & (1 << form)) {
+				tables[form][namepath] = reader.pos();
+				reader.skip_form(form);
+			}
+		}
+	}
+	if (!reader.ok())
+		return "has an inconsistent table index";
+	snapshot_run = header.run;
+	snapshot_ntables = header.ntables;
+	return "";
+}
+
+//-----------
+// Close
+//-----------
+void JCalibrationSnapshot::Close(void)
+{
+	if (mapped)
+		munmap((void*)mapped, mapped_size);
+	if (fd >= 0)
+		close(fd);
+	mapped = NULL;
+	fd = -1;
+}
+
+//-----------
+// FindForm
+//-----------
+const char *JCalibrationSnapshot::FindForm(string namepath, form_t form)
+{
+	// A table the database could not return in this form is an error
+	// for the caller either way. A table missing altogether usually
+	// means it was left out of the list the snapshot was made from; it
+	// is not looked up in the database instead (see the header).
+	string key = NormalizeNamepath(namepath);
+	map<string, const char*>::iterator iter = tables[form].find(key);
+	if (iter != tables[form].end())
+		return iter->second;
+	for (int other = 0; other < kNforms; ++other) {
+		if (tables[other].count(key) > 0)
+			return NULL;
+	}
+	cerr << "JCalibrationSnapshot: table " << namepath << " is not in the snapshot" << endl;
+	return NULL;
+}
+
+//-----------
+// GetCalib
+//-----------
+bool JCalibrationSnapshot::GetCalib(string namepath, map<string, string> &svals, uint64_t event_number)
+{
+	const char *start = FindForm(namepath, kKeyValue);
+	if (start == NULL)
+		return true;
+	SnapshotReader reader(start, mapped + mapped_size);
+	svals.clear();
+	uint32_t n = reader.u32();
+	for (uint32_t i = 0; i < n; ++i) {
+		string key = reader.str();
+		svals[key] = reader.str();
+	}
+	return false;
+}
+
+//-----------
+// GetCalib
+//-----------
+bool JCalibrationSnapshot::GetCalib(string namepath, vector<string> &svals, uint64_t event_number)
+{
+	const char *start = FindForm(namepath, kVector);
+	if (start == NULL)
+		return true;
+	SnapshotReader reader(start, mapped + mapped_size);
+	uint32_t n = reader.u32();
+	svals.resize(n);
+	for (uint32_t i = 0; i < n; ++i)
+		svals[i] = reader.str();
+	return false;
+}
+
+//-----------
+// GetCalib
+//-----------
+bool JCalibrationSnapshot::GetCalib(string namepath, vector< map<string, string> > &svals, uint64_t event_number)
+{
+	const char *start = FindForm(namepath, kRows);
+	if (start == NULL)
+		return true;
+	SnapshotReader reader(start, mapped + mapped_size);
+	uint32_t nrows = reader.u32();
+	svals.clear();
+	svals.resize(nrows);
+	for (uint32_t i = 0; i < nrows; ++i) {
+		uint32_t n = reader.u32();
+		for (uint32_t j = 0; j < n; ++j) {
+			string key = reader.str();
+			svals[i][key] = reader.str();
+		}
+	}
+	return false;
+}
+
+//-----------
+// GetCalib
+//-----------
+bool JCalibrationSnapshot::GetCalib(string namepath, vector< vector<string> > &svals, uint64_t event_number)
+{
+	const char *start = FindForm(namepath, kRowVectors);
+	if (start == NULL)
+		return true;
+	SnapshotReader reader(start, mapped + mapped_size);
+	uint32_t nrows = reader.u32();
+	svals.resize(nrows);
+	for (uint32_t i = 0; i < nrows; ++i) {
+		uint32_t n = reader.u32();
+		svals[i].resize(n);
+		for (uint32_t j = 0; j < n; ++j)
+			svals[i][j] = reader.str();
+	}
+	return false;
+}
+
+//-----------
+// GetListOfNamepaths
+//-----------
+void JCalibrationSnapshot::GetListOfNamepaths(vector<string> &namepaths)
+{
+	set<string> names;
+	for (int form = 0; form < kNforms; ++form) {
+		for (map<string, const char*>::iterator iter = tables[form].begin(); iter != tables[form].end(); ++iter)
+			names.insert(iter->first);
+	}
+	namepaths.assign(names.begin(), names.end());
+}
+
+
+//-----------
+// CheckOpenable
+//-----------
+double JCalibrationGeneratorSnapshot::CheckOpenable(string url, int32_t run, string context)
+{
+	return (url.find(snapshot_url_prefix) == 0)? 1.0 : 0.0;
+}
+
+//-----------
+// MakeJCalibration
+//-----------
+JCalibration* JCalibrationGeneratorSnapshot::MakeJCalibration(string url, int32_t run, string context)
+{
+	return new JCalibrationSnapshot(url, run, context);
+}
+
+
+//-----------
+// WriteCalibSnapshot
+//-----------
+int WriteCalibSnapshot(JCalibration *jcalib, const vector<string> &namepaths,
+                       string filename, string &error)
+{
+	SnapshotWriter writer;
+	writer.str(jcalib->GetContext());
+	writer.str(jcalib->GetURL());
+
+	// Every table is fetched in each of the forms a caller may ask for,
+	// and stored in the forms the database was able to return.
+	set<string> written;
+	uint32_t ntables = 0;
+	for (size_t i = 0; i < namepaths.size(); ++i) {
+		string namepath = NormalizeNamepath(namepaths[i]);
+		if (namepath.empty() || written.count(namepath) > 0)
+			continue;
+		written.insert(namepath);
+
+		map<string, string> keyvalue;
+		vector<string> values;
+		vector< map<string, string> > rows;
+		vector< vector<string> > rowvectors;
+		uint32_t mask = 0;
+		if (!jcalib->GetCalib(namepath, keyvalue))
+			mask |= 1 << JCalibrationSnapshot::kKeyValue;
+		if (!jcalib->GetCalib(namepath, values))
+			mask |= 1 << JCalibrationSnapshot::kVector;
+		if (!jcalib->GetCalib(namepath, rows))
+			mask |= 1 << JCalibrationSnapshot::kRows;
+		if (!jcalib->GetCalib(namepath, rowvectors))
+			mask |= 1 << JCalibrationSnapshot::kRowVectors;
+		if (mask == 0) {
+			cerr << "WriteCalibSnapshot: table " << namepath << " not found, skipping" << endl;
+			continue;
+		}
+
+		writer.str(namepath);
+		writer.u32(mask);
+		if (mask & (1 << JCalibrationSnapshot::kKeyValue))
+			writer.form(keyvalue);
+		if (mask & (1 << JCalibrationSnapshot::kVector))
+			writer.form(values);
+		if (mask & (1 << JCalibrationSnapshot::kRows))
+			writer.form(rows);
+		if (mask & (1 << JCalibrationSnapshot::kRowVectors))
+			writer.form(rowvectors);
+		++ntables;
+	}
+
+	snapshot_header_t header;
+	memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+	header.version = snapshot_version;
+	header.byte_order = snapshot_byte_order;
+	header.run = jcalib->GetRun();
+	header.ntables = ntables;
+	header.payload_size = writer.buffer.size();
+	header.checksum = SnapshotChecksum(writer.buffer.data(), writer.buffer.size());
+
+	// Write to a temporary name first so that a reader never maps a
+	// partially written snapshot.
+	string tmpname = filename + ".tmp";
+	ofstream ofs(tmpname.c_str(), ios::binary);
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write(writer.buffer.data(), writer.buffer.size());
+	ofs.close();
+	if (!ofs) {
+		error = "write failed to " + tmpname;
+		unlink(tmpname.c_str());
+		return -1;
+	}
+	if (rename(tmpname.c_str(), filename.c_str()) != 0) {
+		error = "unable to rename " + tmpname + " to " + filename;
+		return -1;
+	}
+	return ntables;
+}
+
+//-----------
+// WriteCalibAccessList
+//-----------
+bool WriteCalibAccessList(JCalibration *jcalib, string filename)
+{
+	map<string, vector<string> > accesses;
+	jcalib->GetAccesses(accesses);
+
+	ofstream ofs(filename.c_str(), ios::app);
+	for (map<string, vector<string> >::iterator iter = accesses.begin(); iter != accesses.end(); ++iter)
+		ofs << iter->first << endl;
+	ofs.close();
+	return !ofs.fail();
+}
@@ -0,0 +1,94 @@
+// JCalibrationSnapshot
+//
+// Calibration source that serves tables from a single binary snapshot
+// file instead of the calibration database. The snapshot is written by
+// the calib_snapshot program (see WriteCalibSnapshot below) for one run
+// number and context, and selected at run time with
+//
+//    JANA_CALIB_URL=snapshot:///path/to/file.snap
+//
+// once JCalibrationGeneratorSnapshot has been added to the application.
+// The file is memory-mapped and its checksum verified when it is opened.
+// The tables are kept as the strings the database returned for each
+// kind of request, so the values the callers get are identical to the
+// ones they would have read from the database.
+//
+// A table that is not in the snapshot is reported as not found, the same
+// as the database reports a table it does not have, and a message naming
+// it is printed. There is deliberately no fallback to the database: a
+// snapshot is used where the database cannot be reached, and a job run
+// from it should only ever see the constants it contains. Add the missing
+// table to the list and make the snapshot again.
+
+#ifndef _JCalibrationSnapshot_
+#define _JCalibrationSnapshot_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <JANA/JCalibration.h>
+#include <JANA/JCalibrationGenerator.h>
+
+using namespace std;
+using namespace jana;
+
+class JCalibrationSnapshot : public JCalibration {
+	public:
+		JCalibrationSnapshot(string url, int32_t run, string context="default");
+		virtual ~JCalibrationSnapshot();
+
+		bool GetCalib(string namepath, map<string, string> &svals, uint64_t event_number=0);
+		bool GetCalib(string namepath, vector<string> &svals, uint64_t event_number=0);
+		bool GetCalib(string namepath, vector< map<string, string> > &svals, uint64_t event_number=0);
+		bool GetCalib(string namepath, vector< vector<string> > &svals, uint64_t event_number=0);
+		void GetListOfNamepaths(vector<string> &namepaths);
+
+		int32_t GetSnapshotRun(void) const {return snapshot_run;}
+		const string& GetSnapshotSource(void) const {return snapshot_source;}
+
+		// Form in which a table was requested. A table is stored once
+		// for every form the database could return it in.
+		enum form_t {
+			kKeyValue   = 0,   // map<string,string>
+			kVector     = 1,   // vector<string>
+			kRows       = 2,   // vector< map<string,string> >
+			kRowVectors = 3,   // vector< vector<string> >
+			kNforms     = 4
+		};
+
+	private:
+		string Open(string filename);
+		void Close(void);
+		const char *FindForm(string namepath, form_t form);
+
+		int fd;
+		const char *mapped;
+		size_t mapped_size;
+		int32_t snapshot_run;
+		uint32_t snapshot_ntables;
+		string snapshot_context;
+		string snapshot_source;
+		map<string, const char*> tables[kNforms];
+};
+
+class JCalibrationGeneratorSnapshot : public JCalibrationGenerator {
+	public:
+		const char* Description(void){return "Calibration snapshot file (snapshot://)";}
+		double CheckOpenable(string url, int32_t run, string context);
+		JCalibration* MakeJCalibration(string url, int32_t run, string context);
+};
+
+// Write the tables listed in namepaths, as returned by jcalib, to a
+// snapshot file. Returns the number of tables written, or -1 on error
+// with the reason in error.
+int WriteCalibSnapshot(JCalibration *jcalib, const vector<string> &namepaths,
+                       string filename, string &error);
+
+// Append the namepaths requested so far from jcalib to the list file
+// filename, one per line, in the format read by calib_snapshot.
+bool WriteCalibAccessList(JCalibration *jcalib, string filename);
+
+#endif // _JCalibrationSnapshot_
@@ -0,0 +1,58 @@
+/*
+ *  BeamPolarization.cc
+ *
+ *  Process-wide lookup of the photon beam polarization fraction vs. energy.
+ *  See BeamPolarization.h for a description.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <algorithm>
+
+#include "BeamPolarization.h"
+
+using namespace std;
+
+std::map< std::string, BeamPolarization* > BeamPolarization::mInstances;
+
+static pthread_mutex_t instancesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+BeamPolarization* BeamPolarization::Get( const std::string& configFile ) {
+
+	// instances are never deleted, so the pointer stays valid for the life of the process
+	pthread_mutex_lock(&instancesMutex);
+	BeamPolarization *beamPol = mInstances[configFile];
+	if(!beamPol) {
+		beamPol = new BeamPolarization(configFile);
+		mInstances[configFile] = beamPol;
+	}
+	pthread_mutex_unlock(&instancesMutex);
+
+	return beamPol;
+}
+
+BeamPolarization::BeamPolarization( const std::string& configFile ) :
+	mBeamProp(configFile.c_str()) {
+
+	TH1D *polFrac = mBeamProp.GetPolFrac();
+	TAxis *axis = polFrac->GetXaxis();
+	mNbins = axis->GetNbins();
+	mLow = axis->GetXmin();
+	mWidth = axis->GetXmax() - axis->GetXmin();
+
+	// same convention as TAxis::FindBin, with the under- and overflow bins read as zero
+	mUniform = (axis->GetXbins()->GetSize() == 0);
+	if(!mUniform) {
+		for(int i=1; i<=mNbins+1; i++)
+			mEdges.push_back(axis->GetBinLowEdge(i));
+	}
+	mTable.assign(mNbins+2, 0.);
+	for(int i=1; i<=mNbins; i++)
+		mTable[i] = polFrac->GetBinContent(i);
+}
+
+int BeamPolarization::findBin( double Egamma ) const {
+
+	// number of edges at or below Egamma, which is the bin number
+	return upper_bound(mEdges.begin(), mEdges.end(), Egamma) - mEdges.begin();
+}
@@ -0,0 +1,57 @@
+#if !defined(BEAMPOLARIZATION)
+#define BEAMPOLARIZATION
+
+/*
+ *  BeamPolarization.h
+ *
+ *  Process-wide lookup of the photon beam polarization fraction vs. energy, for use by
+ *  amplitudes.  There is one instance per beam configuration file, shared by every
+ *  amplitude and reaction that names it.  The polarization histogram from BeamProperties
+ *  is copied into a flat table when the instance is created, so that Fraction() needs
+ *  no ROOT calls in the event loop and is safe to call from any thread.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <math.h>
+
+#include "BeamProperties.h"
+
+class BeamPolarization {
+
+public:
+
+  // shared instance for this configuration file, created on first use
+  static BeamPolarization* Get( const std::string& configFile );
+
+  // polarization fraction at photon energy Egamma, 0 outside the histogram range
+  inline double Fraction( double Egamma ) const {
+    if( mUniform ) {
+      double t = mNbins * (Egamma - mLow) / mWidth;
+      t = (t < -1) ? -1 : t;
+      t = (t > mNbins) ? mNbins : t;
+      return mTable[1 + (int)floor(t)];
+    }
+    return mTable[findBin(Egamma)];
+  }
+
+  double GetPolAngle() { return mBeamProp.GetPolAngle(); }
+
+private:
+
+  BeamPolarization( const std::string& configFile );
+  int findBin( double Egamma ) const;
+
+  BeamProperties mBeamProp;
+
+  bool mUniform;
+  int mNbins;
+  double mLow, mWidth;
+  std::vector<double> mEdges;  // bin edges, for histograms with variable bins
+  std::vector<double> mTable;  // bin contents including under/overflow, which are 0
+
+  static std::map< std::string, BeamPolarization* > mInstances;
+};
+
+#endif
@@ -5,14 +5,22 @@
  *  of beam properties is from CombremsGeneration, external ROOT file or CCDB (to be implemented). 
  *
  *  Created by Justin Stevens on 12/29/17
+ *
+ *  All instances built from the same configuration share one pair of histograms.  The
+ *  CobremsGeneration spectra can also be cached on disk, in the directory named by the
+ *  environment variable BEAMPROPERTIES_CACHE, so that later jobs with the same beam
+ *  parameters read them back instead of recomputing them.
  */
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <stdlib.h>
 
 #include "TROOT.h"
 #include "TFile.h"
+#include "TNamed.h"
+#include "TSystem.h"
 
 #include "BeamProperties.h"
 #include "CobremsGeneration.hh"
@@ -20,23 +28,37 @@
 using namespace ccdb;
 using namespace std;
 
+std::map< std::string, std::pair<TH1D*,TH1D*> > BeamProperties::mRegistry;
+
 BeamProperties::BeamProperties( TString configFile ) {
 
-	// check if histograms already exist before re-creating
+	fluxVsEgamma = 0;
+	polFracVsEgamma = 0;
 	gDirectory->cd("/");
-	fluxVsEgamma = (TH1D*)gDirectory->Get("BeamProperties_FluxVsEgamma");
-	polFracVsEgamma = (TH1D*)gDirectory->Get("BeamProperties_PolFracVsEgamma");
-	if(!fluxVsEgamma || !polFracVsEgamma) 
-		createHistograms(configFile);
-}
-
-void BeamProperties::createHistograms( TString configFile ) {
 
 	// First parse configuration file
 	mConfigFile = configFile;
 	bool isParsed = parseConfig();
 	if(!isParsed) exit(1);
 
+	// check if histograms already exist for this configuration before re-creating
+	std::string key = configKey();
+	std::map< std::string, std::pair<TH1D*,TH1D*> >::iterator iter = mRegistry.find(key);
+	if(iter != mRegistry.end()) {
+		fluxVsEgamma = iter->second.first;
+		polFracVsEgamma = iter->second.second;
+		return;
+	}
+
+	// histograms for a second configuration need their own names
+	if(!mRegistry.empty())
+		mNameSuffix.Form("_%d", (int)mRegistry.size());
+	createHistograms();
+	mRegistry[key] = std::make_pair(fluxVsEgamma, polFracVsEgamma);
+}
+
+void BeamProperties::createHistograms() {
+
 	// Fill flux histogram based on config file
 	if(mIsCCDBFlux) 
 		fillFluxFromCCDB();
@@ -135,6 +157,24 @@ bool BeamProperties::parseConfig(){
 	return true;
 }
 
+// canonical form of the parsed configuration, independent of ordering, spacing and comments
+std::string BeamProperties::configKey(){
+
+	std::ostringstream key;
+	key.precision(17);
+	key << mIsCCDBFlux << mIsCCDBPol << mIsROOTFlux << mIsROOTPol << mIsPolFixed;
+	if(mIsCCDBFlux || mIsCCDBPol)
+		key << " CCDB=" << mRunNumber;
+	std::map<std::string,double>::iterator par;
+	for(par = mBeamParametersMap.begin(); par != mBeamParametersMap.end(); ++par)
+		key << " " << par->first << "=" << par->second;
+	std::map<std::string,std::string>::iterator name;
+	for(name = mBeamHistNameMap.begin(); name != mBeamHistNameMap.end(); ++name)
+		key << " " << name->first << "=" << name->second;
+
+	return key.str();
+}
+
 // create histograms for flux and polarization fraction using CobremsGeneration
 void BeamProperties::generateCobrems(){
 
@@ -165,11 +205,20 @@ void BeamProperties::generateCobrems(){
 	double Elow  = mBeamParametersMap.at("PhotonBeamLowEnergy");
 	double Ehigh = mBeamParametersMap.at("PhotonBeamHighEnergy");
 
-	// Create histograms
+	// Use the spectra from an earlier job with the same parameters, if cached
 	int nBinsEgamma = 1000;
-	fluxVsEgamma = new TH1D("BeamProperties_FluxVsEgamma", "Flux vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
-	polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma", "Polarization Fraction vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
-	TH1D *polFluxVsEgamma   = new TH1D("BeamProperties_PolFluxVsEgamma", "Polarized Flux vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
+	std::ostringstream key;
+	key.precision(17);
+	key << "nBinsEgamma=" << nBinsEgamma;
+	for(int i=0; i<nParameters; i++)
+		key << " " << parameterNames[i] << "=" << mBeamParametersMap.at(parameterNames[i].data());
+	if(readCobremsCache(key.str()))
+		return;
+
+	// Create histograms
+	fluxVsEgamma = new TH1D("BeamProperties_FluxVsEgamma"+mNameSuffix, "Flux vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
+	polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma"+mNameSuffix, "Polarization Fraction vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
+	TH1D *polFluxVsEgamma   = new TH1D("BeamProperties_PolFluxVsEgamma"+mNameSuffix, "Polarized Flux vs. E_{#gamma}", nBinsEgamma, Elow, Ehigh);
 	
 	// Setup cobrems
 	CobremsGeneration cobrems(Emax, Epeak);
@@ -202,6 +251,79 @@ void BeamProperties::generateCobrems(){
 	// Polarization fraction from ratio
 	polFracVsEgamma->Divide(polFluxVsEgamma, fluxVsEgamma);
 
+	writeCobremsCache(key.str());
+
+	return;
+}
+
+// name of the on-disk cache file for the CobremsGeneration spectra, empty if caching is disabled
+TString BeamProperties::cobremsCacheFile( const std::string &key ) {
+
+	const char *cacheDir = getenv("BEAMPROPERTIES_CACHE");
+	if(!cacheDir || !cacheDir[0])
+		return "";
+	return TString::Format("%s/BeamProperties_cobrems_%08x.root", cacheDir, TString(key.c_str()).Hash());
+}
+
+// load CobremsGeneration spectra from the on-disk cache, if present for these parameters
+bool BeamProperties::readCobremsCache( const std::string &key ) {
+
+	TString fileName = cobremsCacheFile(key);
+	if(fileName.Length() == 0 || gSystem->AccessPathName(fileName))
+		return false;
+
+	TDirectory *dir = gDirectory;
+	TFile *fCache = TFile::Open(fileName);
+	if(!fCache || fCache->IsZombie()) {
+		delete fCache;
+		dir->cd();
+		return false;
+	}
+
+	// the key is stored with the histograms in case two parameter sets hash to the same name
+	TNamed *cachedKey = (TNamed*)fCache->Get("key");
+	TH1D *flux = (TH1D*)fCache->Get("flux");
+	TH1D *polFrac = (TH1D*)fCache->Get("polFrac");
+	bool found = (cachedKey && flux && polFrac && key == cachedKey->GetTitle());
+	dir->cd();
+	if(found) {
+		cout<<endl<<"BeamProperties: Using flux and polarization from cache file "<<fileName.Data()<<endl;
+		fluxVsEgamma = (TH1D*)flux->Clone("BeamProperties_FluxVsEgamma"+mNameSuffix);
+		polFracVsEgamma = (TH1D*)polFrac->Clone("BeamProperties_PolFracVsEgamma"+mNameSuffix);
+		fluxVsEgamma->SetDirectory(dir);
+		polFracVsEgamma->SetDirectory(dir);
+	}
+	fCache->Close();
+	delete fCache;
+
+	return found;
+}
+
+// save CobremsGeneration spectra to the on-disk cache, if enabled
+void BeamProperties::writeCobremsCache( const std::string &key ) {
+
+	TString fileName = cobremsCacheFile(key);
+	if(fileName.Length() == 0)
+		return;
+
+	// write under a temporary name and rename, so that concurrent jobs never see a partial file
+	TString tmpName = TString::Format("%s.%d.tmp", fileName.Data(), gSystem->GetPid());
+	TDirectory *dir = gDirectory;
+	TFile *fCache = TFile::Open(tmpName, "RECREATE");
+	if(fCache && !fCache->IsZombie()) {
+		TNamed cachedKey("key", key.c_str());
+		cachedKey.Write();
+		fluxVsEgamma->Write("flux");
+		polFracVsEgamma->Write("polFrac");
+		fCache->Close();
+		if(gSystem->Rename(tmpName, fileName) != 0) {
+			cout << "BeamProperties WARNING:  Could not write cache file " << fileName.Data() << endl;
+			gSystem->Unlink(tmpName);
+		}
+	}
+	delete fCache;
+	dir->cd();
+
 	return;
 }
 
@@ -226,7 +348,7 @@ void BeamProperties::fillFluxFromROOT() {
 	
 	// open histograms and check that they exist
 	if(mBeamHistNameMap.count("ROOTFluxName")) {
-		fluxVsEgamma = (TH1D*)fFlux->Get(mBeamHistNameMap.at("ROOTFluxName").data())->Clone("BeamProperties_FluxVsEgamma");
+		fluxVsEgamma = (TH1D*)fFlux->Get(mBeamHistNameMap.at("ROOTFluxName").data())->Clone("BeamProperties_FluxVsEgamma"+mNameSuffix);
 	}
 	else {
 		cout << "BeamProperties ERROR:  ROOT flux histogram name not defined in configuration file" << endl;
@@ -272,7 +394,7 @@ void BeamProperties::fillPolFromROOT() {
 	
 	// open histograms and check that they exist
 	if(mBeamHistNameMap.count("ROOTPolName")) {
-		polFracVsEgamma = (TH1D*)fPol->Get(mBeamHistNameMap.at("ROOTPolName").data())->Clone("BeamProperties_PolFracVsEgamma");
+		polFracVsEgamma = (TH1D*)fPol->Get(mBeamHistNameMap.at("ROOTPolName").data())->Clone("BeamProperties_PolFracVsEgamma"+mNameSuffix);
 	}
 	else {
 		cout << "BeamProperties ERROR:  ROOT polarization histogram name not defined in configuration file" << endl;
@@ -351,7 +473,7 @@ void BeamProperties::fillFluxFromCCDB() {
 	}
 	Elows_tagh.push_back(tagh_scaled_energy[highest_tagh][2] * photon_endpoint[0]);	// add high energy edge for last counter
 	sort(Elows_tagh.begin(), Elows_tagh.end());
-      	fluxVsEgamma = new TH1D("BeamProperties_FluxVsEgamma", "Flux vs. E_{#gamma}", Elows_tagh.size()-1, &Elows_tagh[0]);
+      	fluxVsEgamma = new TH1D("BeamProperties_FluxVsEgamma"+mNameSuffix, "Flux vs. E_{#gamma}", Elows_tagh.size()-1, &Elows_tagh[0]);
 
 	// Get untagged flux from CCDB and fill histogram
 	vector< vector<double> > taghflux, tagmflux;
@@ -379,7 +501,7 @@ void BeamProperties::fillPolFromCCDB() {
 	cout<<endl<<"BeamProperties WARNING:  Polarization from CCDB is not currently implemented.  Event sample with be generated unpolarized (i.e. polarization=0)."<<endl<<endl;
 	
 	double polMagnitude = 0.0;
-	polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma", "Polarization Fraction vs. E_{#gamma}", 1, 0., 13.);
+	polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma"+mNameSuffix, "Polarization Fraction vs. E_{#gamma}", 1, 0., 13.);
 	polFracVsEgamma->SetBinContent(1, polMagnitude);
 	
         return;
@@ -394,8 +516,7 @@ void BeamProperties::fillPolFixed() {
 	
 	cout<<endl<<"BeamProperties: Using fixed polarization = "<<polMagnitude<<endl;
 
-	polFracVsEgamma = (TH1D*)gDirectory->Get("BeamProperties_PolFracVsEgamma");
-	if(!polFracVsEgamma) polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma", "Polarization Fraction vs. E_{#gamma}", 1, 0., 13.);
+	if(!polFracVsEgamma) polFracVsEgamma = new TH1D("BeamProperties_PolFracVsEgamma"+mNameSuffix, "Polarization Fraction vs. E_{#gamma}", 1, 0., 13.);
 	polFracVsEgamma->SetBinContent(1, polMagnitude);
 	
         return;
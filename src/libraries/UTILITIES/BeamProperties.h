@@ -12,6 +12,7 @@
 
 #include <string>
 #include <map>
+#include <utility>
 
 #include "TH1.h"
 
@@ -30,9 +31,13 @@ public:
 
 private:
 
-  void createHistograms( TString configFile );
+  void createHistograms();
   bool parseConfig();
+  std::string configKey();
   void generateCobrems();
+  TString cobremsCacheFile( const std::string &key );
+  bool readCobremsCache( const std::string &key );
+  void writeCobremsCache( const std::string &key );
   void fillFluxFromROOT();
   void fillPolFromROOT();
   void fillFluxFromCCDB();
@@ -51,6 +56,10 @@ private:
 
   TH1D *fluxVsEgamma;
   TH1D *polFracVsEgamma;
+  TString mNameSuffix;
+
+  // histograms already built in this process, keyed by configKey()
+  static std::map< std::string, std::pair<TH1D*,TH1D*> > mRegistry;
 
 };
 
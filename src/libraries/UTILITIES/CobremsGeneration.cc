@@ -53,6 +53,7 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <stdlib.h>
 #include <CobremsGeneration.hh>
 #include <boost/math/special_functions/expint.hpp>
 #include <boost/math/special_functions/erf.hpp>
@@ -76,6 +77,7 @@ CobremsGeneration::CobremsGeneration(double Emax_GeV, double Epeak_GeV)
    fTargetThickness = 50e-6; // m
    fTargetThetay = 0.050; // radians
    fTargetThetaz = 0; // radians
+   fLatticeTermsValid = false;
    setTargetCrystal("diamond");
    setCoherentEdge(Epeak_GeV);
    fPhotonEnergyMin = 0.120; // GeV
@@ -105,6 +107,7 @@ void CobremsGeneration::updateTargetOrientation()
 
 void CobremsGeneration::setTargetCrystal(std::string crystal)
 {
+   fLatticeTermsValid = false;
    // declare the radiator target crystal type by name
 
    if (crystal == "diamond") {
@@ -318,15 +321,32 @@ void CobremsGeneration::applyBeamCrystalConvolution(int nbins, double *xvalues,
    double a = fTargetCrystal.lattice_constant;
    double qabs = sqrt(8.0) * hbarc * 2*dpi / a;
    double xfact = 2 * fBeamEnergy * qabs / (me*me);
-   double *norm = new double[nbins];
+
+   // The smearing function for source bin j depends on j only through
+   // the scale factor dalph/dx, and is an even function of dalph that
+   // falls off like a gaussian of width sqrt(var0 + varMS). It is
+   // evaluated once per offset |i - j| out to 12 of those widths, where
+   // it is below double precision relative to its peak, and taken as
+   // zero beyond. This makes the convolution O(nbins * width) instead
+   // of O(nbins^2) with two evaluations per pair of bins.
+   double dxbin = (x1 - x0) / nbins;
+   double reach = 12 * sqrt(var0 + varMS);
+   double *kernel = new double[nbins];
    double *result = new double[nbins];
+   for (int i=0; i < nbins; ++i) {
+      result[i] = 0;
+   }
+
    for (int j=0; j < nbins; ++j) {
-      norm[j] = 0;
-      result[j] = 0;
-      for (int i=0; i < nbins; ++i) {
-         double dx = (x1 - x0) * (j - i) / nbins;
-         double x = x0 + (x1 - x0) * (j + 0.5) / nbins;
-         double dalph = dx / xfact / pow(1 - x + 1e-99, 2);
+      double x = x0 + (x1 - x0) * (j + 0.5) / nbins;
+      double dalph_dx = 1 / xfact / pow(1 - x + 1e-99, 2);
+      int dmax = (j > nbins - 1 - j)? j : nbins - 1 - j;
+      double dreach = reach / (dalph_dx * dxbin);
+      if (dreach < dmax) {
+         dmax = (int)dreach;
+      }
+      for (int d=0; d <= dmax; ++d) {
+         double dalph = dxbin * d * dalph_dx;
          double term;
          if (varMS / var0 > 1e-4) {
             term = dalph / varMS *
@@ -340,29 +360,16 @@ void CobremsGeneration::applyBeamCrystalConvolution(int nbins, double *xvalues,
          else {
             term = exp(-dalph*dalph / (2 * var0)) / sqrt(2 * dpi * var0);
          }
-         norm[j] += term;
+         kernel[d] = term;
       }
-   }
-
-   for (int i=0; i < nbins; ++i) {
-      for (int j=0; j < nbins; ++j) {
-         double dx = (x1 - x0) * (j - i) / nbins;
-         double x = x0 + (x1 - x0) * (j + 0.5) / nbins;
-         double dalph = dx / xfact / pow(1 - x + 1e-99, 2);
-         double term;
-         if (varMS / var0 > 1e-4) {
-            term = dalph / varMS *
-                          (boost::math::erf(dalph / sqrt(2 * (var0 + varMS))) -
-                           boost::math::erf(dalph / sqrt(2 * var0))) +
-                   sqrt(2 / dpi) / varMS *
-                          (exp(-dalph*dalph / (2 * (var0 + varMS))) *
-                                                    sqrt(var0 + varMS) -
-                           exp(-dalph*dalph/ (2 * var0)) * sqrt(var0));
-         }
-         else {
-            term = exp(-dalph*dalph / (2 * var0)) / sqrt(2 * dpi * var0);
-         }
-         result[i] += term * yvalues[j] / norm[j];
+      int ilo = (j - dmax > 0)? j - dmax : 0;
+      int ihi = (j + dmax < nbins - 1)? j + dmax : nbins - 1;
+      double norm = 0;
+      for (int i=ilo; i <= ihi; ++i) {
+         norm += kernel[abs(i - j)];
+      }
+      for (int i=ilo; i <= ihi; ++i) {
+         result[i] += kernel[abs(i - j)] * yvalues[j] / norm;
       }
    }
 
@@ -375,7 +382,7 @@ void CobremsGeneration::applyBeamCrystalConvolution(int nbins, double *xvalues,
       }
    }
 
-   delete [] norm;
+   delete [] kernel;
    delete [] result;
 }
 
@@ -443,6 +450,7 @@ CobremsGeneration::CobremsGeneration(const CobremsGeneration &src)
    fCollimatorDiameter = src.fCollimatorDiameter;
    fQ2theta2 = src.fQ2theta2;
    fQ2weight = src.fQ2weight;
+   fLatticeTermsValid = false;
 }
 
 CobremsGeneration &CobremsGeneration::operator=(const CobremsGeneration &src)
@@ -465,6 +473,7 @@ CobremsGeneration &CobremsGeneration::operator=(const CobremsGeneration &src)
    fCollimatorDiameter = src.fCollimatorDiameter;
    fQ2theta2 = src.fQ2theta2;
    fQ2weight = src.fQ2weight;
+   fLatticeTermsValid = false;
    return *this;
 }
 
@@ -559,26 +568,19 @@ double CobremsGeneration::Rate_dNcdx(double x,
    return rate;
 }
 
-double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
+void CobremsGeneration::buildLatticeTerms()
 {
-   // Returns the coherent bremsstrahlung probabililty density differential
-   // in x (scaled photon energy) and phi (azimuthal emission angle) for
-   // fixed photon energy k = x*fBeamEnergy and phi. If fPolarizedFlag is
-   // false (0, default) then the total yield is returned, otherwise it is
-   // only the polarized fraction. If fCollimatedFlag is false (0) then
-   // the total yield is returned, otherwise only the part that passes the
-   // collimator is counted (default).
+   // Enumerates the reciprocal lattice vectors that can contribute to
+   // Rate_dNcdxdp, in the lab frame, keeping only those with a non-zero
+   // structure factor and 0 < xmax <= 1. None of this depends on x or
+   // phi, so it is done once per change of crystal, orientation or
+   // beam energy rather than on every call.
 
-   double Z = fTargetCrystal.Z;
    double a = fTargetCrystal.lattice_constant;
-   double sigma0 = 16 * dpi * fTargetThickness * Z*Z * pow(alpha, 3) *
-                   fBeamEnergy * hbarc/(a*a) * pow(hbarc / (a * me), 4);
+   double qnorm = hbarc * 2 * dpi / a;
+   double betaFF2 = pow(fTargetCrystal.betaFF, 2);
 
-   fQ2theta2.clear();
-   fQ2weight.clear();
-   double qzmin = 99;
-   int hmin, kmin, lmin;
-   double sum = 0;
+   fLatticeTerms.clear();
    // can restrict to h=0 for cpu speedup, if crystal alignment is "reasonable"
    for (int h = -4; h <= 4; ++h) {
       for (int k = -10; k <= 10; ++k) {
@@ -605,7 +607,6 @@ double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
             double S2 = ReS*ReS + ImS*ImS;
             if (S2 < 1e-4)
                continue;
-            double qnorm = hbarc * 2 * dpi / a;
             double q[3];
             q[0] = qnorm * (fTargetRmatrix[0][0] * h +
                             fTargetRmatrix[0][1] * k +
@@ -616,42 +617,80 @@ double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
             q[2] = qnorm * (fTargetRmatrix[2][0] * h +
                             fTargetRmatrix[2][1] * k +
                             fTargetRmatrix[2][2] * l);
-            double q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
-            double qT2 = q[0]*q[0] + q[1]*q[1];
             double xmax = 2 * fBeamEnergy * q[2];
             xmax /= xmax + me*me;
-            if (x > xmax || xmax > 1) {
+            if (xmax <= 0 || xmax > 1)   // x > 0 always
                continue;
-            }
+            lattice_term term;
+            term.h = h;
+            term.k = k;
+            term.l = l;
+            term.S2 = S2;
+            term.q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
+            term.qz = q[2];
+            term.xmax = xmax;
+            double qT2 = q[0]*q[0] + q[1]*q[1];
+            double FF = 1 / (1 + term.q2 * betaFF2);
+            term.weight = qT2 * S2 * pow(FF * betaFF2, 2) *
+                          exp(-term.q2 * fTargetCrystal.Debye_Waller_const);
+            fLatticeTerms.push_back(term);
+         }
+      }
+   }
+   fLatticeTermsValid = true;
+}
+
+double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
+{
+   // Returns the coherent bremsstrahlung probabililty density differential
+   // in x (scaled photon energy) and phi (azimuthal emission angle) for
+   // fixed photon energy k = x*fBeamEnergy and phi. If fPolarizedFlag is
+   // false (0, default) then the total yield is returned, otherwise it is
+   // only the polarized fraction. If fCollimatedFlag is false (0) then
+   // the total yield is returned, otherwise only the part that passes the
+   // collimator is counted (default).
+   if (!fLatticeTermsValid)
+      buildLatticeTerms();
+
+   double Z = fTargetCrystal.Z;
+   double a = fTargetCrystal.lattice_constant;
+   double sigma0 = 16 * dpi * fTargetThickness * Z*Z * pow(alpha, 3) *
+                   fBeamEnergy * hbarc/(a*a) * pow(hbarc / (a * me), 4);
+   double cos2phi = pow(cos(phi), 2);
+
+   fQ2theta2.clear();
+   fQ2weight.clear();
+   double qzmin = 99;
+   int hmin, kmin, lmin;
+   double sum = 0;
+   for (unsigned int n=0; n < fLatticeTerms.size(); ++n) {
+      const lattice_term &term = fLatticeTerms[n];
+      double xmax = term.xmax;
+      if (x > xmax) {
+         continue;
+      }
 
 #if COBREMS_GENERATOR_VERBOSITY > 2
-            else {
-               std::cout << h << "," << k << "," << l << ","
-                         << S2 << "," << q2 << "," << xmax
-                         << std::endl;
-            }
+      std::cout << term.h << "," << term.k << "," << term.l << ","
+                << term.S2 << "," << term.q2 << "," << xmax
+                << std::endl;
 #endif
 
-            if (q[2] < qzmin) {
-               qzmin = q[2];
-               hmin = h;
-               kmin = k;
-               lmin = l;
-            }
-            double theta2 = (1 - x) * xmax / (x * (1 - xmax) + 1e-99) - 1;
-            double betaFF2 = pow(fTargetCrystal.betaFF, 2);
-            double FF = 1 / (1 + q2 * betaFF2);
-            sum += sigma0 * qT2 * S2 * pow(FF * betaFF2, 2) *
-                   exp(-q2 * fTargetCrystal.Debye_Waller_const) *
-                   ((1 - x) / pow(x * (1 + theta2) + 1e-99, 2)) *
-                   ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
-                                              (1 - x) * pow(cos(phi), 2))) *
-                   ((fCollimatedFlag)? Acceptance(theta2) : 1) *
-                   ((fPolarizedFlag)? Polarization(x, theta2, phi) : 1);
-            fQ2theta2.push_back(theta2);
-            fQ2weight.push_back(sum);
-         }
+      if (term.qz < qzmin) {
+         qzmin = term.qz;
+         hmin = term.h;
+         kmin = term.k;
+         lmin = term.l;
       }
+      double theta2 = (1 - x) * xmax / (x * (1 - xmax) + 1e-99) - 1;
+      sum += sigma0 * term.weight *
+             ((1 - x) / pow(x * (1 + theta2) + 1e-99, 2)) *
+             ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
+                                        (1 - x) * cos2phi)) *
+             ((fCollimatedFlag)? Acceptance(theta2) : 1) *
+             ((fPolarizedFlag)? Polarization(x, theta2, phi) : 1);
+      fQ2theta2.push_back(theta2);
+      fQ2weight.push_back(sum);
    }
 
 #if COBREMS_GENERATOR_VERBOSITY > 1
@@ -665,6 +704,17 @@ double CobremsGeneration::Rate_dNcdxdp(double x, double phi)
    return sum;
 }
 
+void CobremsGeneration::Rate_dNcdxdp(int npoints, const double *x, const double *phi,
+                                double *rate)
+{
+   // Evaluates Rate_dNcdxdp(x[i], phi[i]) into rate[i] for npoints
+   // points, sharing one lookup of the lattice terms. On return the
+   // statistical record fQ2theta2, fQ2weight is that of the last point.
+
+   for (int i=0; i < npoints; ++i)
+      rate[i] = Rate_dNcdxdp(x[i], phi[i]);
+}
+
 double CobremsGeneration::Rate_dNidx(double x)
 {
    // Returns the incoherent bremsstrahlung probabililty density differential
@@ -924,6 +974,7 @@ void CobremsGeneration::RotateTarget(double thetax,
    //   Rmatrix(out) = Rx(thx) Ry(thy) Rz(thz) Rmatrix(in)
    // with rotations understood in the passive sense.
 
+   fLatticeTermsValid = false;
    if (thetaz != 0) {
       double sint = sin(thetaz);
       double cost = cos(thetaz);
@@ -1087,6 +1138,7 @@ double (CobremsGeneration::*Rate_dNtdx_1)(double) = &CobremsGeneration::Rate_dNt
 double (CobremsGeneration::*Rate_dNtdx_3)(double, double, double) = &CobremsGeneration::Rate_dNtdx;
 double (CobremsGeneration::*Rate_dNcdx_1)(double) = &CobremsGeneration::Rate_dNcdx;
 double (CobremsGeneration::*Rate_dNcdx_3)(double, double, double) = &CobremsGeneration::Rate_dNcdx;
+double (CobremsGeneration::*Rate_dNcdxdp_2)(double, double) = &CobremsGeneration::Rate_dNcdxdp;
 double (CobremsGeneration::*Acceptance_1)(double) = &CobremsGeneration::Acceptance;
 double (CobremsGeneration::*Acceptance_4)(double, double, double, double) = &CobremsGeneration::Acceptance;
 double (CobremsGeneration::*Polarization_2)(double, double) = &CobremsGeneration::Polarization;
@@ -1153,7 +1205,7 @@ BOOST_PYTHON_MODULE(libcobrems)
       .def("Rate_dNtdk", &CobremsGeneration::Rate_dNtdk)
       .def("Rate_dNcdx", Rate_dNcdx_1)
       .def("Rate_dNcdx", Rate_dNcdx_3)
-      .def("Rate_dNcdxdp", &CobremsGeneration::Rate_dNcdxdp)
+      .def("Rate_dNcdxdp", Rate_dNcdxdp_2)
       .def("Rate_dNidx", &CobremsGeneration::Rate_dNidx)
       .def("Rate_dNBidx", &CobremsGeneration::Rate_dNBidx)
       .def("Rate_dNidxdt2", &CobremsGeneration::Rate_dNidxdt2)
@@ -38,10 +38,22 @@ using namespace std;
 
 
 
-std::complex<double> pw_refl(string fitresFile, int L, int hel[3]);
-std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string fitFile);
-std::complex<double> Moments_refl(int alp, int L, int M, string file_fit);
+// partial waves of one {t, m_eta_pi} bin, read once from its fit results file
+struct BinWaves {
+  bool valid;
+  std::complex<double> pw[LMAX+1][LMAX+1];   // [L][m] for eps = +1, k = 0 and m >= 0
+};
+
+BinWaves load_waves(string fitresFile);
+std::complex<double> pw_refl(FitResults& fitres, int L, int m);
+std::complex<double> wave_refl(const BinWaves& waves, int L, int hel[3]);
+std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, const BinWaves& waves);
+std::complex<double> Moments_refl(int alp, int L, int M, const BinWaves& waves);
 double clebsch(double j1, double j2, double j3, double m1, double m2);
+void fill_clebsch_table();
+
+// clebsch(l2, L, l1, m2, M) for all the terms of Moments_refl, indexed [l2][L][l1][m2+LMAX][M]
+double cg_table[LMAX+1][LMAX*LMAX+1][LMAX+1][2*LMAX+1][LMAX*LMAX+1];
 
 
 
@@ -108,22 +120,16 @@ int main( int argc, char* argv[] ){
 
 
 
-    // descend into the directory that contains the bins
-    chdir( fitDir.c_str() );
-
-
+    fill_clebsch_table();
 
     //Looping through M_eta_pi and t bins
     for( int i = 0; i < kNumBins;i++ ){
       for( int j = 0; j < kNumBinst; j++ ){  
 	cout<<"bin "<<i<<"_"<<j<<endl;
         
-        ostringstream dir;
-        dir << "bin_" << i<<"_"<<j;
-        chdir( dir.str().c_str() );
-        
-        string resultsFile;
-        resultsFile ="bin_" + std::to_string(i)+"_"+ std::to_string(j)+".fit";
+        // the fit results of each bin are in the directory that contains the bins
+        string binName = "bin_" + std::to_string(i)+"_"+ std::to_string(j);
+        BinWaves waves = load_waves( fitDir + "/" + binName + "/" + binName + ".fit" );
 
         
         // print out the bin center
@@ -134,13 +140,11 @@ int main( int argc, char* argv[] ){
     for (int L = 0; L<= pow(LMAX,2); L++) {// calculating moments and writing to a file
     for (int M = 0; M<= L; M++) {
      
-      outfile << real(Moments_refl(0, L, M, resultsFile))<< "\t"<< 0 <<"\t";
-      outfile << real(Moments_refl(1, L, M, resultsFile))<< "\t"<< 0 <<"\t";
-      // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(Moments_refl(0, L, M, resultsFile))<<" H1_00=  "<< real(Moments_refl(1, L, M, resultsFile))<<endl;
+      outfile << real(Moments_refl(0, L, M, waves))<< "\t"<< 0 <<"\t";
+      outfile << real(Moments_refl(1, L, M, waves))<< "\t"<< 0 <<"\t";
+      // if(L==0 && M==0 && i==44 && j==3)cout <<" H0_00=  "<< real(Moments_refl(0, L, M, waves))<<" H1_00=  "<< real(Moments_refl(1, L, M, waves))<<endl;
         }}
         outfile << endl;
-        
-        chdir( ".." );
     }
     }
 
@@ -160,44 +164,38 @@ int main( int argc, char* argv[] ){
 
 
 
-std::complex<double> pw_refl(string fitresFile, int L, int hel[3]){
-  /* returns partial waves for g p --> (eta pi)_L p
-  * partial waves are in the reflectivity basis
-  * fitresFile is the name of the fit output file for given m_eta_pi and t bin
-  * hel = {epsilon, m, k}
-  * epsilon is the relfectivity
-  * k = 0,1 is the nucleon non-flip (0) or flip (1)
+BinWaves load_waves(string fitresFile){
+  /* reads the partial waves of one {t, m_eta_pi} bin from its fit output file,
+  * so that the file is parsed once rather than for every wave of every moment
   */
+  BinWaves waves;
+  for (int L = 0; L <= LMAX; L++) {
+  for (int m = 0; m <= LMAX; m++) {
+    waves.pw[L][m] = 0.0;
+  }}
 
+  FitResults fitres(fitresFile);
 
- std::complex<double> pw (0.0,0.0), ui (0.,1.), zero(0.0, 0.0);
-  
-  int eps = hel[0], m = hel[1], k = hel[2];
+  waves.valid = fitres.valid();
+  if( !waves.valid )return waves;
 
+  for (int L = 0; L <= LMAX; L++) {
+  for (int m = 0; m <= L; m++) {
+    waves.pw[L][m] = pw_refl(fitres, L, m);
+  }}
+  return waves;
+}
 
-FitResults fitres(fitresFile);
 
- if( !fitres.valid() )return zero;
- // eps = +/- 1 ; k = 0,1 ; |m|<= L
-  if( abs(eps)!=1 || abs(2*k-1)!=1 || abs(m)>L) {
-    return zero;
-  }
-  
-  
-  // only positive refelctivity
-  if (eps == -1){
-    return zero;
-  }
-  // only nucleon non-flip
-  if (k == 1){
-    return zero;
-  }
-  // only positive m
-  if (m < 0){
-    return zero;
-  }
- 
-  if (eps == 1){
+
+std::complex<double> pw_refl(FitResults& fitres, int L, int m){
+  /* returns partial waves for g p --> (eta pi)_L p
+  * with positive reflectivity, nucleon non-flip and m >= 0,
+  * which are the only ones used in the fit
+  * fitres are the fit results for given m_eta_pi and t bin
+  */
+ std::complex<double> pw (0.0,0.0), zero(0.0, 0.0);
+
     switch (L) {
       case 0:
         // a0(980)
@@ -219,10 +217,41 @@ FitResults fitres(fitresFile);
         pw = zero;
         break;
     }
+  return pw;
+}
+
+
+
+std::complex<double> wave_refl(const BinWaves& waves, int L, int hel[3]){
+  /* returns partial waves in the reflectivity basis
+  * hel = {epsilon, m, k}
+  * epsilon is the relfectivity
+  * k = 0,1 is the nucleon non-flip (0) or flip (1)
+  */
+ std::complex<double> zero(0.0, 0.0);
   
+  int eps = hel[0], m = hel[1], k = hel[2];
+
+ if( !waves.valid )return zero;
+ // eps = +/- 1 ; k = 0,1 ; |m|<= L
+  if( abs(eps)!=1 || abs(2*k-1)!=1 || abs(m)>L || L>LMAX) {
+    return zero;
+  }
   
+  // only positive refelctivity
+  if (eps == -1){
+    return zero;
   }
-  return pw;
+  // only nucleon non-flip
+  if (k == 1){
+    return zero;
+  }
+  // only positive m
+  if (m < 0){
+    return zero;
+  }
+
+  return waves.pw[L][m];
 }
 
 
@@ -230,8 +259,8 @@ FitResults fitres(fitresFile);
 
 
 
-std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string fitFile){ // code formula (D8) from 10.1103/PhysRevD.100.054017 //alp corresponds to H0 or H1
-  // fitresFile contains fit results in given {t,m_etapi} bin
+std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, const BinWaves& waves){ // code formula (D8) from 10.1103/PhysRevD.100.054017 //alp corresponds to H0 or H1
+  // waves contains fit results in given {t,m_etapi} bin
   std::complex<double> rho (0.0,0.0), ui (0.0, 1.0);
   std::complex<double> pw1 (0.0,0.0), pw2 (0.0,0.0);
   int hel1[3], hel2[3]; // hel = [eps, m , k]
@@ -247,14 +276,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
       case 0:
         fac = 1.0;
         hel1[1] = M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1); //  fitresFile contains fitresults for given bin in { t_{pp}, m_{eta pi}}, L , hel = {epsilon, m proj. of L, k}
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1); //  waves contains fitresults for given bin in { t_{pp}, m_{eta pi}}, L , hel = {epsilon, m proj. of L, k}
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = pow(-1.,M1-M2);
         hel1[1] = -M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
        
         break;
@@ -263,14 +292,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = -(double)e*pow(-1.,M1);
         
         hel1[1] = -M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = -(double)e*pow(-1.,M2);
         hel1[1] = M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -278,14 +307,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = -ui*(double)e*pow(-1.,M1);
         
         hel1[1] = -M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = +ui*(double)e*pow(-1.,M2);
         hel1[1] = M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -293,14 +322,14 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
         fac = 1.0;
         
         hel1[1] = M1; hel2[1] = M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         
         fac = -pow(-1.,M1-M2);
         hel1[1] = -M1; hel2[1] = -M2;
-        pw1 = pw_refl(fitFile, L1, hel1);
-        pw2 = pw_refl(fitFile, L2, hel2);
+        pw1 = wave_refl(waves, L1, hel1);
+        pw2 = wave_refl(waves, L2, hel2);
         rho += fac * pw1 * conj(pw2);
         break;
         
@@ -316,7 +345,7 @@ std::complex<double> sdme_refl(int alp, int L1, int L2, int M1, int M2, string f
 
 
 
-std::complex<double> Moments_refl(int alp, int L, int M, string file_fit){ //H0 or H1 , L, M, fitresults file for given t and  invariant mass bin 
+std::complex<double> Moments_refl(int alp, int L, int M, const BinWaves& waves){ //H0 or H1 , L, M, fitresults for given t and  invariant mass bin 
   // WARNING: the sum extends to max(l1,l2) = LMAX 
   std::complex<double> mom = 0.0;
   std::complex<double> rho = 0.0;
@@ -328,9 +357,9 @@ std::complex<double> Moments_refl(int alp, int L, int M, string file_fit){ //H0
   for (int l1 = 0;l1 <= LMAX ; l1 +=1 ) {
   for (int l2 = 0; l2 <= LMAX ; l2 +=1 ) {
       for (int m2 = -l2; m2 <= l2; m2 +=1 ) {
-        cg1 = clebsch(l2,L,l1,0,0);   // m1,m2 and M are =0
-        cg2 = clebsch(l2,L,l1,m2,M);  // 6th argument m1=M+m2
-        rho = sdme_refl(alp, l1, l2, m2+M,m2, file_fit);
+        cg1 = cg_table[l2][L][l1][LMAX][0];   // clebsch(l2,L,l1,0,0), m1,m2 and M are =0
+        cg2 = cg_table[l2][L][l1][m2+LMAX][M];  // clebsch(l2,L,l1,m2,M), 6th argument m1=M+m2
+        rho = sdme_refl(alp, l1, l2, m2+M,m2, waves);
         mom += fac*sqrt( (2.0*l2+1)/(2.0*l1+1) )*cg1*cg2*rho;
 	
       }}}
@@ -407,4 +436,13 @@ double clebsch(double j1, double j2, double j3, double m1, double m2){
 
 
 
-
+void fill_clebsch_table(){
+  // the same few coefficients are needed for every bin, so compute them once
+  for (int l2 = 0; l2 <= LMAX; l2++) {
+  for (int L = 0; L <= LMAX*LMAX; L++) {
+  for (int l1 = 0; l1 <= LMAX; l1++) {
+  for (int m2 = -LMAX; m2 <= LMAX; m2++) {
+  for (int M = 0; M <= LMAX*LMAX; M++) {
+    cg_table[l2][L][l1][m2+LMAX][M] = clebsch(l2,L,l1,m2,M);
+  }}}}}
+}
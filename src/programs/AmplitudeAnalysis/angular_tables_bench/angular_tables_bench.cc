@@ -0,0 +1,137 @@
+// angular_tables_bench
+//
+// Times the angular part of the Vec_ps_refl and omegapi_amplitude
+// amplitudes, summed over the three helicities of the vector, with
+// wignerD/clebschGordan called for every event (as before) and with
+// WignerDTable/ClebschGordanTable (as now).  The wave set is that of an
+// omega pi fit with J^P = 0-, 1+-, 2+-, 3+- and every allowed l and m,
+// 46 waves in all.  The angles are drawn uniformly with a fixed seed.
+// Before timing, it checks that the table returns 0 for |m| > j or |n| > j.
+//
+// Usage: angular_tables_bench [nEvents]   (default 20000)
+
+#include <iostream>
+#include <iomanip>
+#include <complex>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include "AMPTOOLS_AMPS/wignerD.h"
+#include "AMPTOOLS_AMPS/clebschGordan.h"
+#include "AMPTOOLS_AMPS/WignerDTable.h"
+#include "AMPTOOLS_AMPS/ClebschGordanTable.h"
+
+using namespace std;
+
+struct Wave {
+  int j, m, l;
+  GDouble helAmp[3];          // <l 0 1 lambda | j lambda>, lambda = -1, 0, 1
+  const WignerDTable* table;
+};
+
+int main( int argc, char* argv[] ){
+
+  int nEvents = 20000;
+  if( argc > 1 ) nEvents = atoi( argv[1] );
+  if( nEvents < 1 ){
+    cout << "Usage: angular_tables_bench [nEvents]" << endl;
+    return 1;
+  }
+
+  // omega pi partial waves: P = (-1)^l
+  vector< Wave > waves;
+  const int JP[][2] = { {0,-1}, {1,1}, {1,-1}, {2,1}, {2,-1}, {3,1}, {3,-1} };
+  for( int k = 0; k < 7; ++k ){
+    int j = JP[k][0], P = JP[k][1];
+    for( int l = abs( j - 1 ); l <= j + 1; ++l ){
+      if( ( l % 2 == 0 ? 1 : -1 ) != P ) continue;
+      int jMax = ( j > 1 ? j : 1 );
+      const ClebschGordanTable* cgTable = ClebschGordanTable::Get( jMax );
+      for( int m = -j; m <= j; ++m ){
+        Wave w;
+        w.j = j; w.m = m; w.l = l;
+        w.table = WignerDTable::Get( jMax );
+        for( int lambda = -1; lambda <= 1; ++lambda )
+          w.helAmp[lambda+1] = cgTable->cg( l, 1, 0, lambda, j, lambda );
+        waves.push_back( w );
+      }
+    }
+  }
+  const int nWaves = waves.size();
+
+  // the 0- wave asks for D^0_{0,+-1}, which has to vanish as in wignerD
+  const WignerDTable* table = WignerDTable::Get( 3 );
+  for( int j = 0; j <= 3; ++j ){
+    for( int m = -j-1; m <= j+1; ++m ){
+      for( int n = -j-1; n <= j+1; ++n ){
+        if( abs( m ) <= j && abs( n ) <= j ) continue;
+        if( table->d( j, m, n, 0.3 ) != 0 ){
+          cout << "WignerDTable::d( " << j << ", " << m << ", " << n
+               << " ) is not 0" << endl;
+          return 1;
+        }
+      }
+    }
+  }
+
+  // cosTheta, phi of the resonance decay and cosThetaH, phiH of the omega decay
+  srand( 1 );
+  vector< GDouble > angles( 4*nEvents );
+  for( int i = 0; i < nEvents; ++i ){
+    angles[4*i]   = 2.0 * rand() / RAND_MAX - 1;
+    angles[4*i+1] = 2 * PI * rand() / RAND_MAX;
+    angles[4*i+2] = 2.0 * rand() / RAND_MAX - 1;
+    angles[4*i+3] = 2 * PI * rand() / RAND_MAX;
+  }
+
+  vector< complex< GDouble > > oldAmps( nEvents*nWaves ), newAmps( nEvents*nWaves );
+
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  for( int i = 0; i < nEvents; ++i ){
+    const GDouble* a = &angles[4*i];
+    for( int k = 0; k < nWaves; ++k ){
+      const Wave& w = waves[k];
+      complex< GDouble > amplitude( 0, 0 );
+      for( int lambda = -1; lambda <= 1; ++lambda ){
+        GDouble hel_amp = clebschGordan( w.l, 1, 0, lambda, w.j, lambda );
+        amplitude += conj( wignerD( w.j, w.m, lambda, a[0], a[1] ) ) * hel_amp *
+                     conj( wignerD( 1, lambda, 0, a[2], a[3] ) );
+      }
+      oldAmps[i*nWaves+k] = amplitude;
+    }
+  }
+  chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+  for( int i = 0; i < nEvents; ++i ){
+    const GDouble* a = &angles[4*i];
+    for( int k = 0; k < nWaves; ++k ){
+      const Wave& w = waves[k];
+      complex< GDouble > amplitude( 0, 0 );
+      for( int lambda = -1; lambda <= 1; ++lambda ){
+        GDouble hel_amp = w.helAmp[lambda+1];
+        amplitude += conj( w.table->D( w.j, w.m, lambda, a[0], a[1] ) ) * hel_amp *
+                     conj( w.table->D( 1, lambda, 0, a[2], a[3] ) );
+      }
+      newAmps[i*nWaves+k] = amplitude;
+    }
+  }
+  chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+  double maxDiff = 0;
+  for( size_t k = 0; k < oldAmps.size(); ++k ){
+    double diff = abs( oldAmps[k] - newAmps[k] );
+    if( diff > maxDiff ) maxDiff = diff;
+  }
+
+  double nAmps = (double)nEvents * nWaves;
+  double oldTime = chrono::duration< double >( t1 - t0 ).count();
+  double newTime = chrono::duration< double >( t2 - t1 ).count();
+  cout << nWaves << " waves, " << nEvents << " events" << endl;
+  cout << fixed << setprecision( 1 );
+  cout << "  wignerD/clebschGordan:           " << oldTime / nAmps * 1e9 << " ns per amplitude" << endl;
+  cout << "  WignerDTable/ClebschGordanTable: " << newTime / nAmps * 1e9 << " ns per amplitude" << endl;
+  cout << scientific << setprecision( 2 );
+  cout << "  largest difference: " << maxDiff << endl;
+
+  return 0;
+}
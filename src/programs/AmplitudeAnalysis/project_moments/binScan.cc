@@ -0,0 +1,97 @@
+#include <sstream>
+#include <vector>
+
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "binScan.h"
+
+struct binScanState {
+  string fitDir;
+  int nBins;
+  int nextBin;
+  binScanFunc func;
+  void* arg;
+  pthread_mutex_t binMutex;     // guards nextBin
+  pthread_mutex_t parseMutex;   // serializes FitResults construction
+};
+
+string binResultsFile(const string& fitDir, int bin)
+{
+  ostringstream file;
+  file << fitDir << "/bin_" << bin << "/bin_" << bin << ".fit";
+  return file.str();
+}
+
+static void* scanWorker(void* p)
+{
+  binScanState* state = (binScanState*) p;
+
+  while (true){
+
+    pthread_mutex_lock(&state->binMutex);
+    int bin = state->nextBin++;
+    pthread_mutex_unlock(&state->binMutex);
+    if (bin >= state->nBins)
+      break;
+
+    string resultsFile = binResultsFile(state->fitDir, bin);
+
+    // FitResults can only be loaded from a file name, so start the
+    // kernel reading the file into the page cache before waiting for
+    // the parser; the files of all workers are then read concurrently
+    int fd = open(resultsFile.c_str(), O_RDONLY);
+    if (fd >= 0){
+      posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+      close(fd);
+    }
+
+    pthread_mutex_lock(&state->parseMutex);
+    FitResults* results = new FitResults(resultsFile);
+    pthread_mutex_unlock(&state->parseMutex);
+
+    if (results->valid())
+      state->func(bin, *results, state->arg);
+
+    pthread_mutex_lock(&state->parseMutex);
+    delete results;
+    pthread_mutex_unlock(&state->parseMutex);
+  }
+
+  return NULL;
+}
+
+void scanBins(const string& fitDir, int nBins, int nThreads,
+              binScanFunc func, void* arg)
+{
+  binScanState state;
+  state.fitDir = fitDir;
+  state.nBins = nBins;
+  state.nextBin = 0;
+  state.func = func;
+  state.arg = arg;
+  pthread_mutex_init(&state.binMutex, NULL);
+  pthread_mutex_init(&state.parseMutex, NULL);
+
+  if (nThreads < 1)
+    nThreads = 1;
+  if (nThreads > nBins)
+    nThreads = nBins;
+
+  vector<pthread_t> threads(nThreads);
+  int nStarted = 0;
+  for (int i = 0; i < nThreads; i++, nStarted++)
+    if (pthread_create(&threads[i], NULL, scanWorker, &state) != 0)
+      break;
+
+  // fall back to scanning on this thread if none could be started
+  if (nStarted == 0)
+    scanWorker(&state);
+
+  for (int i = 0; i < nStarted; i++)
+    pthread_join(threads[i], NULL);
+
+  pthread_mutex_destroy(&state.parseMutex);
+  pthread_mutex_destroy(&state.binMutex);
+}
@@ -0,0 +1,27 @@
+#ifndef BINSCAN_H__
+#define BINSCAN_H__
+
+#include <string>
+
+#include "IUAmpTools/FitResults.h"
+
+using namespace std;
+
+// Called once for every bin whose fit results are valid. Calls for
+// different bins run concurrently, so the function must only write to
+// storage belonging to its own bin (no ROOT histograms): fill those
+// from the stored values once scanBins has returned.
+typedef void (*binScanFunc)(int bin, FitResults& results, void* arg);
+
+// Path of the fit results of a bin: <fitDir>/bin_<bin>/bin_<bin>.fit
+string binResultsFile(const string& fitDir, int bin);
+
+// Load the fit results of bins 0..nBins-1 of fitDir and pass each one
+// to func, using nThreads threads. The working directory is never
+// changed. The files are read ahead on all threads at once, but the
+// FitResults are parsed one at a time, because the AmpTools config
+// parser is not thread safe; the calls to func run concurrently.
+void scanBins(const string& fitDir, int nBins, int nThreads,
+              binScanFunc func, void* arg);
+
+#endif
@@ -12,11 +12,40 @@
 
 #include "wave.h"
 #include "3j.h"
+#include "binScan.h"
 
 #include "TFile.h"
 
 using namespace std;
 
+// moments of every bin, filled in by the scan threads
+struct momentScan {
+  const waveset* ws;
+  const std::vector<std::pair<size_t, size_t> >* vecMom;
+  vector<int> filled;
+  vector<int> mismatch;
+  vector< vector<double> > value, error;
+};
+
+void projectBin( int bin, FitResults& results, void* arg ){
+
+  momentScan* scan = (momentScan*) arg;
+  const waveset& ws = *scan->ws;
+
+  if (  2*ws.getNwaves() != results.parValueList().size() ){
+    scan->mismatch[bin] = 1;
+    return;
+  }
+
+  for (size_t k = 0; k < scan->vecMom->size(); k++)
+    {
+      const std::pair<size_t, size_t>& LM = (*scan->vecMom)[k];
+      scan->value[bin][k] = decomposeMoment(LM, ws, results.parValueList());
+      scan->error[bin][k] = decomposeMomentError(LM, ws, results.parValueList(), results.errorMatrix());
+    }
+  scan->filled[bin] = 1;
+}
+
 int main( int argc, char* argv[] ){
 
   // set default parameters
@@ -28,6 +57,7 @@ int main( int argc, char* argv[] ){
   
   string outfileName("moments.root");
   bool print = false;
+  int nThreads = sysconf( _SC_NPROCESSORS_ONLN );
 
   // parse command line
   
@@ -43,11 +73,15 @@ int main( int argc, char* argv[] ){
       else  outfileName = argv[++i]; }
     if (arg == "-p")  
       print = true;
+    if (arg == "-j"){  
+      if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+      else  nThreads = atoi( argv[++i] ); }
     if (arg == "-h"){
       cout << endl << " Usage for: " << argv[0] << endl << endl;
       cout << "(optional) -f <fit dir>\t : Fit Directory" << endl;
       cout << "(optional) -o <file>\t : Output file (default: moments.root)" << endl;
       cout << "(optional) -p\t\t : Print equations" << endl;
+      cout << "(optional) -j <n>\t : Number of threads (default: number of cores)" << endl;
       exit(1);}
   }
   
@@ -144,38 +178,31 @@ int main( int argc, char* argv[] ){
   TFile *outfile = new TFile(outfileName.c_str(), "recreate");
   if (!outfile->IsOpen()) exit(1);
 
-  // descend into the directory that contains the bins
-  chdir( fitDir.c_str() );
-  
+  // compute the moments of all the bins, then fill the histograms
+  momentScan scan;
+  scan.ws = &ws;
+  scan.vecMom = &vecMom;
+  scan.filled.assign( kNumBins, 0 );
+  scan.mismatch.assign( kNumBins, 0 );
+  scan.value.assign( kNumBins, vector<double>( vecMom.size() ) );
+  scan.error.assign( kNumBins, vector<double>( vecMom.size() ) );
+  scanBins( fitDir, kNumBins, nThreads, projectBin, &scan );
+
   for( int i = 0; i < kNumBins; ++i ){
     
-    ostringstream dir;
-    dir << "bin_" << i;
-    chdir( dir.str().c_str() );
-    
-    ostringstream resultsFile;
-    resultsFile << "bin_" << i << ".fit";
-    
-    FitResults results( resultsFile.str() );
-    if( !results.valid() ){
-      
-      chdir( ".." );
-      continue;
-    }
-
-    if (  2*ws.getNwaves() != results.parValueList().size() ){
+    if ( scan.mismatch[i] ){
       cout << "Different number of waves in fit result. Check waveset!" << endl;
       outfile->Close();
       exit(1);
     }
+    if ( !scan.filled[i] )
+      continue;
     
-    for (std::vector<std::pair<size_t, size_t> >::const_iterator it = vecMom.begin(); it != vecMom.end(); it++)
+    for (size_t k = 0; k < vecMom.size(); k++)
       {
-	hMoments[*it]->SetBinContent(i + 1, decomposeMoment(*it, ws, results.parValueList()));
-	hMoments[*it]->SetBinError(i + 1, decomposeMomentError(*it, ws, results.parValueList(), results.errorMatrix()));
+	hMoments[vecMom[k]]->SetBinContent(i + 1, scan.value[i][k]);
+	hMoments[vecMom[k]]->SetBinError(i + 1, scan.error[i][k]);
       }
-    
-    chdir( ".." );
   }
   
   
@@ -66,10 +66,10 @@ void GetDOCA(int ipart, float x[3], float p[5], float doca[3])
 	float tdir[3] = {0.0, 1.0, 0.0};
 	float udir[3] = {0.0, 0.0, 1.0};
 	float origin_global[3], sdir_global[3], tdir_global[3], udir_global[3];
-	transformCoord(origin,"local",origin_global,"global");
-	transformCoord(sdir,"local",sdir_global,"global");
-	transformCoord(tdir,"local",tdir_global,"global");
-	transformCoord(udir,"local",udir_global,"global");
+	transformFrame(origin,FRAME_LOCAL,origin_global,FRAME_GLOBAL);
+	transformFrame(sdir,FRAME_LOCAL,sdir_global,FRAME_GLOBAL);
+	transformFrame(tdir,FRAME_LOCAL,tdir_global,FRAME_GLOBAL);
+	transformFrame(udir,FRAME_LOCAL,udir_global,FRAME_GLOBAL);
 	DCoordinateSystem wire;
 	wire.origin.SetXYZ(origin_global[0], origin_global[1], origin_global[2]);
 	wire.sdir.SetXYZ(sdir_global[0], sdir_global[1], sdir_global[2]);
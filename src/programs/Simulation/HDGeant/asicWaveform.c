@@ -0,0 +1,111 @@
+/*
+ * asicWaveform.c - tabulated ASIC response for drift-cluster waveforms
+ *
+ * In drift-cluster mode the CDC and FDC hit routines build a 1 ns
+ * sampled waveform for every hit wire or strip from the clusters
+ * collected on it. Evaluating asic_response for every cluster at
+ * every sample costs several exp() calls per (sample, cluster) pair.
+ * Here the response is tabulated once. Because the samples are 1 ns
+ * apart, the offset of a cluster into its pulse has the same
+ * fractional part at every sample, so each pulse is added as a
+ * weighted sum of two contiguous rows of the table, and only over
+ * the ASIC_WAVEFORM_LENGTH samples where the pulse is non-negligible.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <asicWaveform.h>
+
+extern double asic_response(double t);
+
+/* asic_response switches from its cubic rise to the sum of gaussians
+ * at 10.3 ns, with a small step there, so the sample that falls in
+ * (10,11] ns is not interpolated but evaluated directly. */
+#define ASIC_WAVEFORM_STEP 10
+
+/* kernel[p][k] = asic_response(k + p/ASIC_WAVEFORM_PHASES) */
+static float kernel[ASIC_WAVEFORM_PHASES+1][ASIC_WAVEFORM_LENGTH];
+static int kernelReady = 0;
+
+static float* sampleBuffer = 0;
+static int sampleBufferSize = 0;
+
+static void fillKernel()
+{
+   int p,k;
+   for (p=0; p <= ASIC_WAVEFORM_PHASES; ++p)
+   {
+      for (k=0; k < ASIC_WAVEFORM_LENGTH; ++k)
+      {
+         kernel[p][k] = asic_response(k + p/(double)ASIC_WAVEFORM_PHASES);
+      }
+   }
+   kernelReady = 1;
+}
+
+/* Return a zeroed sample buffer. The buffer is reused from one call
+ * to the next, so the caller must be done with the previous one. */
+
+float* asicWaveformBuffer(int num_samples)
+{
+   if (!kernelReady)
+   {
+      fillKernel();
+   }
+   if (num_samples > sampleBufferSize)
+   {
+      free(sampleBuffer);
+      sampleBuffer = malloc(num_samples*sizeof(float));
+      sampleBufferSize = num_samples;
+   }
+   memset(sampleBuffer,0,num_samples*sizeof(float));
+   return sampleBuffer;
+}
+
+/* Add amplitude*asic_response(i-t0) to samples[i] for all i > t0 */
+
+void asicWaveformAddPulse(float* samples, int num_samples,
+                          float t0, double amplitude)
+{
+   int first = (int)floor(t0) + 1;
+   double phase = (first - (double)t0)*ASIC_WAVEFORM_PHASES;
+   int p = (int)phase;
+   float w1, w0;
+   const float* k0;
+   const float* k1;
+   float* s;
+   int k, kstart, kend;
+
+   if (!kernelReady)
+   {
+      fillKernel();
+   }
+   if (p >= ASIC_WAVEFORM_PHASES)
+   {
+      p = ASIC_WAVEFORM_PHASES-1;
+   }
+   w1 = (float)((phase - p)*amplitude);
+   w0 = (float)amplitude - w1;
+   k0 = kernel[p];
+   k1 = kernel[p+1];
+
+   kstart = (first < 0)? -first : 0;
+   kend = num_samples - first;
+   if (kend > ASIC_WAVEFORM_LENGTH)
+   {
+      kend = ASIC_WAVEFORM_LENGTH;
+   }
+   s = samples + first;
+   for (k=kstart; k < kend; ++k)
+   {
+      s[k] += w0*k0[k] + w1*k1[k];
+   }
+   if (ASIC_WAVEFORM_STEP >= kstart && ASIC_WAVEFORM_STEP < kend)
+   {
+      k = ASIC_WAVEFORM_STEP;
+      s[k] += amplitude*asic_response(k + (first - (double)t0))
+              - (w0*k0[k] + w1*k1[k]);
+   }
+}
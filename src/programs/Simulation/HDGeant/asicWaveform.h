@@ -0,0 +1,20 @@
+/*
+ * asicWaveform.h - tabulated ASIC response for drift-cluster waveforms
+ *
+ * asic_response(t) is sampled once, at ASIC_WAVEFORM_PHASES sub-ns
+ * phases for every 1 ns sample, so that a waveform can be built by
+ * adding each cluster's pulse into only the samples it reaches,
+ * with no transcendental calls per sample.
+ */
+
+#if !defined(_ASICWAVEFORM_H_)
+#define _ASICWAVEFORM_H_
+
+#define ASIC_WAVEFORM_PHASES 32
+#define ASIC_WAVEFORM_LENGTH 320   /* ns, pulse is negligible beyond this */
+
+float* asicWaveformBuffer(int num_samples);
+void asicWaveformAddPulse(float* samples, int num_samples,
+                          float t0, double amplitude);
+
+#endif /* _ASICWAVEFORM_H_ */
@@ -2,55 +2,176 @@
  * bintree.c - library for managing binary tree of hits pointers
  *
  *	version 1.0 	-Richard Jones July 16, 2001
+ *
+ * The hits are no longer kept in an actual binary tree: the marks
+ * used by the hit routines are often assigned in sequence, which
+ * turned the tree into a linked list, and every node was a separate
+ * malloc. The twigs now come from an arena of fixed-size blocks and
+ * are found through a hash index on the mark. They are sorted by mark
+ * on the first call to pickTwig, so they come out in the same order
+ * as before. When the last twig is picked the arena and index are
+ * reset, but not freed, ready for the next event.
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <bintree.h>
 
-void** getTwig(binTree_t** tree, int mark)
+#define TWIG_BLOCK_SIZE 1024
+#define INITIAL_SLOTS 2048
+
+static unsigned int hashMark(int mark, int slots)
+{
+   unsigned int h = (unsigned int)mark * 2654435761U;
+   return (h ^ (h >> 16)) & (slots - 1);
+}
+
+static binTree_t* newRegistry()
+{
+   binTree_t* reg = malloc(sizeof(binTree_t));
+   assert (reg != 0);
+   reg->count = 0;
+   reg->blocks = 0;
+   reg->arena = 0;
+   reg->slots = INITIAL_SLOTS;
+   reg->index = calloc(reg->slots, sizeof(binTwig_t*));
+   reg->order = 0;
+   reg->ordered = 0;
+   reg->norder = 0;
+   reg->next = 0;
+   assert (reg->index != 0);
+   return reg;
+}
+
+static binTwig_t* newTwig(binTree_t* reg)
+{
+   int block = reg->count / TWIG_BLOCK_SIZE;
+   if (block == reg->blocks)
+   {
+      reg->blocks++;
+      reg->arena = realloc(reg->arena, reg->blocks*sizeof(binTwig_t*));
+      reg->order = realloc(reg->order,
+                           reg->blocks*TWIG_BLOCK_SIZE*sizeof(binTwig_t*));
+      assert (reg->arena != 0 && reg->order != 0);
+      reg->arena[block] = malloc(TWIG_BLOCK_SIZE*sizeof(binTwig_t));
+      assert (reg->arena[block] != 0);
+   }
+   return &reg->arena[block][reg->count++ % TWIG_BLOCK_SIZE];
+}
+
+static void growIndex(binTree_t* reg)
+{
+   int i;
+   free(reg->index);
+   reg->slots *= 2;
+   reg->index = calloc(reg->slots, sizeof(binTwig_t*));
+   assert (reg->index != 0);
+   for (i=0; i < reg->count; ++i)
+   {
+      binTwig_t* twig = &reg->arena[i / TWIG_BLOCK_SIZE][i % TWIG_BLOCK_SIZE];
+      unsigned int slot = hashMark(twig->mark, reg->slots);
+      while (reg->index[slot])
+      {
+         slot = (slot + 1) & (reg->slots - 1);
+      }
+      reg->index[slot] = twig;
+   }
+}
+
+static int compareTwigs(const void* a, const void* b)
+{
+   int ma = (*(binTwig_t**)a)->mark;
+   int mb = (*(binTwig_t**)b)->mark;
+   return (ma < mb)? -1 : (ma > mb);
+}
+
+static void sortTwigs(binTree_t* reg)
 {
-   binTree_t* node = *tree;
-   if (node == 0)
+   int i, sorted = 1;
+   reg->norder = 0;
+   for (i=0; i < reg->count; ++i)
+   {
+      binTwig_t* twig = &reg->arena[i / TWIG_BLOCK_SIZE][i % TWIG_BLOCK_SIZE];
+      if (twig->picked == 0)
+      {
+         if (reg->norder > 0 && twig->mark < reg->order[reg->norder-1]->mark)
+         {
+            sorted = 0;
+         }
+         reg->order[reg->norder++] = twig;
+      }
+   }
+   if (!sorted)
    {
-      node = *tree = malloc(sizeof(binTree_t));
-      node->mark = mark;
-      node->left = 0;
-      node->right = 0;
-      node->this_node = 0;
-      return &node->this_node;
+      qsort(reg->order, reg->norder, sizeof(binTwig_t*), compareTwigs);
    }
-   else if (mark == node->mark)
+   reg->next = 0;
+   reg->ordered = 1;
+}
+
+void** getTwig(binTree_t** tree, int mark)
+{
+   binTree_t* reg = *tree;
+   binTwig_t* twig;
+   unsigned int slot;
+   if (reg == 0)
    {
-      return &node->this_node;
+      reg = *tree = newRegistry();
    }
-   else if (mark < node->mark)
+   slot = hashMark(mark, reg->slots);
+   while ((twig = reg->index[slot]))
    {
-      return getTwig(&node->left, mark);
+      if (twig->mark == mark)
+      {
+         if (twig->picked)
+         {
+            twig->picked = 0;
+            twig->this_node = 0;
+            reg->ordered = 0;
+         }
+         return &twig->this_node;
+      }
+      slot = (slot + 1) & (reg->slots - 1);
    }
-   else
+   if (2*(reg->count + 1) > reg->slots)
    {
-      assert (node->mark >= 0);
-      return getTwig(&node->right, mark);
+      growIndex(reg);
+      return getTwig(tree, mark);
    }
+   twig = newTwig(reg);
+   twig->mark = mark;
+   twig->picked = 0;
+   twig->this_node = 0;
+   reg->index[slot] = twig;
+   reg->ordered = 0;
+   return &twig->this_node;
 }
 
 void* pickTwig(binTree_t** tree)
 {
-   binTree_t* node = *tree;
-   if (node == 0)
+   binTree_t* reg = *tree;
+   if (reg == 0 || reg->count == 0)
    {
       return 0;
    }
-   else if (node->left)
+   else if (!reg->ordered)
+   {
+      sortTwigs(reg);
+   }
+   if (reg->next < reg->norder)
    {
-      return pickTwig(&node->left);
+      binTwig_t* twig = reg->order[reg->next++];
+      twig->picked = 1;
+      return twig->this_node;
    }
    else
    {
-      void* twig = node->this_node;
-      *tree = node->right;
-      free(node);
-      return twig;
+      memset(reg->index, 0, reg->slots*sizeof(binTwig_t*));
+      reg->count = 0;
+      reg->ordered = 0;
+      reg->norder = 0;
+      reg->next = 0;
+      return 0;
    }
 }
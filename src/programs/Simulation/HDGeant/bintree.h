@@ -1,8 +1,27 @@
-typedef struct hitTree_s {
+/*
+ * The "tree" is an event-scoped registry of hit pointers keyed by an
+ * integer mark. getTwig finds or creates the entry for a mark, and
+ * pickTwig hands the entries back in increasing order of mark. Once
+ * the last one has been picked, the registry is emptied in one step
+ * and its storage is kept for the next event.
+ */
+
+typedef struct binTwig_s {
   int mark;
-  struct hitTree_s* left;
-  struct hitTree_s* right;
+  int picked;
   void* this_node;
+} binTwig_t;
+
+typedef struct hitTree_s {
+  int count;              /* twigs in use */
+  int blocks;             /* arena blocks allocated */
+  binTwig_t** arena;      /* blocks of twigs, never moved once allocated */
+  int slots;              /* size of index, a power of 2 */
+  binTwig_t** index;      /* open-addressed hash on mark */
+  binTwig_t** order;      /* unpicked twigs sorted by mark */
+  int ordered;            /* order is up to date */
+  int norder;
+  int next;               /* next entry in order to be picked */
 } binTree_t;
 
 void** getTwig(binTree_t** tree, int mark);
@@ -1,9 +1,11 @@
 
 #include <stdlib.h>
+#include <math.h>
 #include <dlfcn.h>
 #include <unistd.h>
 
 #include <iostream>
+#include <chrono>
 #include <vector>
 #include <string>
 using namespace std;
@@ -19,6 +21,7 @@ using namespace std;
 #include "HDGEOMETRY/DMagneticFieldMapNoField.h"
 #include "HDGEOMETRY/DMagneticFieldMapPSConst.h"
 #include "HDGEOMETRY/DMagneticFieldMapPS2DMap.h"
+#include "CALIB_SNAPSHOT/JCalibrationSnapshot.h"
 
 extern "C" {
 #include "calibDB.h"
@@ -50,6 +53,49 @@ DMagneticFieldMap *Bmap=NULL;
 DMagneticFieldMapPS *PS_Bmap=NULL;
 static JCalibration *jcalib=NULL;
 
+// Regular-grid cache of the solenoid field, filled once by
+// initcalibdb_ when the BFIELDCACHE card is set. Within the grid
+// gufld_db_ interpolates trilinearly instead of asking Bmap; points
+// outside it still go to Bmap. In the outermost layer of cells the
+// interpolation is blended into the Bmap value, so that the field is
+// continuous across the edge of the grid.
+static const float BCACHE_XYMAX = 100.;   // cm, grid covers |x|,|y| <= XYMAX
+static const float BCACHE_ZMIN = -100.;   // cm
+static const float BCACHE_ZMAX = 650.;    // cm
+
+struct BfieldGrid {
+   float x0, y0, z0;
+   float inv_step;
+   int nx, ny, nz;
+   vector<float> B;   // Bx,By,Bz at each node, x index fastest
+};
+static BfieldGrid *Bgrid=NULL;
+
+// Corner values of the last grid cell used. Consecutive lookups
+// along a track mostly land in the same cell.
+static int Bcell_index=-1;
+static float Bcell[8][3];
+
+static void BuildFieldCache(float step);
+static bool GetCachedField(const float *r, float *B);
+
+// Time spent getting calibration constants, reported by
+// PrintCalibDBSummary at the end of the job so that reading
+// from the database and from a snapshot file can be compared.
+static double calib_seconds=0;
+static unsigned int calib_requests=0;
+static string calib_snapshot_list;
+
+struct CalibTimer {
+   std::chrono::steady_clock::time_point start;
+   CalibTimer() : start(std::chrono::steady_clock::now()) {}
+   ~CalibTimer() {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      calib_seconds += elapsed.count();
+      ++calib_requests;
+   }
+};
+
 extern "C" {
    void md5geom_wrapper_(char *md5);
 }
@@ -67,8 +113,16 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
      exit(-1) ;
    }
 
-   // Get the JCalibration object
-   jcalib = japp->GetJCalibration(*runno);
+   // Get the JCalibration object. Only the calls to jcalib are timed
+   // here, not the setup of the field maps.
+   {
+      CalibTimer timer;
+      jcalib = japp->GetJCalibration(*runno);
+   }
+
+   gPARMS->SetDefaultParameter("CALIB:SNAPSHOT_LIST", calib_snapshot_list,
+                               "Append the names of the calibration tables used to this file,"
+                               " for making a snapshot with calib_snapshot");
  
    // The actual DMagneticFieldMap subclass can be specified in
    // the control.in file. Since it is read in as integers of
@@ -102,7 +156,12 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
           
        // see if we can load the name of the magnetic field map to use from the calib DB
        map<string,string> bfield_map_name;
-       if(jcalib->GetCalib("/Magnets/Solenoid/solenoid_map", bfield_map_name)) {
+       bool failed;
+       {
+          CalibTimer timer;
+          failed = jcalib->GetCalib("/Magnets/Solenoid/solenoid_map", bfield_map_name);
+       }
+       if(failed) {
 	 // if we can't find information in the CCDB, then quit with an error message
 	 _DBG_<<ccdb_help<<endl;
 	 exit(-1);
@@ -131,6 +190,9 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
      exit(-1);
    }   
 
+   if(Bmap && controlparams_.bfieldcache > 0.)
+     BuildFieldCache(controlparams_.bfieldcache);
+
    // also load the PS magnet field map similarly to the solenoid field map above
    if(PS_bfield_type[0] == 0)strcpy(PS_bfield_type, "CalibDB");
    string PS_bfield_type_str(PS_bfield_type);
@@ -152,7 +214,12 @@ void initcalibdb_(char *bfield_type, char *bfield_map, char *PS_bfield_type, cha
           
        // see if we can load the name of the magnetic field map to use from the calib DB
        map<string,string> PS_bfield_map_name;
-       if(jcalib->GetCalib("/Magnets/PairSpectrometer/ps_magnet_map", PS_bfield_map_name)) {
+       bool failed;
+       {
+          CalibTimer timer;
+          failed = jcalib->GetCalib("/Magnets/PairSpectrometer/ps_magnet_map", PS_bfield_map_name);
+       }
+       if(failed) {
 	 // if we can't find information in the CCDB, then quit with an error message
 	 _DBG_<<PS_ccdb_help<<endl;
 	 exit(-1);
@@ -220,6 +287,9 @@ void gufld_db_(float *r, float *B)
   }
   
 
+   if(Bgrid && GetCachedField(r, B))
+      return;
+
    if(!Bmap){
       _DBG_<<"Call to gufld_db when Bmap not intialized! Exiting."<<endl;
       exit(-1);
@@ -237,11 +307,120 @@ void gufld_db_(float *r, float *B)
    B[2] = Bz;
 }
 
+//----------------
+// gufld_db_batch_
+//----------------
+void gufld_db_batch_(int *n, float *r, float *B)
+{
+   /// Field at the *n points r[3*i..3*i+2], returned in B[3*i..3*i+2].
+   /// Saves a call per point, and points close together share the
+   /// cached grid cell.
+   for(int i=0; i<*n; i++)
+      gufld_db_(&r[3*i], &B[3*i]);
+}
+
+//----------------
+// BuildFieldCache
+//----------------
+static void BuildFieldCache(float step)
+{
+   Bgrid = new BfieldGrid;
+   Bgrid->x0 = -BCACHE_XYMAX;
+   Bgrid->y0 = -BCACHE_XYMAX;
+   Bgrid->z0 = BCACHE_ZMIN;
+   Bgrid->inv_step = 1.0/step;
+   Bgrid->nx = (int)ceil(2*BCACHE_XYMAX/step) + 1;
+   Bgrid->ny = Bgrid->nx;
+   Bgrid->nz = (int)ceil((BCACHE_ZMAX - BCACHE_ZMIN)/step) + 1;
+
+   size_t nodes = (size_t)Bgrid->nx*Bgrid->ny*Bgrid->nz;
+   cout << "Caching solenoid field on a " << Bgrid->nx << "x" << Bgrid->ny
+        << "x" << Bgrid->nz << " grid (" << step << " cm, "
+        << nodes*3*sizeof(float)/(1<<20) << " MB)" << endl;
+   Bgrid->B.resize(3*nodes);
+
+   float *B = &Bgrid->B[0];
+   for(int iz=0; iz<Bgrid->nz; iz++){
+      double z = Bgrid->z0 + iz*step;
+      for(int iy=0; iy<Bgrid->ny; iy++){
+         double y = Bgrid->y0 + iy*step;
+         for(int ix=0; ix<Bgrid->nx; ix++, B+=3){
+            double x = Bgrid->x0 + ix*step;
+            double Bx, By, Bz;
+            Bmap->GetField(x, y, z, Bx, By, Bz);
+            B[0] = Bx;
+            B[1] = By;
+            B[2] = Bz;
+         }
+      }
+   }
+}
+
+//----------------
+// GetCachedField
+//----------------
+static bool GetCachedField(const float *r, float *B)
+{
+   /// Interpolate the cached grid at r. Returns false if r is
+   /// outside the grid.
+   float u = (r[0] - Bgrid->x0)*Bgrid->inv_step;
+   float v = (r[1] - Bgrid->y0)*Bgrid->inv_step;
+   float w = (r[2] - Bgrid->z0)*Bgrid->inv_step;
+   if(!(u >= 0. && v >= 0. && w >= 0.)) return false;
+   int ix = (int)u;
+   int iy = (int)v;
+   int iz = (int)w;
+   int nx = Bgrid->nx;
+   int nxy = nx*Bgrid->ny;
+   if(ix >= nx-1 || iy >= Bgrid->ny-1 || iz >= Bgrid->nz-1) return false;
+
+   int cell = ix + nx*iy + nxy*iz;
+   if(cell != Bcell_index){
+      for(int c=0; c<8; c++){
+         int node = cell + (c&1) + nx*((c>>1)&1) + nxy*(c>>2);
+         const float *Bn = &Bgrid->B[3*node];
+         Bcell[c][0] = Bn[0];
+         Bcell[c][1] = Bn[1];
+         Bcell[c][2] = Bn[2];
+      }
+      Bcell_index = cell;
+   }
+
+   float fx = u - ix;
+   float fy = v - iy;
+   float fz = w - iz;
+   for(int k=0; k<3; k++){
+      float b00 = Bcell[0][k] + fx*(Bcell[1][k] - Bcell[0][k]);
+      float b10 = Bcell[2][k] + fx*(Bcell[3][k] - Bcell[2][k]);
+      float b01 = Bcell[4][k] + fx*(Bcell[5][k] - Bcell[4][k]);
+      float b11 = Bcell[6][k] + fx*(Bcell[7][k] - Bcell[6][k]);
+      float b0 = b00 + fy*(b10 - b00);
+      float b1 = b01 + fy*(b11 - b01);
+      B[k] = b0 + fz*(b1 - b0);
+   }
+
+   // Weight of the direct lookup: 1 on the outer faces of the grid,
+   // falling to 0 one cell inside them
+   float s = 0.;
+   s = fmax(s, fmax(1. - u, u - (nx - 2)));
+   s = fmax(s, fmax(1. - v, v - (Bgrid->ny - 2)));
+   s = fmax(s, fmax(1. - w, w - (Bgrid->nz - 2)));
+   if(s > 0.){
+      double Bx, By, Bz;
+      Bmap->GetField(r[0], r[1], r[2], Bx, By, Bz);
+      B[0] += s*(Bx - B[0]);
+      B[1] += s*(By - B[1]);
+      B[2] += s*(Bz - B[2]);
+   }
+   return true;
+}
+
 //----------------
 // GetCalib
 //----------------
 int GetCalib(const char* namepath, unsigned int *Nvals, float* vals)
 {
+   CalibTimer timer;
    /// C-callable routine for accessing calibration constants.
    /// The values specified by "namepath" will be read into the array
    /// "vals". The "vals" array should have enough memory allocated
@@ -272,6 +451,7 @@ int GetCalib(const char* namepath, unsigned int *Nvals, float* vals)
 void GetLorentzDeflections(float *lorentz_x, float *lorentz_z, float **lorentz_nx, float **lorentz_nz
    , const unsigned int Nxpoints, const unsigned int Nzpoints)
 {
+   CalibTimer timer;
    /// C-callable routine for accessing calibration constants.
    /// The values specified by "namepath" will be read into the array
    /// "vals". The "vals" array should have enough memory allocated
@@ -322,6 +502,7 @@ void GetLorentzDeflections(float *lorentz_x, float *lorentz_z, float **lorentz_n
 //----------------
 int GetConstants(const char* namepath, int *Nvals, float* vals, mystr_t *strings)
 {
+   CalibTimer timer;
    /// C-callable routine for accessing calibration constants.
    /// The values specified by "namepath" will be read into the array
    /// "vals". The "vals" array should have enough memory allocated
@@ -360,6 +541,7 @@ int GetConstants(const char* namepath, int *Nvals, float* vals, mystr_t *strings
 //----------------
 // Get a single column from the database by its key (string)
 int GetColumn(const char* namepath, int *Nvals, float* vals, char *key_cstr){
+   CalibTimer timer;
  
    if(!jcalib){
       _DBG_<<"ERROR - GetColumn() called when jcalib not set!"<<endl;
@@ -398,6 +580,7 @@ int GetColumn(const char* namepath, int *Nvals, float* vals, char *key_cstr){
 //----------------
 int GetArrayConstants(const char* namepath, int *Nvals, float* vals, mystr_t *strings)
 {
+   CalibTimer timer;
    /// C-callable routine for accessing calibration constants.
    /// The values specified by "namepath" will be read into the array
    /// "vals". The "vals" array should have enough memory allocated
@@ -435,6 +618,27 @@ int GetArrayConstants(const char* namepath, int *Nvals, float* vals, mystr_t *st
    return 0; // return 0 if OK, 1 if not
 }
 
+//------------------
+// PrintCalibDBSummary
+//------------------
+void PrintCalibDBSummary(void)
+{
+   /// Report the time spent getting calibration constants and,
+   /// if CALIB:SNAPSHOT_LIST is set, record the tables that were used.
+
+   if(!jcalib) return;
+
+   cout<<"Calibration constants: "<<calib_requests<<" requests took "
+       <<calib_seconds<<" s from "<<jcalib->GetURL()<<endl;
+
+   if(calib_snapshot_list.size()>0){
+      if(WriteCalibAccessList(jcalib, calib_snapshot_list))
+         cout<<"Calibration tables used were added to "<<calib_snapshot_list<<endl;
+      else
+         _DBG_<<"ERROR - unable to write "<<calib_snapshot_list<<endl;
+   }
+}
+
 //------------------
 // GetMD5Geom
 //------------------
@@ -15,6 +15,7 @@ typedef struct {
 void initcalibdb_(char *bfield_type, char *bfield_map,
 		  char *PS_bfield_type, char *PS_bfield_map,int *runno);
 void gufld_db_(float *r, float *B);
+void gufld_db_batch_(int *n, float *r, float *B);
 void gufld_ps_(float *r, float *B);
 int GetCalib(const char* namepath, unsigned int *Nvals, float* vals);
 void GetLorentzDeflections(float *lorentz_x, float *lorentz_z, 
@@ -24,3 +25,4 @@ void GetLorentzDeflections(float *lorentz_x, float *lorentz_z,
 int GetConstants(const char* namepath, int *Nvals, float* vals, mystr_t* strings);
 int GetArrayConstants(const char* namepath, int *Nvals, float* vals, mystr_t* strings);
 int GetColumn(const char* namepath, int *Nvals, float* vals, char *key_cstr);
+void PrintCalibDBSummary(void);
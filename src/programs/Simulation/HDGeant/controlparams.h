@@ -15,6 +15,8 @@ typedef struct {
 	float trigger_time_signa_ns;
 	int event_count;
 	int override_run_number;
+	float bfieldcache;
+	int outputqueue;
 }controlparams_t;
 extern controlparams_t controlparams_;
 
@@ -0,0 +1,219 @@
+/*
+ * frame_bench - times the coordinate transformations of the HDGeant hit
+ *               routines, looked up by frame name with transformCoord
+ *               and by frame handle with transformFrame
+ *
+ *        The GEANT volume path in /GCVOLU/ is filled in by hand with a
+ *        synthetic geometry, so no geometry has to be loaded.  Each
+ *        path has NLEVEL levels named HALL, DETC, BCAL, ... with a
+ *        rotation at two out of every three levels.  A "track" makes
+ *        NSTEPS steps in one volume before moving to the next path.
+ *
+ *        Before timing, both routines are run on all frame pairs of
+ *        several paths.  Transformations to or from the global frame
+ *        must agree bit for bit; the others are composed differently
+ *        and must agree to within float rounding.  The program exits
+ *        with a non-zero status if they do not.
+ *
+ *        Usage: frame_bench [ncalls [nsteps]]   (default 10000000 20)
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <particleType.h>
+#include <geant3.h>
+
+#define MAXLEVELS 15
+#define NLEVELS 6
+#define NPATHS 16
+
+typedef struct {
+   int nlevel;
+   int names[MAXLEVELS];
+   int number[MAXLEVELS];
+   int lvolum[MAXLEVELS];
+   int lindex[MAXLEVELS];
+   int infrom;
+   int nlevmx;
+   int nldev[MAXLEVELS];
+   int linmx[MAXLEVELS];
+   float gtran[MAXLEVELS][3];
+   float grmat[MAXLEVELS][10];
+   float gonly[MAXLEVELS];
+   float glx[3];
+} gcvolu_t;
+
+extern gcvolu_t gcvolu_;
+
+/* the synthetic volume paths, made once so that moving to a new path
+ * costs the timing loops no more than a copy */
+static gcvolu_t paths[NPATHS];
+
+static const char *levelNames[NLEVELS] = {"HALL", "DETC", "BCAL",
+                                          "BMOD", "BSEC", "BLYR"};
+
+/* fill in path number ipath, with copy number ipath+1 at every level
+ * below the hall, and the accumulated global transformation of each
+ * level as GEANT keeps it in /GCVOLU/ */
+static void makePath(int ipath)
+{
+   gcvolu_t *path = &paths[ipath];
+   int level;
+   memset(path, 0, sizeof(gcvolu_t));
+   path->nlevel = NLEVELS;
+   for (level = 0; level < NLEVELS; ++level) {
+      float angle = 0.3 * (level + 1) + 0.1 * ipath;
+      memcpy(&path->names[level], levelNames[level], 4);
+      path->lvolum[level] = level + 1;
+      path->number[level] = (level == 0)? 1 : ipath + 1;
+      if (level > 0 && (level + 1) % 3 != 0) {
+         path->grmat[level][0] = cos(angle);
+         path->grmat[level][1] = sin(angle);
+         path->grmat[level][3] = -sin(angle);
+         path->grmat[level][4] = cos(angle);
+         path->grmat[level][8] = 1;
+         path->grmat[level][9] = 1;
+      }
+      path->gtran[level][0] = (level == 0)? 0 : 10. * level + ipath;
+      path->gtran[level][1] = (level == 0)? 0 : -5. * level;
+      path->gtran[level][2] = (level == 0)? 0 : 100. * level + 0.37;
+   }
+}
+
+static void setPath(int ipath)
+{
+   gcvolu_ = paths[ipath];
+}
+
+static double now_ns()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* check transformFrame against transformCoord for every pair of
+ * frames, returns the number of failures */
+static int checkFrames(const char **frames, int *handles, int nframes)
+{
+   int nfail = 0;
+   int nexact = 0;
+   int ntotal = 0;
+   double maxdiff = 0;
+   int ipath, i, a, b, k;
+   for (ipath = 0; ipath < NPATHS; ++ipath) {
+      setPath(ipath);
+      for (i = 0; i < 100; ++i) {
+         float x[3];
+         x[0] = rand() % 1000 - 500.;
+         x[1] = (rand() % 1000) * 0.37;
+         x[2] = (rand() % 1000) * 1.1;
+         for (a = 0; a < nframes; ++a) {
+            for (b = 0; b < nframes; ++b) {
+               float ycoord[3];
+               float yframe[3];
+               int exact = 1;
+               transformCoord(x,frames[a],ycoord,frames[b]);
+               transformFrame(x,handles[a],yframe,handles[b]);
+               for (k = 0; k < 3; ++k) {
+                  double diff = fabs(ycoord[k] - yframe[k]);
+                  double scale = fabs(ycoord[k]) + 1000.;
+                  if (ycoord[k] != yframe[k])
+                     exact = 0;
+                  if (diff > maxdiff)
+                     maxdiff = diff;
+                  if (diff > 1e-5 * scale)
+                     ++nfail;
+               }
+               if (handles[a] == FRAME_GLOBAL || handles[b] == FRAME_GLOBAL) {
+                  if (!exact)
+                     ++nfail;
+               }
+               nexact += exact;
+               ++ntotal;
+            }
+         }
+      }
+   }
+   printf("%d of %d transformations bit-identical, largest difference "
+          "%g cm\n", nexact, ntotal, maxdiff);
+   return nfail;
+}
+
+/* time ncalls transformations from frame a to frame b, moving to the
+ * next path every nsteps calls */
+static void timeFrames(const char *a, const char *b, long ncalls, int nsteps)
+{
+   int ha = frameHandle(a);
+   int hb = frameHandle(b);
+   float x[3] = {1., 2., 3.};
+   float y[3];
+   double sum = 0;
+   double t0, t1, t2;
+   long i;
+
+   setPath(0);
+   t0 = now_ns();
+   for (i = 0; i < ncalls; ++i) {
+      if (i % nsteps == 0)
+         setPath((i / nsteps) % NPATHS);
+      x[0] += 1e-6;
+      transformCoord(x,a,y,b);
+      sum += y[0];
+   }
+   t1 = now_ns();
+   for (i = 0; i < ncalls; ++i) {
+      if (i % nsteps == 0)
+         setPath((i / nsteps) % NPATHS);
+      x[0] += 1e-6;
+      transformFrame(x,ha,y,hb);
+      sum += y[0];
+   }
+   t2 = now_ns();
+   printf("%-8s -> %-8s %10.1f %10.1f %8.2f\n", a, b,
+          (t1 - t0) / ncalls, (t2 - t1) / ncalls, (t1 - t0) / (t2 - t1));
+   if (sum == 0)
+      printf("\n");   /* keep the loops from being optimized away */
+}
+
+int main(int argc, char *argv[])
+{
+   const char *frames[NLEVELS + 1];
+   int handles[NLEVELS + 1];
+   long ncalls = (argc > 1)? atol(argv[1]) : 10000000;
+   int nsteps = (argc > 2)? atoi(argv[2]) : 20;
+   int nframes = 0;
+   int level;
+
+   if (ncalls < 1 || nsteps < 1) {
+      printf("Usage: frame_bench [ncalls [nsteps]]\n");
+      return 1;
+   }
+
+   for (level = 0; level < NPATHS; ++level)
+      makePath(level);
+
+   frames[nframes++] = "global";
+   frames[nframes++] = "local";
+   for (level = 1; level < NLEVELS - 1; ++level)
+      frames[nframes++] = levelNames[level];
+   for (level = 0; level < nframes; ++level)
+      handles[level] = frameHandle(frames[level]);
+   if (checkFrames(frames, handles, nframes) > 0) {
+      printf("transformFrame does not agree with transformCoord\n");
+      return 1;
+   }
+
+   printf("\n%d steps per volume, ns per call:\n", nsteps);
+   printf("%-20s %10s %10s %8s\n", "frames", "by name", "by handle",
+          "speedup");
+   timeFrames("global", "local", ncalls, nsteps);
+   timeFrames("local", "global", ncalls, nsteps);
+   timeFrames("global", "BCAL", ncalls, nsteps);
+   timeFrames("local", "BCAL", ncalls, nsteps);
+   return 0;
+}
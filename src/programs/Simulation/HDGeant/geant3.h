@@ -20,9 +20,25 @@ void grndm_(float v[], int* len);
 #define transformCoord(xin,sin,xout,sout) \
    transformcoord_(xin,sin,xout,sout,strlen(sin),strlen(sout))
 
+/* the same transformation with the frames given as integer handles, which
+ * skips the name lookup and reuses the matrices while the track stays in
+ * the same volume; look the handles of named volumes up once with
+ * frameHandle and keep them, global and local have fixed handles */
+
+#define FRAME_GLOBAL 1
+#define FRAME_LOCAL 2
+
+#define frameHandle(name) framehandle_(name,strlen(name))
+
+#define transformFrame(xin,hin,xout,hout) \
+   do { int hin_ = (hin), hout_ = (hout); \
+        transformframe_(xin,&hin_,xout,&hout_); } while (0)
+
 
 /* Type declarations to avoid "implicit function declaration" errors */
 void transformcoord_(float* xin, const char* sin, float* xout, const char* sout, int, int);
+int framehandle_(const char* name, int);
+void transformframe_(float* xin, int* hin, float* xout, int* hout);
 int getsector_(void);
 int getlayer_(void);
 int getmodule_(void);
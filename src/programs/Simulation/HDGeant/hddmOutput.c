@@ -8,6 +8,13 @@
  *      flushOutput() - flush current event structure to output stream
  *	closeOutput() - close currently open output stream
  *
+ * Unless the OUTPUTQUEUE card is set to 0, flushOutput does not write the
+ * event itself but hands it over to a writer thread through a bounded
+ * queue, so that packing and writing one event overlaps with tracking
+ * the next.  There is a single producer and a single consumer, so events
+ * reach the file in the order they were flushed.  The queue is drained
+ * by closeOutput, or at exit if the job ends without calling it.
+ *
  * Richard Jones
  * University of Connecticut
  * July 13, 2001
@@ -16,9 +23,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 
 #include <HDDM/hddm_s.h>
 #include <hddmOutput.h>
+#include <controlparams.h>
 
 #include "memcheck.h"
 
@@ -30,22 +40,149 @@ extern s_HDDM_t* thisInputEvent;
 
 static unsigned int Nevents = 0;
 
+static s_HDDM_t** outputQueue = 0;
+static int outputQueueSize = 0;
+static int outputQueueHead = 0;
+static int outputQueueCount = 0;
+static int outputWriterDone = 0;
+static pthread_t outputWriter;
+static pthread_mutex_t outputLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t outputNotEmpty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t outputNotFull = PTHREAD_COND_INITIALIZER;
+
+static unsigned long outputWritten = 0;
+static unsigned long outputStalls = 0;
+static double outputStallTime = 0;
+static double outputWriteTime = 0;
+static double outputStartTime = 0;
+
+static double wallTime ()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void writeOutputEvent (s_HDDM_t* event)
+{
+   double start = wallTime();
+   if (flush_s_HDDM(event, thisOutputStream) != 0) {
+      fprintf(stderr,"Fatal error in flushOutput:");
+      fprintf(stderr," write failed to hddm output file.\n");
+      exit(7);
+   }
+   outputWriteTime += wallTime() - start;
+   ++outputWritten;
+}
+
+static void* outputWriterThread (void* arg)
+{
+   pthread_mutex_lock(&outputLock);
+   while (1) {
+      s_HDDM_t* event;
+      while (outputQueueCount == 0 && !outputWriterDone) {
+         pthread_cond_wait(&outputNotEmpty, &outputLock);
+      }
+      if (outputQueueCount == 0) {
+         break;
+      }
+      event = outputQueue[outputQueueHead];
+      outputQueueHead = (outputQueueHead + 1) % outputQueueSize;
+      --outputQueueCount;
+      pthread_cond_signal(&outputNotFull);
+      pthread_mutex_unlock(&outputLock);
+      writeOutputEvent(event);
+      pthread_mutex_lock(&outputLock);
+   }
+   pthread_mutex_unlock(&outputLock);
+   return 0;
+}
+
+static void queueOutputEvent (s_HDDM_t* event)
+{
+   pthread_mutex_lock(&outputLock);
+   if (outputQueueCount == outputQueueSize) {
+      double start = wallTime();
+      ++outputStalls;
+      while (outputQueueCount == outputQueueSize) {
+         pthread_cond_wait(&outputNotFull, &outputLock);
+      }
+      outputStallTime += wallTime() - start;
+   }
+   outputQueue[(outputQueueHead + outputQueueCount) % outputQueueSize] = event;
+   ++outputQueueCount;
+   pthread_cond_signal(&outputNotEmpty);
+   pthread_mutex_unlock(&outputLock);
+}
+
+static void stopOutputWriter ()
+{
+   if (outputQueue == 0) {
+      return;
+   }
+   pthread_mutex_lock(&outputLock);
+   outputWriterDone = 1;
+   pthread_cond_signal(&outputNotEmpty);
+   pthread_mutex_unlock(&outputLock);
+   pthread_join(outputWriter, 0);
+   free(outputQueue);
+   outputQueue = 0;
+}
+
+static void closeOutputAtExit ()
+{
+   /* a fatal write error exits from the writer thread itself,
+    * in which case there is nothing left that can be saved */
+   if (outputQueue != 0 && pthread_equal(pthread_self(), outputWriter)) {
+      return;
+   }
+   if (thisOutputStream) {
+      fprintf(stderr,"hddmOutput: job ending without closeOutput,");
+      fprintf(stderr," writing the events still queued.\n");
+      closeOutput();
+   }
+}
+
 int openOutput (char* filename)
 {
+   static int atexitRegistered = 0;
    set_s_HDDM_buffersize(25000000);
    set_s_HDDM_stringsize(25000000);
    thisOutputStream = init_s_HDDM(filename);
-   return (thisOutputStream == 0);
+   if (thisOutputStream == 0) {
+      return 1;
+   }
+   if (!atexitRegistered) {
+      atexit(closeOutputAtExit);
+      atexitRegistered = 1;
+   }
+   outputWritten = outputStalls = 0;
+   outputStallTime = outputWriteTime = 0;
+   outputStartTime = wallTime();
+   if (controlparams_.outputqueue > 0) {
+      outputQueueSize = controlparams_.outputqueue;
+      outputQueue = malloc(outputQueueSize * sizeof(s_HDDM_t*));
+      outputQueueHead = outputQueueCount = 0;
+      outputWriterDone = 0;
+      if (pthread_create(&outputWriter, 0, outputWriterThread, 0) != 0) {
+         fprintf(stderr,"hddmOutput: could not start the writer thread,");
+         fprintf(stderr," writing events synchronously.\n");
+         free(outputQueue);
+         outputQueue = 0;
+      }
+   }
+   return 0;
 }
 
 int flushOutput ()
 {
    if (thisOutputEvent != 0)
    {
-      if (flush_s_HDDM(thisOutputEvent, thisOutputStream) != 0) {
-         fprintf(stderr,"Fatal error in flushOutput:");
-         fprintf(stderr," write failed to hddm output file.\n");
-         exit(7);
+      if (outputQueue) {
+         queueOutputEvent(thisOutputEvent);
+      }
+      else {
+         writeOutputEvent(thisOutputEvent);
       }
       thisOutputEvent = 0;
    }
@@ -57,8 +194,21 @@ int closeOutput ()
 {
    if (thisOutputStream)
    {
+      int queued = (outputQueue != 0);
+      double elapsed;
+      stopOutputWriter();
       close_s_HDDM(thisOutputStream);
       thisOutputStream = 0;
+      elapsed = wallTime() - outputStartTime;
+      printf("hddmOutput: wrote %lu events in %.1f s (%.1f events/s),",
+             outputWritten, elapsed,
+             (elapsed > 0)? outputWritten / elapsed : 0);
+      printf(" %.1f s spent packing and writing\n", outputWriteTime);
+      if (queued) {
+         printf("hddmOutput: tracking waited on a full output queue"
+                " of %d events %lu times, for %.1f s in total\n",
+                outputQueueSize, outputStalls, outputStallTime);
+      }
    }
    return 0;
 }
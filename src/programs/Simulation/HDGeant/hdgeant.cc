@@ -7,6 +7,7 @@
 using namespace std;
 
 #include <DANA/DApplication.h>
+#include <CALIB_SNAPSHOT/JCalibrationSnapshot.h>
 
 
 // These are defined in copytoplusplus.cc
@@ -23,6 +24,7 @@ extern string HDDS_XML;
 extern "C" int hdgeant_(void); // define in hdgeant_f.F
 extern "C" void init_runtime_xml_(void); // defined in dl_routines.cc
 extern "C" const char* GetMD5Geom(void); // defined in calibDB.cc
+extern "C" void PrintCalibDBSummary(void); // defined in calibDB.cc
 
 void Usage(void);
 
@@ -38,6 +40,7 @@ int main(int narg, char *argv[])
 	// JCalibration object pointer. We want this to be done
 	// in the same way as all other sim-recon software
 	DApplication *dapp = new DApplication(narg, argv);
+	dapp->AddCalibrationGenerator(new JCalibrationGeneratorSnapshot());
 	dapp->Init();
 
 	// Set some defaults. Note that most defaults related to the
@@ -83,6 +86,7 @@ int main(int narg, char *argv[])
 
 	// Run hdgeant proper
 	int res = hdgeant_();
+	PrintCalibDBSummary();
 
 	// Optionally smear the resulting output file
 	if(POSTSMEAR && res == 0){
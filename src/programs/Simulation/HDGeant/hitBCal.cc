@@ -439,8 +439,11 @@ void hitBarrelEMcal (float xin[4], float xout[4],
    x[1] = (xin[1] + xout[1])/2;
    x[2] = (xin[2] + xout[2])/2;
    t    = (xin[3] + xout[3])/2 * 1e9;
-   transformCoord(x,"global",xlocal,"BCAL");
-   transformCoord(xHat,"local",xbcal,"BCAL");
+   static int bcalFrame = 0;
+   if (bcalFrame == 0)
+      bcalFrame = frameHandle("BCAL");
+   transformFrame(x,FRAME_GLOBAL,xlocal,bcalFrame);
+   transformFrame(xHat,FRAME_LOCAL,xbcal,bcalFrame);
 
 //cout << "track:" << track << " stack:" << stack << " history:" 
 //     << history << " ipart:" << ipart << endl;
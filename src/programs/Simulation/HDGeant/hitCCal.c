@@ -120,7 +120,10 @@ void hitComptonEMcal (float xin[4], float xout[4],
    x[1] = (xin[1] + xout[1])/2;
    x[2] = (xin[2] + xout[2])/2;
    t    = (xin[3] + xout[3])/2 * 1e9;
-   transformCoord(x,"global",xccal,"CCAL");
+   static int ccalFrame = 0;
+   if (ccalFrame == 0)
+      ccalFrame = frameHandle("CCAL");
+   transformFrame(x,FRAME_GLOBAL,xccal,ccalFrame);
 
    /* post the hit to the truth tree */
 
@@ -12,12 +12,14 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include <HDDM/hddm_s.h>
 #include <geant3.h>
 #include <bintree.h>
 #include <gid_map.h>
+#include <asicWaveform.h>
 
 #include "calibDB.h"
 extern s_HDDM_t* thisInputEvent;
@@ -36,6 +38,7 @@ void gpoiss_(float*,int*,const int*); // avoid solaris compiler warnings
 static float DRIFT_SPEED     = 0.0055;
 static float TWO_HIT_RESOL   = 25.;
 static int   MAX_HITS        = 1000;
+static int   INITIAL_HITS    = 4;      // must be a power of 2
 static float THRESH_KEV      = 1.;
 static float THRESH_MV       = 1.;
 static float STRAW_RADIUS    = 0.776;
@@ -57,21 +60,8 @@ static int itrack;
 
 /* void GetDOCA(int ipart, float x[3], float p[5], float doca[3]);  disabled 6/24/2009 */
 
-typedef int (*compfn)(const void*, const void*);
 extern void polint(float *xa, float *ya,int n,float x, float *y,float *dy);
 
-// Sort function for sorting clusters
-int cdc_cluster_sort(const void *a,const void *b) {
-   const s_CdcStrawTruthHit_t *ca=a;
-   const s_CdcStrawTruthHit_t *cb=b;
-   if (ca->t < cb->t)
-      return -1;
-   else if (ca->t > cb->t)
-      return 1;
-   else
-      return 0;
-}
-
 // Simulation of the ASIC response to a pulse due to a cluster
 double asic_response(double t) {
    double func=0;
@@ -89,23 +79,42 @@ double asic_response(double t) {
    return func;
 }
 
-// Simulation of signal on a wire
-double cdc_wire_signal(double t,s_CdcStrawTruthHits_t* chits) {
+// Simulation of signal on a wire, sampled in 1 ns bins
+float *cdc_wire_signal(int num_samples,s_CdcStrawTruthHits_t* chits) {
    int m;
    double asic_gain=0.5; // mV/fC
-   double func=0;
+   float *samples=asicWaveformBuffer(num_samples);
    for (m=0; m < chits->mult; m++) {
-      if (t > chits->in[m].t) {
-         double my_time=t-chits->in[m].t;
-         func+=asic_gain*chits->in[m].q*asic_response(my_time);
-      }
+      asicWaveformAddPulse(samples,num_samples,chits->in[m].t,
+                           asic_gain*chits->in[m].q);
    }
-   return func;
+   return samples;
+}
+
+/* The truth hit list of a straw starts with room for INITIAL_HITS
+ * and is doubled each time it fills up, so its capacity follows
+ * from mult alone. Returns the list, reallocated if it was full.
+ */
+
+static s_CdcStrawTruthHits_t* growStrawTruthHits(s_CdcStrawTruthHits_t** hits)
+{
+   s_CdcStrawTruthHits_t* old = *hits;
+   int mult = old->mult;
+   if (mult >= INITIAL_HITS && (mult & (mult - 1)) == 0)
+   {
+      *hits = make_s_CdcStrawTruthHits(2*mult);
+      memcpy((*hits)->in, old->in, mult*sizeof(s_CdcStrawTruthHit_t));
+      (*hits)->mult = mult;
+      FREE(old);
+   }
+   return *hits;
 }
 
-void AddCDCCluster(s_CdcStrawTruthHits_t* hits, int ipart, int track, int n_p,
-      float t, float xyzcluster[3])
+void AddCDCCluster(s_CdcStrawTruthHits_t** strawHits, int ipart, int track,
+      int n_p, float t, float xyzcluster[3])
 {
+   s_CdcStrawTruthHits_t* hits = *strawHits;
+
    // measured charge 
    float q=0.;
 
@@ -115,7 +124,7 @@ void AddCDCCluster(s_CdcStrawTruthHits_t* hits, int ipart, int track, int n_p,
    // Find the drift time for this cluster. Drift time depends on B:
    // (dependence derived from Garfield calculations)
    float B[3],Bmag,x[3]; 
-   transformCoord(xyzcluster,"local",x,"global");
+   transformFrame(xyzcluster,FRAME_LOCAL,x,FRAME_GLOBAL);
    gufld_db_(x,B);
    Bmag=sqrt(B[0]*B[0]+B[1]*B[1]+B[2]*B[2]);
    float d2=dradius*dradius;
@@ -177,14 +186,19 @@ void AddCDCCluster(s_CdcStrawTruthHits_t* hits, int ipart, int track, int n_p,
       q = GAS_GAIN*ELECTRON_CHARGE*(float)(1+n_s);
    }
 
-   // Add the hit info
-   int nhit;
-   for (nhit = 0; nhit < hits->mult; nhit++) {
-      if (fabs(hits->in[nhit].t - total_time) < TWO_HIT_RESOL) {
-         break;
-      }
+   // Add the hit info, keeping the hits in time order.  Find the
+   // earliest hit that is not resolvable from this one, if any.
+   int nhit = 0;
+   int nlast = hits->mult;
+   while (nhit < nlast) {
+      int mid = (nhit + nlast)/2;
+      if (hits->in[mid].t <= total_time - TWO_HIT_RESOL)
+         nhit = mid + 1;
+      else
+         nlast = mid;
    }
-   if (nhit < hits->mult) {             /* merge with former hit */
+   if (nhit < hits->mult &&
+       hits->in[nhit].t < total_time + TWO_HIT_RESOL) {   /* merge with former hit */
       /* Use the time from the earlier hit but add the charge*/
       hits->in[nhit].q += q;
       if (hits->in[nhit].t > total_time) {
@@ -199,7 +213,10 @@ void AddCDCCluster(s_CdcStrawTruthHits_t* hits, int ipart, int track, int n_p,
          (hits->in[nhit].q += dEsum);
          */
    }
-   else if (nhit < MAX_HITS) {            /* create new hit */
+   else if (hits->mult < MAX_HITS) {      /* create new hit */
+      hits = growStrawTruthHits(strawHits);
+      memmove(&hits->in[nhit+1], &hits->in[nhit],
+              (hits->mult - nhit)*sizeof(s_CdcStrawTruthHit_t));
       hits->in[nhit].t = total_time;
       hits->in[nhit].q = q;
       hits->in[nhit].d = dradius;
@@ -323,8 +340,8 @@ void hitCentralDC (float xin[4], float xout[4],
    dx[0] = xin[0] - xout[0];
    dx[1] = xin[1] - xout[1];
    dx[2] = xin[2] - xout[2];
-   transformCoord(xin,"global",xinlocal,"local");
-   transformCoord(xout,"global",xoutlocal,"local");
+   transformFrame(xin,FRAME_GLOBAL,xinlocal,FRAME_LOCAL);
+   transformFrame(xout,FRAME_GLOBAL,xoutlocal,FRAME_LOCAL);
 
    /*
       xlocal[0] = (xinlocal[0] + xoutlocal[0])/2;
@@ -468,7 +485,7 @@ void hitCentralDC (float xin[4], float xout[4],
 
    if (dEsum > 0)
    {  
-      s_CdcStrawTruthHits_t* hits;
+      s_CdcStrawTruthHits_t** hits;
 
       int layer = getlayer_wrapper_();
       int ring = getring_wrapper_();
@@ -486,14 +503,15 @@ void hitCentralDC (float xin[4], float xout[4],
             straws->mult = 1;
             straws->in[0].ring = ring;
             straws->in[0].straw = sector;
-            straws->in[0].cdcStrawTruthHits = hits = make_s_CdcStrawTruthHits(MAX_HITS);
+            straws->in[0].cdcStrawTruthHits = make_s_CdcStrawTruthHits(INITIAL_HITS);
+            hits = &straws->in[0].cdcStrawTruthHits;
             cdc->cdcStraws = straws;
             strawCount++;
          }
          else
          {
             s_CentralDC_t* cdc = (s_CentralDC_t*) *twig;
-            hits = cdc->cdcStraws->in[0].cdcStrawTruthHits;
+            hits = &cdc->cdcStraws->in[0].cdcStrawTruthHits;
          }
 
 
@@ -574,8 +592,7 @@ s_CentralDC_t* pickCentralDC ()
 
          s_CdcStrawTruthHits_t* hits = straws->in[straw].cdcStrawTruthHits;
 
-         // Sort the clusters by time
-         qsort(hits->in,hits->mult,sizeof(s_CdcStrawTruthHit_t),(compfn)cdc_cluster_sort);
+         // The clusters are already in time order, see AddCDCCluster
 
          /* compress out the hits below threshold */
          int i,iok=0;
@@ -598,11 +615,7 @@ s_CentralDC_t* pickCentralDC ()
 
             // Temporary histogram in 1 ns bins to store waveform data
             int num_samples=(int)CDC_TIME_WINDOW;
-            float *samples=(float *)malloc(num_samples*sizeof(float));
-            for (i=0;i<num_samples;i++) {
-               samples[i]=cdc_wire_signal((float)i,hits);
-               //printf("%f %f\n",(float)i,samples[i]);
-            }
+            float *samples=cdc_wire_signal(num_samples,hits);
 
             int returned_to_baseline=0;
             float q=0.; 
@@ -610,6 +623,10 @@ s_CentralDC_t* pickCentralDC ()
             for (i=0; i<num_samples; i+=FADC_BIN_SIZE) {
                if (samples[i] > THRESH_MV) {
                   if (returned_to_baseline == 0) {
+                     /* one entry per threshold crossing can outgrow
+                      * the cluster list, so make room first */
+                     hits->mult = iok;
+                     hits = growStrawTruthHits(&straws->in[straw].cdcStrawTruthHits);
                      hits->in[iok].itrack = hits->in[0].itrack;
                      hits->in[iok].ptype = hits->in[0].ptype;
                      hits->in[iok].t=(float) i;
@@ -630,7 +647,6 @@ s_CentralDC_t* pickCentralDC ()
             if (q > 0) {
                hits->in[iok-1].q = q;
             }
-            free(samples);
          }
 
          if (iok)
@@ -134,7 +134,13 @@ void hitForwardEMcal (float xin[4], float xout[4],
    x[1] = (xin[1] + xout[1])/2;
    x[2] = (xin[2] + xout[2])/2;
    t    = (xin[3] + xout[3])/2 * 1e9;
-   transformCoord(x,"global",xfcal,"LGBL");
+   static int lgblFrame = 0;
+   static int ltb1Frame = 0;
+   if (lgblFrame == 0)
+      lgblFrame = frameHandle("LGBL");
+   if (ltb1Frame == 0)
+      ltb1Frame = frameHandle("LTB1");
+   transformFrame(x,FRAME_GLOBAL,xfcal,lgblFrame);
 
    /* if a light guide hit, record that here, no threshold */
 
@@ -277,7 +283,7 @@ void hitForwardEMcal (float xin[4], float xout[4],
       LENGTH_OF_BLOCK=45.0;
       if (row>=100 || column>=100){
 	LENGTH_OF_BLOCK=20.0;
-	transformCoord(x,"global",xfcal,"LTB1");
+	transformFrame(x,FRAME_GLOBAL,xfcal,ltb1Frame);
       }
 
       float dist = 0.5*LENGTH_OF_BLOCK-xfcal[2];
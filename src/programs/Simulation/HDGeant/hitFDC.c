@@ -12,16 +12,17 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include <HDDM/hddm_s.h>
 #include <geant3.h>
 #include <bintree.h>
 #include <gid_map.h>
+#include <asicWaveform.h>
 
 #include "calibDB.h"
 extern s_HDDM_t* thisInputEvent;
-extern double asic_response(double t);
 extern double Ei(double x);
 
 typedef struct{
@@ -74,6 +75,11 @@ static float lorentz_parms[4]; // parameters for modeling shift of avalanche alo
 // DO NOT MODIFY IT.
 #define MAX_HITS 1000
 
+// The truth hit lists are allocated with room for INITIAL_HITS
+// and doubled whenever they fill up, see growAnodeTruthHits.
+// It must be a power of 2.
+#define INITIAL_HITS 4
+
 #if 0
 static float wire_dx_offset[2304];
 static float wire_dz_offset[2304];
@@ -171,32 +177,54 @@ void polint(float *xa, float *ya,int n,float x, float *y,float *dy){
   free(d);
 }
 
-// Simulation of signal on a wire
-double wire_signal(double t,s_FdcAnodeTruthHits_t* ahits){
+// Reallocate a truth hit list with twice the room if it is full.
+// Its capacity follows from mult alone, see INITIAL_HITS.
+static s_FdcAnodeTruthHits_t* growAnodeTruthHits(s_FdcAnodeTruthHits_t** hits){
+  s_FdcAnodeTruthHits_t* old = *hits;
+  int mult = old->mult;
+  if (mult >= INITIAL_HITS && (mult & (mult - 1)) == 0){
+    *hits = make_s_FdcAnodeTruthHits(2*mult);
+    memcpy((*hits)->in, old->in, mult*sizeof(s_FdcAnodeTruthHit_t));
+    (*hits)->mult = mult;
+    FREE(old);
+  }
+  return *hits;
+}
+
+static s_FdcCathodeTruthHits_t* growCathodeTruthHits(s_FdcCathodeTruthHits_t** hits){
+  s_FdcCathodeTruthHits_t* old = *hits;
+  int mult = old->mult;
+  if (mult >= INITIAL_HITS && (mult & (mult - 1)) == 0){
+    *hits = make_s_FdcCathodeTruthHits(2*mult);
+    memcpy((*hits)->in, old->in, mult*sizeof(s_FdcCathodeTruthHit_t));
+    (*hits)->mult = mult;
+    FREE(old);
+  }
+  return *hits;
+}
+
+// Simulation of signal on a wire, sampled in 1 ns bins
+float *wire_signal(int num_samples,s_FdcAnodeTruthHits_t* ahits){
   int m;
   double asic_gain=0.76; // mV/fC
-  double func=0;
+  float *samples=asicWaveformBuffer(num_samples);
   for (m=0;m<ahits->mult;m++){
-    if (t>ahits->in[m].t){
-      double my_time=t-ahits->in[m].t;
-      func+=asic_gain*ahits->in[m].dE*asic_response(my_time);
-    }
+    asicWaveformAddPulse(samples,num_samples,ahits->in[m].t,
+                         asic_gain*ahits->in[m].dE);
   }
-  return func;
+  return samples;
 }
 
-// Simulation of signal on a cathode strip (ASIC output)
-double cathode_signal(double t,s_FdcCathodeTruthHits_t* chits){
+// Simulation of signal on a cathode strip (ASIC output), 1 ns bins
+float *cathode_signal(int num_samples,s_FdcCathodeTruthHits_t* chits){
   int m;
   double asic_gain=2.3;
-  double func=0;
+  float *samples=asicWaveformBuffer(num_samples);
   for (m=0;m<chits->mult;m++){
-    if (t>chits->in[m].t){
-      double my_time=t-chits->in[m].t;
-      func+=asic_gain*chits->in[m].q*asic_response(my_time);
-    }
+    asicWaveformAddPulse(samples,num_samples,chits->in[m].t,
+                         asic_gain*chits->in[m].q);
   }
-  return func;
+  return samples;
 }
 
 // Generate hits in two cathode planes flanking the wire plane  
@@ -205,6 +233,7 @@ void AddFDCCathodeHits(int PackNo,float xwire,float avalanche_y,float tdrift,
                int layer, int global_wire_number){
 
   s_FdcCathodeTruthHits_t* chits;          
+  s_FdcCathodeTruthHits_t** stripHits;
 
   // Anode charge
   float q_anode;
@@ -284,7 +313,8 @@ void AddFDCCathodeHits(int PackNo,float xwire,float avalanche_y,float tdrift,
       strips->in[0].plane = plane;
       strips->in[0].strip = strip;
       strips->in[0].fdcCathodeTruthHits = chits
-        = make_s_FdcCathodeTruthHits(MAX_HITS);
+        = make_s_FdcCathodeTruthHits(INITIAL_HITS);
+      stripHits = &strips->in[0].fdcCathodeTruthHits;
       chambers->mult = 1;
       chambers->in[0].module = module;
       chambers->in[0].layer = layer;
@@ -294,8 +324,9 @@ void AddFDCCathodeHits(int PackNo,float xwire,float avalanche_y,float tdrift,
     }
     else{
       s_ForwardDC_t* fdc = *cathodeTwig;
-      chits = fdc->fdcChambers->in[0].fdcCathodeStrips
+      stripHits = &fdc->fdcChambers->in[0].fdcCathodeStrips
         ->in[0].fdcCathodeTruthHits;
+      chits = *stripHits;
     }
     
     int nhit;
@@ -319,6 +350,7 @@ void AddFDCCathodeHits(int PackNo,float xwire,float avalanche_y,float tdrift,
         }
       }
     else if (nhit < MAX_HITS){        /* create new hit */
+      chits = growCathodeTruthHits(stripHits);
       chits->in[nhit].t = tdrift;
       chits->in[nhit].q = q;
       chits->in[nhit].itrack = itrack;
@@ -337,8 +369,9 @@ void AddFDCCathodeHits(int PackNo,float xwire,float avalanche_y,float tdrift,
 
 
 // Add wire information
-int AddFDCAnodeHit(s_FdcAnodeTruthHits_t* ahits,int layer,int ipart,int track,
+int AddFDCAnodeHit(s_FdcAnodeTruthHits_t** wireHits,int layer,int ipart,int track,
 		   float xwire,float xyz[3],float dE,float t,float *tdrift){
+  s_FdcAnodeTruthHits_t* ahits = *wireHits;
  
   // Generate 2 random numbers from a Gaussian distribution
   // 
@@ -360,7 +393,7 @@ int AddFDCAnodeHit(s_FdcAnodeTruthHits_t* ahits,int layer,int ipart,int track,
 
    // Get the magnetic field at this cluster position        
   float x[3],B[3];
-  transformCoord(xyz,"local",x,"global");
+  transformFrame(xyz,FRAME_LOCAL,x,FRAME_GLOBAL);
   gufld_db_(x,B);
   
   // Find the angle between the wire direction and the direction of the
@@ -478,6 +511,7 @@ int AddFDCAnodeHit(s_FdcAnodeTruthHits_t* ahits,int layer,int ipart,int track,
     }
   else if (nhit < MAX_HITS)              /* create new hit */
     {
+      ahits = growAnodeTruthHits(wireHits);
       ahits->in[nhit].t = *tdrift;
       ahits->in[nhit].t_unsmeared=tdrift_unsmeared;
       ahits->in[nhit].dE = dE;
@@ -685,10 +719,10 @@ void hitForwardDC (float xin[4], float xout[4],
   // transform layer number into Richard's scheme
   layer=(layer-1)%3+1;
 
-  transformCoord(xin,"global",xinlocal,"local");
+  transformFrame(xin,FRAME_GLOBAL,xinlocal,FRAME_LOCAL);
 
   wire1 = ceil((xinlocal[0] - U_OF_WIRE_ZERO)/WIRE_SPACING +0.5);
-  transformCoord(xout,"global",xoutlocal,"local");
+  transformFrame(xout,FRAME_GLOBAL,xoutlocal,FRAME_LOCAL);
   wire2 = ceil((xoutlocal[0] - U_OF_WIRE_ZERO)/WIRE_SPACING +0.5);
   // Check that wire numbers are not out of range
   if ((wire1>WIRES_PER_PLANE && wire2==WIRES_PER_PLANE) ||
@@ -840,7 +874,7 @@ void hitForwardDC (float xin[4], float xout[4],
       }
 
       if (dE > 0){
-    s_FdcAnodeTruthHits_t* ahits;    
+    s_FdcAnodeTruthHits_t** ahits;    
 
     // Create (or grab) an entry in the tree for the anode wire
     int mark = (chamber<<20) + (2<<10) + wire;
@@ -853,7 +887,8 @@ void hitForwardDC (float xin[4], float xout[4],
         s_FdcAnodeWires_t* wires = make_s_FdcAnodeWires(1);
         wires->mult = 1;
         wires->in[0].wire = wire;
-        wires->in[0].fdcAnodeTruthHits = ahits = make_s_FdcAnodeTruthHits(MAX_HITS);
+        wires->in[0].fdcAnodeTruthHits = make_s_FdcAnodeTruthHits(INITIAL_HITS);
+        ahits = &wires->in[0].fdcAnodeTruthHits;
         chambers->mult = 1;
         chambers->in[0].module = module;
         chambers->in[0].layer = layer;
@@ -864,7 +899,7 @@ void hitForwardDC (float xin[4], float xout[4],
     else
       {
         s_ForwardDC_t* fdc = *twig;
-        ahits = fdc->fdcChambers->in[0].fdcAnodeWires->in[0].fdcAnodeTruthHits;
+        ahits = &fdc->fdcChambers->in[0].fdcAnodeWires->in[0].fdcAnodeTruthHits;
       }
     
     int two=2;
@@ -1012,17 +1047,17 @@ s_ForwardDC_t* pickForwardDC ()
        
        // Temporary histogram in 1 ns bins to store waveform data
        int num_samples=(int)FDC_TIME_WINDOW;
-       float *samples=(float *)malloc(num_samples*sizeof(float));
-       for (i=0;i<num_samples;i++){
-         samples[i]=wire_signal((float)i,ahits);
-         //printf("%f %f\n",(float)i,samples[i]);
-       }
+       float *samples=wire_signal(num_samples,ahits);
        
        int returned_to_baseline=0;
        float q=0;
        for (i=0;i<num_samples;i++){
          if (samples[i] > THRESH_ANODE){
            if (returned_to_baseline==0){
+         // One entry per threshold crossing can outgrow the cluster
+         // list, so make room first
+         ahits->mult = iok;
+         ahits = growAnodeTruthHits(&wires->in[wire].fdcAnodeTruthHits);
          ahits->in[iok].itrack = ahits->in[0].itrack;
          ahits->in[iok].ptype = ahits->in[0].ptype;
          
@@ -1046,7 +1081,6 @@ s_ForwardDC_t* pickForwardDC ()
            returned_to_baseline=0;   
          }
        }
-       free(samples);
      } // Simulation of clusters within cell
 
      if (iok)
@@ -1095,11 +1129,7 @@ s_ForwardDC_t* pickForwardDC ()
        
         // Temporary histogram in 1 ns bins to store waveform data
         int num_samples=(int)(FDC_TIME_WINDOW);
-        float *samples=(float *)malloc(num_samples*sizeof(float));
-        for (i=0;i<num_samples;i++){
-          samples[i]=cathode_signal((float)i,chits);
-         //printf("t %f V %f\n",(float)i,samples[i]);
-        }     
+        float *samples=cathode_signal(num_samples,chits);
         
         int threshold_toggle=0;
         int istart=0;
@@ -1107,6 +1137,8 @@ s_ForwardDC_t* pickForwardDC ()
         for (i=0;i<num_samples;i+=FADC_BIN_SIZE){
           if (samples[i] > THRESH_STRIPS){
         if (threshold_toggle==0){
+          chits->mult = iok;
+          chits = growCathodeTruthHits(&strips->in[strip].fdcCathodeTruthHits);
           chits->in[iok].itrack = chits->in[0].itrack;
           chits->in[iok].ptype = chits->in[0].ptype;
           chits->in[iok].t=(float) i;
@@ -1144,7 +1176,6 @@ s_ForwardDC_t* pickForwardDC ()
           }
         }
         
-        free(samples);
       }// Simulate clusters within cell
     
       if (iok)
@@ -174,8 +174,11 @@ void hitForwardTOF (float xin[4], float xout[4],
   // tranform the the global x coordinate into the local coordinate of the top_volume FTOF
   // defined in the geometry file src/programs/Simulation/hdds/ForwardTOF_HDDS.xml
   // the function transform Coord is defined in src/programs/Simulation/HDGeant/hitutil/hitutil.F
-  transformCoord(x,"global",xlocal,"FTOF");
-  transformCoord(zeroHat,"local",xftof,"FTOF");
+  static int ftofFrame = 0;
+  if (ftofFrame == 0)
+    ftofFrame = frameHandle("FTOF");
+  transformFrame(x,FRAME_GLOBAL,xlocal,ftofFrame);
+  transformFrame(zeroHat,FRAME_LOCAL,xftof,ftofFrame);
   
   /* post the hit to the truth tree */
   // in other words: store the GENERATED track information
@@ -53,7 +53,10 @@ void hitGapEMcal (float xin[4], float xout[4],
    //x[1] = (xin[1] + xout[1])/2;
    //x[2] = (xin[2] + xout[2])/2;
    float t    = (xin[3] + xout[3])/2 * 1e9;
-   transformCoord(zeroHat,"local",xgcal,"gCAL");
+   static int gcalFrame = 0;
+   if (gcalFrame == 0)
+      gcalFrame = frameHandle("gCAL");
+   transformFrame(zeroHat,FRAME_LOCAL,xgcal,gcalFrame);
 
    /* post the hit to the truth tree */
 
@@ -66,8 +66,11 @@ void hitUpstreamEMveto (float xin[4], float xout[4],
   x[1] = (xin[1] + xout[1])/2;
   x[2] = (xin[2] + xout[2])/2;
   t    = (xin[3] + xout[3])/2 * 1e9;
-  transformCoord(x,"global",xlocal,"UPV");
-  transformCoord(zeroHat,"local",xupv,"UPV");
+  static int upvFrame = 0;
+  if (upvFrame == 0)
+    upvFrame = frameHandle("UPV");
+  transformFrame(x,FRAME_GLOBAL,xlocal,upvFrame);
+  transformFrame(zeroHat,FRAME_LOCAL,xupv,upvFrame);
   
   int layer = getlayer_wrapper_();
   int row = getrow_wrapper_();
@@ -0,0 +1,219 @@
+// bcal_merge_bench
+//
+// Times the merging of BCAL SiPM hits in mcsmear: MergeSiPMHits, which
+// combines the hits of different incident particles in the same cell,
+// and SumSiPMHits, which sums the cells into their readout channels.
+// The same synthetic events are also run through the map-based code
+// these replaced (copied below), and the number of summed hits and
+// the total energy of the two are compared. The energy must agree; the
+// number of hits can differ slightly, because the old code merged a
+// chain of hits longer than the resolution in incident_id order rather
+// than in time order.
+//
+// Each event has nshowers incident particles, each hitting ncells
+// random cells at both ends with a time spread of a few ns, so that
+// hits of different particles in the same cell overlap in time.
+//
+// Usage: bcal_merge_bench [nevents [nshowers [ncells]]]   (default 200 10 20)
+//
+// The map-based merge restarts its search after every merge, so it gets
+// very slow beyond a few hundred hits per event.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include "BCALSiPMHits.h"
+
+using namespace std;
+
+static const int NUM_MODULES = 48;
+static const int NUM_LAYERS = 10;     // SiPM layers, summed 1+2+3+4
+static const int NUM_SECTORS = 4;
+static const int NUM_SUMLAYERS = 4;
+static const double TWO_HIT_RESO = 50.0;   // ns, BCAL_TWO_HIT_RESO
+
+static int SumLayer(int layer)
+{
+	if (layer == 1) return 1;
+	if (layer <= 3) return 2;
+	if (layer <= 6) return 3;
+	return 4;
+}
+
+static int Channel(int module, int layer, int sector)
+{
+	return NUM_SUMLAYERS*NUM_SECTORS*(module-1)
+	     + NUM_SECTORS*(SumLayer(layer)-1) + (sector-1);
+}
+
+//-----------
+// OldMergeHits, OldSortSiPMHits
+//
+// The map-based merging mcsmear used before the sort-and-sweep
+//-----------
+struct OldSumHits {
+	vector<double> EUP, tUP, EDN, tDN;
+};
+
+static void OldMergeHits(map<bcal_index, CellHits> &SiPMHits, double Resolution)
+{
+	while (true) {
+		bool merged = false;
+		map<bcal_index, CellHits>::iterator iter1 = SiPMHits.begin();
+		for (; iter1 != SiPMHits.end(); iter1++) {
+			map<bcal_index, CellHits>::iterator iter2 = iter1;
+			for (++iter2; iter2 != SiPMHits.end(); iter2++) {
+				if (iter1->first.module != iter2->first.module) continue;
+				if (iter1->first.layer  != iter2->first.layer ) continue;
+				if (iter1->first.sector != iter2->first.sector) continue;
+				if (iter1->first.end    != iter2->first.end   ) continue;
+				if (fabs(iter1->second.t - iter2->second.t) >= Resolution) continue;
+
+				double E1 = iter1->second.E;
+				double t1 = iter1->second.t;
+				double E2 = iter2->second.E;
+				double t2 = iter2->second.t;
+				if (E1 != 0.0 && E2 != 0.0) {
+					iter1->second.E += E2;
+					if (t1 > t2) iter1->second.t = t2;
+				}
+				if (E1 == 0.0 && E2 != 0.0) {
+					iter1->second.E = E2;
+					iter1->second.t = t2;
+				}
+				SiPMHits.erase(iter2);
+				merged = true;
+				break;
+			}
+			if (merged) break;
+		}
+		if (!merged) break;
+	}
+}
+
+static void OldSortSiPMHits(map<bcal_index, CellHits> &SiPMHits,
+                            map<int, OldSumHits> &bcalfADC, double Resolution)
+{
+	map<bcal_index, CellHits>::iterator iter = SiPMHits.begin();
+	for (; iter != SiPMHits.end(); iter++) {
+		const bcal_index &idx = iter->first;
+		OldSumHits &sumhits = bcalfADC[Channel(idx.module, idx.layer, idx.sector)];
+		CellHits &cellhits = iter->second;
+		if (cellhits.E == 0.0)
+			continue;
+		vector<double> &E = (cellhits.end == CellHits::kUp)? sumhits.EUP : sumhits.EDN;
+		vector<double> &t = (cellhits.end == CellHits::kUp)? sumhits.tUP : sumhits.tDN;
+		bool merged = false;
+		for (size_t ii = 0; ii < E.size(); ii++) {
+			if (fabs(cellhits.t - t[ii]) < Resolution) {
+				E[ii] += cellhits.E;
+				if (t[ii] > cellhits.t) t[ii] = cellhits.t;
+				merged = true;
+				break;
+			}
+		}
+		if (!merged) {
+			E.push_back(cellhits.E);
+			t.push_back(cellhits.t);
+		}
+	}
+}
+
+//-----------
+// main
+//-----------
+int main(int narg, char *argv[])
+{
+	int nevents  = (narg > 1)? atoi(argv[1]) : 200;
+	int nshowers = (narg > 2)? atoi(argv[2]) : 10;
+	int ncells   = (narg > 3)? atoi(argv[3]) : 20;
+	if (nevents < 1 || nshowers < 1 || ncells < 1) {
+		cout << "Usage: bcal_merge_bench [nevents [nshowers [ncells]]]" << endl;
+		return 1;
+	}
+
+	// synthetic events, one SiPM hit per (cell, particle, end)
+	srand(1);
+	vector<vector<SiPMHit> > events(nevents);
+	long nhits = 0;
+	for (int iev = 0; iev < nevents; iev++) {
+		map<bcal_index, bool> used;
+		for (int ipart = 0; ipart < nshowers; ipart++) {
+			int module = 1 + rand() % NUM_MODULES;
+			double t0 = 100.0 * rand() / RAND_MAX;
+			for (int icell = 0; icell < ncells; icell++) {
+				int layer = 1 + rand() % NUM_LAYERS;
+				int sector = 1 + rand() % NUM_SECTORS;
+				int mod = 1 + (module - 1 + rand() % 3 + NUM_MODULES - 1) % NUM_MODULES;
+				for (int end = 0; end < 2; end++) {
+					bcal_index idx(mod, layer, sector, ipart,
+					               end? bcal_index::kDown : bcal_index::kUp);
+					if (used.count(idx))
+						continue;
+					used[idx] = true;
+					SiPMHit hit(idx, Channel(mod, layer, sector));
+					hit.cell.end = end? CellHits::kDown : CellHits::kUp;
+					hit.cell.E = 50.0 * rand() / RAND_MAX;
+					hit.cell.t = t0 + 5.0 * rand() / RAND_MAX;
+					events[iev].push_back(hit);
+				}
+			}
+		}
+		nhits += events[iev].size();
+	}
+
+	// map-based merging
+	long nsum_old = 0;
+	double Esum_old = 0;
+	chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+	for (int iev = 0; iev < nevents; iev++) {
+		map<bcal_index, CellHits> SiPMHits;
+		for (size_t i = 0; i < events[iev].size(); i++)
+			SiPMHits[events[iev][i].idx] = events[iev][i].cell;
+		OldMergeHits(SiPMHits, TWO_HIT_RESO);
+		map<int, OldSumHits> bcalfADC;
+		OldSortSiPMHits(SiPMHits, bcalfADC, TWO_HIT_RESO);
+		map<int, OldSumHits>::iterator iter;
+		for (iter = bcalfADC.begin(); iter != bcalfADC.end(); ++iter) {
+			nsum_old += iter->second.EUP.size() + iter->second.EDN.size();
+			for (size_t i = 0; i < iter->second.EUP.size(); i++) Esum_old += iter->second.EUP[i];
+			for (size_t i = 0; i < iter->second.EDN.size(); i++) Esum_old += iter->second.EDN[i];
+		}
+	}
+	chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+
+	// sort-and-sweep merging, with the work areas reused as in mcsmear
+	long nsum_new = 0;
+	double Esum_new = 0;
+	vector<SiPMHit> SiPMHits;
+	BCALChannelHits bcalfADC;
+	chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+	for (int iev = 0; iev < nevents; iev++) {
+		SiPMHits = events[iev];
+		MergeSiPMHits(SiPMHits, TWO_HIT_RESO);
+		bcalfADC.Clear(NUM_MODULES*NUM_SUMLAYERS*NUM_SECTORS);
+		SumSiPMHits(SiPMHits, bcalfADC, TWO_HIT_RESO);
+		nsum_new += bcalfADC.E.size();
+		for (size_t i = 0; i < bcalfADC.E.size(); i++) Esum_new += bcalfADC.E[i];
+	}
+	chrono::steady_clock::time_point t3 = chrono::steady_clock::now();
+
+	double old_us = chrono::duration<double>(t1 - t0).count() * 1e6 / nevents;
+	double new_us = chrono::duration<double>(t3 - t2).count() * 1e6 / nevents;
+	cout << nevents << " events, " << (double)nhits/nevents << " SiPM hits per event" << endl;
+	cout << fixed << setprecision(1);
+	cout << "  map-based merge:       " << old_us << " us/event, "
+	     << nsum_old << " summed hits" << endl;
+	cout << "  sort-and-sweep merge:  " << new_us << " us/event, "
+	     << nsum_new << " summed hits" << endl;
+	cout << scientific << setprecision(2);
+	cout << "  relative difference in total energy: "
+	     << fabs(Esum_new - Esum_old)/Esum_old << endl;
+
+	return 0;
+}
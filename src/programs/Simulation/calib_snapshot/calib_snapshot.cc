@@ -0,0 +1,200 @@
+//
+// calib_snapshot - writes the calibration tables needed for one run into
+//                  a single snapshot file, that hdgeant and mcsmear can
+//                  then read instead of the calibration database with
+//
+//                     JANA_CALIB_URL=snapshot:///path/to/file.snap
+//
+// usage: calib_snapshot -r <run number> -o <snapshot file>
+//                       [-a [<prefix>]] [<list file> | <namepath>] ...
+//
+// The tables are read through JANA_CALIB_URL and JANA_CALIB_CONTEXT as
+// usual. Arguments naming a file are read as lists of namepaths, one per
+// line, anything else is taken as a namepath itself. The lists of tables
+// a job actually used are written by hdgeant and mcsmear when they are
+// run with -PCALIB:SNAPSHOT_LIST=<list file>. With -a all tables in the
+// database, or all under <prefix>, are written.
+//
+// The snapshot is read back after it is written and compared with the
+// database, and the time taken by both is reported. A job that asks the
+// snapshot for a table it does not contain gets an error for it, not the
+// database value, so the list must cover every table the job reads.
+//
+// example:
+//
+//    $ hdgeant -PCALIB:SNAPSHOT_LIST=tables.list
+//    $ mcsmear -PCALIB:SNAPSHOT_LIST=tables.list hdgeant.hddm
+//    $ calib_snapshot -r 30730 -o run30730.snap tables.list
+//    $ export JANA_CALIB_URL=snapshot://`pwd`/run30730.snap
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include <DANA/DApplication.h>
+#include <CALIB_SNAPSHOT/JCalibrationSnapshot.h>
+
+void usage()
+{
+   std::cout << "usage: calib_snapshot -r <run number> "
+             << "-o <snapshot file> "
+             << "[-a [<prefix>]] "
+             << "[<list file> | <namepath>] ..."
+             << std::endl;
+   exit(1);
+}
+
+void read_list(std::ifstream &list, std::vector<std::string> &namepaths)
+{
+   std::string line;
+   while (std::getline(list, line)) {
+      size_t start = line.find_first_not_of(" \t");
+      if (start == std::string::npos || line[start] == '#')
+         continue;
+      size_t end = line.find_last_not_of(" \t\r");
+      namepaths.push_back(line.substr(start, end - start + 1));
+   }
+}
+
+// true if the snapshot returns the same as the database for namepath,
+// in every form that the database can return
+bool same_tables(JCalibration *db, JCalibration *snap, std::string namepath)
+{
+   std::map<std::string, std::string> kv1, kv2;
+   std::vector<std::string> v1, v2;
+   std::vector< std::map<std::string, std::string> > r1, r2;
+   std::vector< std::vector<std::string> > rv1, rv2;
+   bool same = true;
+   if (!db->GetCalib(namepath, kv1))
+      same &= !snap->GetCalib(namepath, kv2) && kv1 == kv2;
+   if (!db->GetCalib(namepath, v1))
+      same &= !snap->GetCalib(namepath, v2) && v1 == v2;
+   if (!db->GetCalib(namepath, r1))
+      same &= !snap->GetCalib(namepath, r2) && r1 == r2;
+   if (!db->GetCalib(namepath, rv1))
+      same &= !snap->GetCalib(namepath, rv2) && rv1 == rv2;
+   return same;
+}
+
+int main(int argc, char *argv[])
+{
+   int run_number = 0;
+   std::string output_file;
+   bool all_tables = false;
+   std::string prefix;
+   std::vector<std::string> namepaths;
+
+   for (int iarg=1; iarg < argc; ++iarg) {
+      std::string arg(argv[iarg]);
+      if (arg.substr(0,2) == "-P") {
+         continue;   // JANA parameter, handled by DApplication
+      }
+      else if (arg.substr(0,2) == "-r") {
+         if (arg.size() > 2) {
+            run_number = std::stoi(arg.substr(2));
+         }
+         else if (iarg+1 < argc) {
+            run_number = std::stoi(argv[++iarg]);
+         }
+      }
+      else if (arg.substr(0,2) == "-o") {
+         if (arg.size() > 2) {
+            output_file = arg.substr(2);
+         }
+         else if (iarg+1 < argc) {
+            output_file = argv[++iarg];
+         }
+      }
+      else if (arg == "-a") {
+         all_tables = true;
+         if (iarg+1 < argc && argv[iarg+1][0] != '-') {
+            std::ifstream test(argv[iarg+1]);
+            if (!test.good()) {
+               prefix = argv[++iarg];
+            }
+         }
+      }
+      else if (arg[0] == '-') {
+         usage();
+      }
+      else {
+         std::ifstream list(arg.c_str());
+         if (list.good())
+            read_list(list, namepaths);
+         else
+            namepaths.push_back(arg);
+      }
+   }
+
+   if (run_number == 0 || output_file.size() == 0 ||
+       (namepaths.size() == 0 && !all_tables))
+   {
+      usage();
+   }
+
+   DApplication *dapp = new DApplication(argc, argv);
+   dapp->Init();
+   JCalibration *jcalib = dapp->GetJCalibration(run_number);
+   if (jcalib == 0) {
+      std::cerr << "Unable to get the calibrations for run "
+                << run_number << std::endl;
+      exit(2);
+   }
+
+   if (all_tables) {
+      std::vector<std::string> all;
+      jcalib->GetListOfNamepaths(all);
+      for (size_t i=0; i < all.size(); ++i) {
+         if (all[i].find(prefix) == 0 || all[i].find("/" + prefix) == 0)
+            namepaths.push_back(all[i]);
+      }
+   }
+
+   std::cout << "Reading " << namepaths.size() << " tables for run "
+             << run_number << " from " << jcalib->GetURL()
+             << " (" << jcalib->GetContext() << ")" << std::endl;
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+   std::string error;
+   int ntables = WriteCalibSnapshot(jcalib, namepaths, output_file, error);
+   std::chrono::duration<double> db_time = std::chrono::steady_clock::now() - start;
+   if (ntables < 0) {
+      std::cerr << "Unable to write the snapshot: " << error << std::endl;
+      exit(3);
+   }
+
+   start = std::chrono::steady_clock::now();
+   JCalibrationSnapshot snap("snapshot://" + output_file, run_number,
+                             jcalib->GetContext());
+   std::vector<std::string> stored;
+   snap.GetListOfNamepaths(stored);
+   std::vector< std::map<std::string, std::string> > rows;
+   std::vector< std::vector<std::string> > rowvectors;
+   for (size_t i=0; i < stored.size(); ++i) {
+      snap.GetCalib(stored[i], rows);
+      snap.GetCalib(stored[i], rowvectors);
+   }
+   std::chrono::duration<double> snap_time = std::chrono::steady_clock::now() - start;
+
+   int mismatches = 0;
+   for (size_t i=0; i < stored.size(); ++i) {
+      if (!same_tables(jcalib, &snap, stored[i])) {
+         std::cerr << "Snapshot differs from the database for "
+                   << stored[i] << std::endl;
+         ++mismatches;
+      }
+   }
+
+   std::cout << "Wrote " << ntables << " tables to " << output_file << std::endl
+             << "   reading them from the database took "
+             << db_time.count() << " s" << std::endl
+             << "   reading them from the snapshot took "
+             << snap_time.count() << " s" << std::endl;
+   if (mismatches > 0) {
+      std::cerr << mismatches << " tables differ, the snapshot should not be used"
+                << std::endl;
+      exit(4);
+   }
+   return 0;
+}
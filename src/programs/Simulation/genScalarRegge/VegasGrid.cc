@@ -0,0 +1,112 @@
+// Adaptive sampling grid, following G.P. Lepage, J. Comput. Phys. 27 (1978) 192.
+// The bins are refined on the sum of |weight| rather than weight^2, which
+// drives the density towards the function itself and so keeps the largest
+// weight (the rejection envelope) low rather than the variance.
+#include "VegasGrid.h"
+#include <cmath>
+
+// Damping of the grid refinement
+const double vegas_alpha=1.5;
+// Smallest share of the weight a bin is allowed to carry after refinement,
+// relative to the average bin, so that no part of the hypercube is dropped
+const double vegas_min_share=1e-3;
+
+VegasGrid::VegasGrid(int ndim,int nbins):ndim(ndim),nbins(nbins){
+  edges.resize(ndim);
+  sums.resize(ndim);
+  last_bins.resize(ndim);
+  for (int d=0;d<ndim;d++){
+    edges[d].resize(nbins+1);
+    for (int i=0;i<=nbins;i++){
+      edges[d][i]=double(i)/double(nbins);
+    }
+    sums[d].assign(nbins,0.);
+  }
+}
+
+double VegasGrid::Sample(TRandom3 *rand,double *x){
+  double jacobian=1.;
+  for (int d=0;d<ndim;d++){
+    double y=nbins*rand->Rndm();
+    int i=int(y);
+    if (i>=nbins) i=nbins-1;
+    double width=edges[d][i+1]-edges[d][i];
+    x[d]=edges[d][i]+(y-i)*width;
+    jacobian*=nbins*width;
+    last_bins[d]=i;
+  }
+  return jacobian;
+}
+
+void VegasGrid::Accumulate(double weight){
+  for (int d=0;d<ndim;d++){
+    sums[d][last_bins[d]]+=fabs(weight);
+  }
+}
+
+void VegasGrid::Refine(){
+  vector<double>smoothed(nbins),r(nbins);
+  vector<double>new_edges(nbins+1);
+  for (int d=0;d<ndim;d++){
+    // Smooth the accumulated weights over neighboring bins
+    vector<double>&sum=sums[d];
+    double total=0.;
+    for (int i=0;i<nbins;i++){
+      double s=sum[i];
+      int n=1;
+      if (i>0){
+	s+=sum[i-1];
+	n++;
+      }
+      if (i<nbins-1){
+	s+=sum[i+1];
+	n++;
+      }
+      smoothed[i]=s/n;
+      total+=smoothed[i];
+    }
+    if (total<=0.){
+      // Nothing to refine on: keep the edges, but still start the next
+      // iteration from empty sums
+      sum.assign(nbins,0.);
+      continue;
+    }
+
+    // Damped share of the weight to give each bin
+    double rsum=0.;
+    for (int i=0;i<nbins;i++){
+      double share=smoothed[i]/total;
+      r[i]=0.;
+      if (share>=1.) r[i]=1.;
+      else if (share>0.) r[i]=pow((share-1.)/log(share),vegas_alpha);
+      rsum+=r[i];
+    }
+    double rmin=vegas_min_share*rsum/nbins;
+    rsum=0.;
+    for (int i=0;i<nbins;i++){
+      if (r[i]<rmin) r[i]=rmin;
+      rsum+=r[i];
+    }
+
+    // Place the new edges so that every bin holds the same share
+    vector<double>&old_edges=edges[d];
+    double step=rsum/nbins;
+    double acc=0.;
+    int j=0;
+    new_edges[0]=0.;
+    for (int k=1;k<nbins;k++){
+      double target=k*step;
+      while (j<nbins-1 && acc+r[j]<target){
+	acc+=r[j];
+	j++;
+      }
+      double frac=(target-acc)/r[j];
+      if (frac>1.) frac=1.;
+      new_edges[k]=old_edges[j]+frac*(old_edges[j+1]-old_edges[j]);
+    }
+    new_edges[nbins]=1.;
+    old_edges=new_edges;
+
+    sum.assign(nbins,0.);
+  }
+}
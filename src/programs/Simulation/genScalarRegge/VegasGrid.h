@@ -0,0 +1,33 @@
+#ifndef _VEGAS_GRID_H_
+#define _VEGAS_GRID_H_
+
+// Adaptive (VEGAS-style) sampling grid on the unit hypercube.  Each
+// dimension is divided into bins of equal probability whose edges are
+// moved during a warm-up phase, so that points are concentrated where the
+// weight is large.  Sample() returns the jacobian of the mapping, i.e.
+// the inverse of the density of the points it produces, so that
+// f(x)*jacobian is the weight of the point for the function f.
+
+#include <vector>
+#include <TRandom3.h>
+using namespace std;
+
+class VegasGrid{
+ public:
+  VegasGrid(int ndim,int nbins);
+
+  // Draw a point x[ndim] from the grid and return its jacobian
+  double Sample(TRandom3 *rand,double *x);
+  // Add the weight of the last point drawn to the bins it fell in
+  void Accumulate(double weight);
+  // Move the bin edges according to the accumulated weights, then clear them
+  void Refine();
+
+ private:
+  int ndim,nbins;
+  vector<vector<double> >edges; // nbins+1 edges per dimension
+  vector<vector<double> >sums; // sum of |weight| per bin
+  vector<int>last_bins; // bins of the last point drawn
+};
+
+#endif // _VEGAS_GRID_H_
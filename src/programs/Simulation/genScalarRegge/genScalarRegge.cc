@@ -17,6 +17,7 @@
 using namespace std;
 
 #include "UTILITIES/BeamProperties.h"
+#include "VegasGrid.h"
 
 // Masses
 const double m_p=0.93827; // GeV
@@ -33,6 +34,14 @@ int Nevents=10000;
 int runNo=30300;
 bool debug=false;
 
+// Adaptive sampling: number of grid bins per variable, number of passes used
+// to train the grid, number of points per pass, and factor by which the
+// largest weight seen in the last pass is raised to form the envelope
+const int vegas_bins=50;
+const int vegas_iterations=5;
+int Nwarmup=20000;
+const double weight_max_safety=1.2;
+
 // Diagnostic histograms
 TH1D *thrown_t;
 TH1D *thrown_mass;
@@ -53,6 +62,7 @@ void Usage(void){
   printf("             -O<output.hddm>   (default: scalar_gen.hddm)\n");
   printf("             -I<input.in>      (default: scalar.in)\n");
   printf("             -R<run number>    (default: 30300)\n");
+  printf("             -W<number of warm-up points per pass> (default: 20000)\n");
   printf("             -h                (Print this message and exit.)\n");
   printf("Photon beam energy range, Regge cut parameters, and decay products are\n");
   printf("specified in the <input.in> file.\n");
@@ -87,6 +97,9 @@ void ParseCommandLineArguments(int narg, char* argv[])
       case 'R':
 	sscanf(&ptr[2],"%d",&runNo);
 	break;
+      case 'W':
+	sscanf(&ptr[2],"%d",&Nwarmup);
+	break;
       case 'S':
 	sscanf(&ptr[2],"%d",&seed);
 	break;
@@ -2675,6 +2688,342 @@ void GraphCrossSection(double m1,double m2){
 //-----------
 // main
 //-----------
+// Photon energy at the fraction x of the integrated flux, interpolating
+// linearly within a bin in the same way as TH1::GetRandom
+double EgammaFromFlux(double x){
+  double *integral=cobrems_vs_E->GetIntegral();
+  int ibin=TMath::BinarySearch(cobrems_vs_E->GetNbinsX(),integral,x);
+  double Egamma=cobrems_vs_E->GetBinLowEdge(ibin+1);
+  if (x>integral[ibin]){
+    Egamma+=cobrems_vs_E->GetBinWidth(ibin+1)*(x-integral[ibin])
+      /(integral[ibin+1]-integral[ibin]);
+  }
+  return Egamma;
+}
+
+// Build the event for the given beam energy, fraction u_M of the allowed
+// two-meson mass range and cm polar angle, generating the azimuth and the
+// decay of the two-meson system, and return its cross section.
+double EventCrossSection(double Egamma,double u_M,double cos_theta_cm,
+			 TRandom3 *myrand,double m1,double m2,
+			 double *decay_masses,int *generate,double *phase,
+			 TLorentzVector &beam,double &t,
+			 vector<Particle_t>&particle_types,
+			 vector<TLorentzVector>&particle_vectors){
+  int num_decay_particles=particle_vectors.size()-1;
+  int last_index=num_decay_particles;
+  bool got_pipi=(fabs(m1-m2)>0.01)?false:true;
+
+  // Fixed target
+  TLorentzVector target(0.,0.,0.,m_p);
+
+  // masses of decay particles
+  double m1sq=m1*m1;
+  double m2sq=m2*m2;
+  double m1sq_plus_m2sq=m1sq+m2sq;
+
+  // Coupling constants for f0(500)
+  double gsq_rho_f500_gamma=0.22;
+  double gsq_omega_f500_gamma=(1./9)*gsq_rho_f500_gamma;
+  // Coupling constants: Donnachie and Kalashnikova (2008) scenario IV
+  double gsq_rho_S_gamma=0.02537;
+  double gsq_omega_S_gamma=0.2283;
+  double gsq_rho_f1370_gamma=0.094;
+  double gsq_omega_f1370_gamma=(1./9.)*gsq_rho_f1370_gamma;
+  double gsq_rho_a1450_gamma=0.0054;
+  double gsq_omega_a1450_gamma=9.*gsq_rho_a1450_gamma;
+
+  // CM energy
+  double s=m_p*(m_p+2.*Egamma);
+  double Ecm=sqrt(s);
+
+  // Momenta of incoming photon and outgoing S and proton in cm frame
+  double p_gamma=(s-m_p_sq)/(2.*Ecm);
+
+  // Mass of two-meson system     
+  double m1_plus_m2=m1+m2;
+  double m_max=m_p*(sqrt(1.+2.*Egamma/m_p)-1.);
+  double M=m1_plus_m2+u_M*(m_max-m1_plus_m2);
+  double M_sq=M*M;
+
+  // Momentum and energy of two-meson system
+  double E_S=(s+M_sq-m_p_sq)/(2.*Ecm);
+  double p_S=sqrt(E_S*E_S-M_sq);
+
+  // Momentum transfer t
+  double p_diff=p_gamma-p_S;
+  double t0=M_sq*M_sq/(4.*s)-p_diff*p_diff;
+  double sin_theta_over_2=0.;
+  t=t0;
+
+  // Polar angle in the cm frame and t
+  double theta_cm=acos(cos_theta_cm);
+  sin_theta_over_2=sin(0.5*theta_cm);
+  t=t0-4.*p_gamma*p_S*sin_theta_over_2*sin_theta_over_2;
+
+  // Generate phi using uniform distribution
+  double phi_cm=myrand->Uniform(2.*M_PI);
+
+  // beam 4-vector (ignoring px and py, which are extremely small)
+  beam.SetXYZT(0.,0.,Egamma,Egamma);
+
+  // Velocity of the cm frame with respect to the lab frame
+  TVector3 v_cm=(1./(Egamma+m_p))*beam.Vect();
+  // Four-momentum of the S in the CM frame
+  double pt=p_S*sin(theta_cm);
+  TLorentzVector S4(pt*cos(phi_cm),pt*sin(phi_cm),p_S*cos(theta_cm),
+		    sqrt(p_S*p_S+M_sq));
+  // S4.Print();
+
+  //Boost the S 4-momentum into the lab
+  S4.Boost(v_cm);
+  // S4.Print();
+
+
+  // Compute the 4-momentum for the recoil proton
+  TLorentzVector proton4=beam+target-S4;
+
+  // Generate decay of S according to phase space
+  TGenPhaseSpace phase_space;
+  phase_space.SetDecay(S4,num_decay_particles,decay_masses);
+  double weight=0.,rand_weight=1.;
+  do{
+    weight=phase_space.Generate();
+    rand_weight=myrand->Uniform(1.);
+  }
+  while (rand_weight>weight);
+
+  // Gather the particles in the reaction
+  particle_vectors[last_index]=proton4;
+  for (int j=0;j<num_decay_particles;j++){
+    particle_vectors[j]=*phase_space.GetDecay(j);
+  }
+
+  //Resonance parameters 
+  double ReB=0.,ImB=0,gR=0.;
+  double gR_T=0., ImB_T=0., ReB_T=0.;
+  double gRf500=0.,ImBf500=0.,ReBf500=0.; 
+  double gRf1370=0.,ImBf1370=0.,ReBf1370=0.;  
+  double gRa1450=0.,ImBa1450=0.,ReBa1450=0.;
+
+  // Cross section
+  double xsec=0.;
+
+  // f0(600)
+  if (got_pipi && generate[0]){
+    double m_Sigma=0.6;
+    double M_sq_R=m_Sigma*m_Sigma; 
+    width=1.0;
+    ReBf500=M_sq_R-M_sq;
+    double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
+    double temp=4.*m1sq*m2sq;
+    double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
+		   /(4.*M_sq_R));
+    double partial_width=width/3.;
+    gRf500=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
+    ImBf500=width*sqrt(M_sq);
+
+    xsec+=CrossSection(m1,m2,M_sq,s,t,gRf500,ReBf500,ImBf500,
+		       gsq_rho_f500_gamma,gsq_omega_f500_gamma);
+
+  }
+  // f0(1370)
+  if (got_pipi && generate[2]){
+    double m_f1370=1.25; // guess
+    double M_sq_R=m_f1370*m_f1370; 
+    width=0.5;  // estimate, top of PDG range
+    ReBf1370=M_sq_R-M_sq;
+    double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
+    double temp=4.*m1sq*m2sq;
+    double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
+		   /(4.*M_sq_R));
+    // partial width from Bugg(2007):arxiv.org/pdf/0706.1341.pdf, table 2
+    double partial_width=0.325/3.;
+    gRf1370=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
+    ImBf1370=width*sqrt(M_sq);
+
+    xsec+=CrossSection(m1,m2,M_sq,s,t,gRf1370,ReBf1370,ImBf1370,
+		       gsq_rho_f1370_gamma,gsq_omega_f1370_gamma);
+
+  }  
+  // Interference between f0(500) and f0(1370)
+  if (got_pipi && generate[0] && generate[2]){
+    xsec+=CrossSection(m1,m2,M_sq,s,t,gRf1370,ReBf1370,ImBf1370,
+		       gsq_rho_f1370_gamma,
+		       gsq_omega_f1370_gamma,true,gRf500,ReBf500,ImBf500,
+		       gsq_rho_f500_gamma,gsq_omega_f500_gamma,
+		       phase[9]);
+  }	
+
+  // a0(1450)
+  if (got_pipi==false && generate[2]){
+    double m_a1450=1.448;// Bugg:arXiv:0808.2706v2,Table 2
+    double M_sq_R=m_a1450*m_a1450; 
+    width=0.192; // Bugg:arXiv:0808.2706v2,Table 2
+    ReBa1450=M_sq_R-M_sq;
+    double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
+    double temp=4.*m1sq*m2sq;
+    double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
+		   /(4.*M_sq_R));	
+    double partial_width=0.0237;// Bugg:arXiv:0808.2706v2,Table 2
+    gRa1450=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
+    ImBa1450=width*sqrt(M_sq);
+
+    xsec+=CrossSection(m1,m2,M_sq,s,t,gRa1450,ReBa1450,ImBa1450,
+		       gsq_rho_a1450_gamma,gsq_omega_a1450_gamma);
+
+  }
+  // f0(980)/a0(980)
+  if (generate[1]){
+    double my_msq_R=0.9783*0.9783;
+    if (got_pipi){ // f0(980)	
+      double MRsq_minus_m1sq_m2sq=my_msq_R-m1sq_plus_m2sq;	
+      double temp=4.*m1sq*m2sq;
+      double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
+		     /(4.*my_msq_R));
+      double partial_width=0.05; //?? // guess from note in pdg
+      gR=sqrt(8.*M_PI*my_msq_R*partial_width/qR);
+      gsq_rho_S_gamma=0.159; // GeV^-2
+      gsq_omega_S_gamma=(1./9.)*gsq_rho_S_gamma;
+    }
+    else{ // a0(980)  
+      my_msq_R=0.9825*0.9825;	
+      double MRsq_minus_m1sq_m2sq=my_msq_R-m1sq_plus_m2sq;	
+      double temp=4.*m1sq*m2sq;
+      double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
+		     /(4.*my_msq_R));
+      double partial_width=0.06; //?? guess from note in pdg
+      gR=sqrt(8.*M_PI*my_msq_R*partial_width/qR);
+      gsq_rho_S_gamma=0.02537;
+      gsq_omega_S_gamma=9.*gsq_rho_S_gamma;
+    } 
+    GetResonanceParameters(m1,m2,M_sq,my_msq_R,ReB,ImB);
+    xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
+		       gsq_omega_S_gamma);
+    // Interference between f0(1370) and f0(980)
+    if (got_pipi && generate[2]){
+      xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
+			 gsq_omega_S_gamma,true,gRf1370,ReBf1370,ImBf1370,
+			 gsq_rho_f1370_gamma,gsq_omega_f1370_gamma,
+			 phase[1]);
+    }	
+    // Interference between f0(500) and f0(980)
+    if (got_pipi && generate[0]){
+      xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
+			 gsq_omega_S_gamma,true,gRf500,ReBf500,ImBf500,
+			 gsq_rho_f500_gamma,gsq_omega_f500_gamma,
+			 phase[0]);
+    }	
+    // Interference between a0(1450) and a0(980)
+    if (got_pipi==false && generate[2]){
+      xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
+			 gsq_omega_S_gamma,true,gRa1450,ReBa1450,ImBa1450,
+			 gsq_rho_a1450_gamma,gsq_omega_a1450_gamma,
+			 phase[1]);
+    }
+  }
+  if (generate[4]){ // non-resonant background
+    xsec+=BackgroundCrossSection(beam,particle_types,particle_vectors);
+
+    if (generate[1]){ // interference with resonant signal
+      xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
+				     gR,ReB,ImB,gsq_rho_S_gamma,
+				     gsq_omega_S_gamma,phase[3]);
+    }
+    if (got_pipi){
+      if (generate[0]){ // interference with f0(500)
+	xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
+				       gRf500,ReBf500,ImBf500,
+				       gsq_rho_f500_gamma,
+				       gsq_omega_f500_gamma,phase[7]);
+      }  
+      if (generate[2]){ // interference with f0(1370)
+	xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
+				       gRf1370,ReBf1370,ImBf1370,
+				       gsq_rho_f1370_gamma,
+				       gsq_omega_f1370_gamma,phase[8]);
+      }
+    }
+    else{ 
+      if (generate[2]){ // interference with a0(1450)
+	xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
+				       gRa1450,ReBa1450,ImBa1450,
+				       gsq_rho_a1450_gamma,
+				       gsq_omega_a1450_gamma,0.);
+      }
+
+    }
+  }
+  if (generate[3]){ // Tensor background
+    double m_T=1.275;	
+    double Gamma_T=0.185;
+    if (!got_pipi){
+      Gamma_T=0.107;
+      m_T=1.3183;
+    }
+    double M_sq_R_T=m_T*m_T; 
+    ReB_T=M_sq_R_T-M_sq;
+    double Msq_minus_m1sq_m2sq=M_sq-m1sq_plus_m2sq;
+    double MRsq_minus_m1sq_m2sq=M_sq_R_T-m1sq_plus_m2sq;
+    double temp=4.*m1sq*m2sq;
+    double q_over_qR
+      =m_T/M*sqrt((Msq_minus_m1sq_m2sq*Msq_minus_m1sq_m2sq-temp)
+		  /(MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp));
+    double q_over_qR_5=pow(q_over_qR,5);
+    if (got_pipi){ // f2(1270)  
+      double partial_width=0.85*(1./3.)*M_sq_R_T*q_over_qR_5/M_sq;
+      gR_T=sqrt(8.*M_PI*M_sq_R_T*partial_width*q_over_qR);
+      ImB_T=M*Gamma_T*(0.85*q_over_qR_5*M_sq_R_T/M_sq+0.15);
+    }
+    else { // a2(1320)
+      double partial_width=0.155*M_sq_R_T*q_over_qR_5/M_sq;
+      gR_T=sqrt(8.*M_PI*M_sq_R_T*partial_width*q_over_qR);
+      ImB_T=M*Gamma_T*(0.145*q_over_qR_5*M_sq_R_T/M_sq+0.855);
+    }
+    xsec+=TensorCrossSection(beam,particle_types,particle_vectors,
+			     gR_T,ReB_T,ImB_T);
+    if (generate[1]){ // interference with a0(980)/f0(980)
+      xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
+				     gR_T,ReB_T,ImB_T,gR,ReB,ImB,
+				     sqrt(gsq_omega_S_gamma),
+				     sqrt(gsq_rho_S_gamma),phase[2]);
+    }
+    // interference with f0(600)
+    if (got_pipi && generate[0]){
+      xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
+				     gR_T,ReB_T,ImB_T,gRf500,ReBf500,
+				     ImBf500,
+				     sqrt(gsq_omega_f500_gamma),
+				     sqrt(gsq_rho_f500_gamma),phase[5]);
+    }
+    // interference with f0(1370)
+    if (got_pipi && generate[2]){
+      xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
+				     gR_T,ReB_T,ImB_T,gRf1370,ReBf1370,
+				     ImBf1370,
+				     sqrt(gsq_omega_f1370_gamma),
+				     sqrt(gsq_rho_f1370_gamma),phase[6]);
+    }	
+    // interference with a0(1450)
+    if (got_pipi==false && generate[2]){
+      xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
+				     gR_T,ReB_T,ImB_T,gRa1450,ReBa1450,
+				     ImBa1450,
+				     sqrt(gsq_omega_a1450_gamma),
+				     sqrt(gsq_rho_a1450_gamma),phase[6]);
+    }
+
+    if (generate[4]){ //interference with background wave
+      xsec+=TensorBackgroundInterference(beam,particle_types,
+					 particle_vectors,
+					 gR_T,ReB_T,ImB_T,phase[4]);
+    }
+
+  }
+
+  return xsec;
+}
+
 int main(int narg, char *argv[])
 {  
   ParseCommandLineArguments(narg, argv);
@@ -2691,9 +3040,6 @@ int main(int narg, char *argv[])
   // Initialize random number generator
   TRandom3 *myrand=new TRandom3(0);// If seed is 0, the seed is automatically computed via a TUUID object, according to TRandom3 documentation
 
-  // Fixed target
-  TLorentzVector target(0.,0.,0.,m_p);
-
   //----------------------------------------------------------------------------
   // Get production (Egamma range) and decay parameters from input file
   //----------------------------------------------------------------------------
@@ -2778,355 +3124,80 @@ int main(int narg, char *argv[])
   // masses of decay particles
   double m1=decay_masses[0];
   double m2=decay_masses[1];
-  bool got_pipi=(fabs(m1-m2)>0.01)?false:true;
 
-  double mymax=0.;
   //----------------------------------------------------------------------------
-  // Event generation loop
+  // Adaptive envelope
   //----------------------------------------------------------------------------
-  for (int i=1;i<=Nevents;i++){
-    // photon beam
-    double Egamma=0.;
-    TLorentzVector beam;
-
-    // Maximum value for cross section 
-    double xsec_max=(got_pipi)?10.0:3.5;
-    double xsec=0.,xsec_test=0.;
-
-    // Polar angle in center of mass frame
-    double theta_cm=0.;
-
-    // Scalar momentum in cm
-    double p_S=0.;
-
-    // Mass squared of resonance
-    double M_sq=0.;
+  // The beam energy (as a fraction of the integrated flux), the fraction of
+  // the allowed two-meson mass range and cos(theta_cm) are drawn from a grid
+  // that is trained on the cross section during a warm-up phase.  Events are
+  // then accepted with probability weight/weight_max, where the weight is the
+  // cross section times the jacobian of the grid.
+  VegasGrid grid(3,vegas_bins);
+  double x[3];
+  double Egamma=0.,t=0.;
+  TLorentzVector beam;
+  double weight_max=0.,weight_mean=0.;
+  for (int iter=0;iter<=vegas_iterations;iter++){
+    double weight_sum=0.;
+    weight_max=0.;
+    for (int k=0;k<Nwarmup;k++){
+      double jacobian=grid.Sample(myrand,x);
+      double xsec=EventCrossSection(EgammaFromFlux(x[0]),x[1],-1.+2.*x[2],
+				    myrand,m1,m2,decay_masses,generate,phase,
+				    beam,t,particle_types,particle_vectors);
+      double weight=(xsec>0.)?xsec*jacobian:0.;
+      weight_sum+=weight;
+      if (weight>weight_max) weight_max=weight;
+      grid.Accumulate(weight);
+    }
+    weight_mean=weight_sum/Nwarmup;
+    cout << "Warm-up pass " << iter+1 << ": mean weight " << weight_mean
+	 << ", maximum weight " << weight_max << endl;
+    // The last pass only measures the maximum weight on the final grid
+    if (iter<vegas_iterations) grid.Refine();
+  }
+  if (weight_max<=0.){
+    cerr << "Cross section is zero everywhere in the warm-up! Exiting..." 
+	 << endl;
+    exit(-1);
+  }
+  weight_max*=weight_max_safety;
+  cout << "Expected acceptance " << weight_mean/weight_max << endl;
 
-    // Transfer 4-momentum;
-    double t=0.;
+  // Keep track of events whose weight exceeds the maximum
+  int num_violations=0;
+  double worst_violation=1.;
+  double num_trials=0.;
 
+  //----------------------------------------------------------------------------
+  // Event generation loop
+  //----------------------------------------------------------------------------
+  for (int i=1;i<=Nevents;i++){
     // vertex position at target
     float vert[4]={0.,0.,0.,0.};
 
-    // masses of decay particles
-    double m1sq=m1*m1;
-    double m2sq=m2*m2;
-    double m1sq_plus_m2sq=m1sq+m2sq;
-
-    // Coupling constants for f0(500)
-    double gsq_rho_f500_gamma=0.22;
-    double gsq_omega_f500_gamma=(1./9)*gsq_rho_f500_gamma;
-    // Coupling constants: Donnachie and Kalashnikova (2008) scenario IV
-    double gsq_rho_S_gamma=0.02537;
-    double gsq_omega_S_gamma=0.2283;
-    double gsq_rho_f1370_gamma=0.094;
-    double gsq_omega_f1370_gamma=(1./9.)*gsq_rho_f1370_gamma;
-    double gsq_rho_a1450_gamma=0.0054;
-    double gsq_omega_a1450_gamma=9.*gsq_rho_a1450_gamma;
-
     // use the rejection method to produce S's based on the cross section
+    double weight=0.;
     do{
-      // First generate a beam photon using bremsstrahlung spectrum
-      Egamma = cobrems_vs_E->GetRandom();
-
-      // CM energy
-      double s=m_p*(m_p+2.*Egamma);
-      double Ecm=sqrt(s);
-
-      // Momenta of incoming photon and outgoing S and proton in cm frame
-      double p_gamma=(s-m_p_sq)/(2.*Ecm);
-
-      // Mass of two-meson system     
-      double m1_plus_m2=m1+m2;
-      double m_max=m_p*(sqrt(1.+2.*Egamma/m_p)-1.);
-      double M=m1_plus_m2+myrand->Uniform(m_max-m1_plus_m2);
-      M_sq=M*M;
-
-      // Momentum and energy of two-meson system
-      double E_S=(s+M_sq-m_p_sq)/(2.*Ecm);
-      p_S=sqrt(E_S*E_S-M_sq);
-    
-      // Momentum transfer t
-      double p_diff=p_gamma-p_S;
-      double t0=M_sq*M_sq/(4.*s)-p_diff*p_diff;
-      double sin_theta_over_2=0.;
-      t=t0;
-
-      // Generate cos(theta) with a uniform distribution and compute the cross 
-      // section at this value
-      double cos_theta_cm=-1.0+myrand->Uniform(2.);
-      theta_cm=acos(cos_theta_cm);
-      // compute t
-      sin_theta_over_2=sin(0.5*theta_cm);
-      t=t0-4.*p_gamma*p_S*sin_theta_over_2*sin_theta_over_2;
-
-      // Generate phi using uniform distribution
-      double phi_cm=myrand->Uniform(2.*M_PI);
-
-      // beam 4-vector (ignoring px and py, which are extremely small)
-      beam.SetXYZT(0.,0.,Egamma,Egamma);
-   
-      // Velocity of the cm frame with respect to the lab frame
-      TVector3 v_cm=(1./(Egamma+m_p))*beam.Vect();
-      // Four-momentum of the S in the CM frame
-      double pt=p_S*sin(theta_cm);
-      TLorentzVector S4(pt*cos(phi_cm),pt*sin(phi_cm),p_S*cos(theta_cm),
-			sqrt(p_S*p_S+M_sq));
-      // S4.Print();
-      
-      //Boost the S 4-momentum into the lab
-      S4.Boost(v_cm);
-      // S4.Print();
-      
-      
-      // Compute the 4-momentum for the recoil proton
-      TLorentzVector proton4=beam+target-S4;
-      
-      // Generate decay of S according to phase space
-      TGenPhaseSpace phase_space;
-      phase_space.SetDecay(S4,num_decay_particles,decay_masses);
-      double weight=0.,rand_weight=1.;
-      do{
-	weight=phase_space.Generate();
-	rand_weight=myrand->Uniform(1.);
-      }
-      while (rand_weight>weight);
-      
-      // Gather the particles in the reaction and write out event in hddm format
-      particle_vectors[last_index]=proton4;
-      for (int j=0;j<num_decay_particles;j++){
-	particle_vectors[j]=*phase_space.GetDecay(j);
-      }
-
-      //Resonance parameters 
-      double ReB=0.,ImB=0,gR=0.;
-      double gR_T=0., ImB_T=0., ReB_T=0.;
-      double gRf500=0.,ImBf500=0.,ReBf500=0.; 
-      double gRf1370=0.,ImBf1370=0.,ReBf1370=0.;  
-      double gRa1450=0.,ImBa1450=0.,ReBa1450=0.;
-
-      // Cross section
-      xsec=0.;
-      
-      // f0(600)
-      if (got_pipi && generate[0]){
- 	double m_Sigma=0.6;
-	double M_sq_R=m_Sigma*m_Sigma; 
-	width=1.0;
-	ReBf500=M_sq_R-M_sq;
-	double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
-	double temp=4.*m1sq*m2sq;
-	double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
-		       /(4.*M_sq_R));
-	double partial_width=width/3.;
-	gRf500=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
-	ImBf500=width*sqrt(M_sq);
-
-	xsec+=CrossSection(m1,m2,M_sq,s,t,gRf500,ReBf500,ImBf500,
-			   gsq_rho_f500_gamma,gsq_omega_f500_gamma);
-       
-      }
-      // f0(1370)
-      if (got_pipi && generate[2]){
- 	double m_f1370=1.25; // guess
-	double M_sq_R=m_f1370*m_f1370; 
-	width=0.5;  // estimate, top of PDG range
-	ReBf1370=M_sq_R-M_sq;
-	double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
-	double temp=4.*m1sq*m2sq;
-	double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
-		       /(4.*M_sq_R));
-	// partial width from Bugg(2007):arxiv.org/pdf/0706.1341.pdf, table 2
-	double partial_width=0.325/3.;
-	gRf1370=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
-	ImBf1370=width*sqrt(M_sq);
-
-	xsec+=CrossSection(m1,m2,M_sq,s,t,gRf1370,ReBf1370,ImBf1370,
-			   gsq_rho_f1370_gamma,gsq_omega_f1370_gamma);
-       
-      }  
-      // Interference between f0(500) and f0(1370)
-      if (got_pipi && generate[0] && generate[2]){
-	xsec+=CrossSection(m1,m2,M_sq,s,t,gRf1370,ReBf1370,ImBf1370,
-			   gsq_rho_f1370_gamma,
-			   gsq_omega_f1370_gamma,true,gRf500,ReBf500,ImBf500,
-			   gsq_rho_f500_gamma,gsq_omega_f500_gamma,
-			   phase[9]);
-      }	
-
-      // a0(1450)
-      if (got_pipi==false && generate[2]){
- 	double m_a1450=1.448;// Bugg:arXiv:0808.2706v2,Table 2
-	double M_sq_R=m_a1450*m_a1450; 
-	width=0.192; // Bugg:arXiv:0808.2706v2,Table 2
-	ReBa1450=M_sq_R-M_sq;
-	double MRsq_minus_m1sq_m2sq=M_sq_R-m1sq_plus_m2sq;
-	double temp=4.*m1sq*m2sq;
-	double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
-		       /(4.*M_sq_R));	
-	double partial_width=0.0237;// Bugg:arXiv:0808.2706v2,Table 2
-	gRa1450=sqrt(8.*M_PI*M_sq_R*partial_width/qR);
-	ImBa1450=width*sqrt(M_sq);
-
-	xsec+=CrossSection(m1,m2,M_sq,s,t,gRa1450,ReBa1450,ImBa1450,
-			   gsq_rho_a1450_gamma,gsq_omega_a1450_gamma);
-       
-      }
-      // f0(980)/a0(980)
-      if (generate[1]){
-	double my_msq_R=0.9783*0.9783;
-	if (got_pipi){ // f0(980)	
-	  double MRsq_minus_m1sq_m2sq=my_msq_R-m1sq_plus_m2sq;	
-	  double temp=4.*m1sq*m2sq;
-	  double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
-			 /(4.*my_msq_R));
-	  double partial_width=0.05; //?? // guess from note in pdg
-	  gR=sqrt(8.*M_PI*my_msq_R*partial_width/qR);
-	  gsq_rho_S_gamma=0.159; // GeV^-2
-	  gsq_omega_S_gamma=(1./9.)*gsq_rho_S_gamma;
-	}
-	else{ // a0(980)  
-	  my_msq_R=0.9825*0.9825;	
-	  double MRsq_minus_m1sq_m2sq=my_msq_R-m1sq_plus_m2sq;	
-	  double temp=4.*m1sq*m2sq;
-	  double qR=sqrt((MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp)
-			 /(4.*my_msq_R));
-	  double partial_width=0.06; //?? guess from note in pdg
-	  gR=sqrt(8.*M_PI*my_msq_R*partial_width/qR);
-	  gsq_rho_S_gamma=0.02537;
-	  gsq_omega_S_gamma=9.*gsq_rho_S_gamma;
-	} 
-	GetResonanceParameters(m1,m2,M_sq,my_msq_R,ReB,ImB);
-	xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
-			   gsq_omega_S_gamma);
-	// Interference between f0(1370) and f0(980)
-	if (got_pipi && generate[2]){
-	  xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
-			     gsq_omega_S_gamma,true,gRf1370,ReBf1370,ImBf1370,
-			     gsq_rho_f1370_gamma,gsq_omega_f1370_gamma,
-			     phase[1]);
-	}	
-	// Interference between f0(500) and f0(980)
-	if (got_pipi && generate[0]){
-	  xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
-			     gsq_omega_S_gamma,true,gRf500,ReBf500,ImBf500,
-			     gsq_rho_f500_gamma,gsq_omega_f500_gamma,
-			     phase[0]);
-	}	
-	// Interference between a0(1450) and a0(980)
-	if (got_pipi==false && generate[2]){
-	  xsec+=CrossSection(m1,m2,M_sq,s,t,gR,ReB,ImB,gsq_rho_S_gamma,
-			     gsq_omega_S_gamma,true,gRa1450,ReBa1450,ImBa1450,
-			     gsq_rho_a1450_gamma,gsq_omega_a1450_gamma,
-			     phase[1]);
+      num_trials++;
+      double jacobian=grid.Sample(myrand,x);
+      Egamma=EgammaFromFlux(x[0]);
+      double xsec=EventCrossSection(Egamma,x[1],-1.+2.*x[2],myrand,m1,m2,
+				    decay_masses,generate,phase,beam,t,
+				    particle_types,particle_vectors);
+      weight=(xsec>0.)?xsec*jacobian:0.;
+      if (weight>weight_max){
+	// The envelope is too low here, so events in this region have been
+	// undersampled up to now: raise it from here on and report it
+	num_violations++;
+	if (weight/weight_max>worst_violation){
+	  worst_violation=weight/weight_max;
 	}
+	weight_max=weight;
       }
-      if (generate[4]){ // non-resonant background
-	xsec+=BackgroundCrossSection(beam,particle_types,particle_vectors);
-
-	if (generate[1]){ // interference with resonant signal
-	  xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
-	  				 gR,ReB,ImB,gsq_rho_S_gamma,
-					 gsq_omega_S_gamma,phase[3]);
-	}
-	if (got_pipi){
-	  if (generate[0]){ // interference with f0(500)
-	    xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
-					   gRf500,ReBf500,ImBf500,
-					   gsq_rho_f500_gamma,
-					   gsq_omega_f500_gamma,phase[7]);
-	  }  
-	  if (generate[2]){ // interference with f0(1370)
-	    xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
-					   gRf1370,ReBf1370,ImBf1370,
-					   gsq_rho_f1370_gamma,
-					   gsq_omega_f1370_gamma,phase[8]);
-	  }
-	}
-	else{ 
-	  if (generate[2]){ // interference with a0(1450)
-	    xsec+=InterferenceCrossSection(beam,particle_types,particle_vectors,
-					   gRa1450,ReBa1450,ImBa1450,
-					   gsq_rho_a1450_gamma,
-					   gsq_omega_a1450_gamma,0.);
-	  }
-	  
-	}
-      }
-      if (generate[3]){ // Tensor background
-	double m_T=1.275;	
-	double Gamma_T=0.185;
-	if (!got_pipi){
-	  Gamma_T=0.107;
-	  m_T=1.3183;
-	}
-	double M_sq_R_T=m_T*m_T; 
-	ReB_T=M_sq_R_T-M_sq;
-	double Msq_minus_m1sq_m2sq=M_sq-m1sq_plus_m2sq;
-	double MRsq_minus_m1sq_m2sq=M_sq_R_T-m1sq_plus_m2sq;
-	double temp=4.*m1sq*m2sq;
-	double q_over_qR
-	  =m_T/M*sqrt((Msq_minus_m1sq_m2sq*Msq_minus_m1sq_m2sq-temp)
-		      /(MRsq_minus_m1sq_m2sq*MRsq_minus_m1sq_m2sq-temp));
-	double q_over_qR_5=pow(q_over_qR,5);
-	if (got_pipi){ // f2(1270)  
-	  double partial_width=0.85*(1./3.)*M_sq_R_T*q_over_qR_5/M_sq;
-	  gR_T=sqrt(8.*M_PI*M_sq_R_T*partial_width*q_over_qR);
-	  ImB_T=M*Gamma_T*(0.85*q_over_qR_5*M_sq_R_T/M_sq+0.15);
-	}
-	else { // a2(1320)
-	  double partial_width=0.155*M_sq_R_T*q_over_qR_5/M_sq;
-	  gR_T=sqrt(8.*M_PI*M_sq_R_T*partial_width*q_over_qR);
-	  ImB_T=M*Gamma_T*(0.145*q_over_qR_5*M_sq_R_T/M_sq+0.855);
-	}
-	xsec+=TensorCrossSection(beam,particle_types,particle_vectors,
-				 gR_T,ReB_T,ImB_T);
-	if (generate[1]){ // interference with a0(980)/f0(980)
-	  xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
-					 gR_T,ReB_T,ImB_T,gR,ReB,ImB,
-					 sqrt(gsq_omega_S_gamma),
-					 sqrt(gsq_rho_S_gamma),phase[2]);
-	}
-	// interference with f0(600)
-	if (got_pipi && generate[0]){
-	  xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
-					 gR_T,ReB_T,ImB_T,gRf500,ReBf500,
-					 ImBf500,
-					 sqrt(gsq_omega_f500_gamma),
-					 sqrt(gsq_rho_f500_gamma),phase[5]);
-	}
-	// interference with f0(1370)
-	if (got_pipi && generate[2]){
-	  xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
-					 gR_T,ReB_T,ImB_T,gRf1370,ReBf1370,
-					 ImBf1370,
-					 sqrt(gsq_omega_f1370_gamma),
-					 sqrt(gsq_rho_f1370_gamma),phase[6]);
-	}	
-	// interference with a0(1450)
-	if (got_pipi==false && generate[2]){
-	  xsec+=TensorScalarInterference(beam,particle_types,particle_vectors,
-					 gR_T,ReB_T,ImB_T,gRa1450,ReBa1450,
-					 ImBa1450,
-					 sqrt(gsq_omega_a1450_gamma),
-					 sqrt(gsq_rho_a1450_gamma),phase[6]);
-	}
-	
-	if (generate[4]){ //interference with background wave
-	  xsec+=TensorBackgroundInterference(beam,particle_types,
-					     particle_vectors,
-					     gR_T,ReB_T,ImB_T,phase[4]);
-	}
-	
-      }
-     if (xsec>mymax ) mymax=xsec;
-      
-
-
-      // Generate a test value for the cross section
-      xsec_test=myrand->Uniform(xsec_max);
     }
-    while (xsec_test>xsec);
+    while (myrand->Uniform(weight_max)>weight);
 
     // Other diagnostic histograms
     thrown_t->Fill(-t);
@@ -3153,8 +3224,15 @@ int main(int narg, char *argv[])
   close_s_HDDM(file);
   cout<<endl<<"Closed HDDM file"<<endl;
   cout<<" "<<Nevents<<" event written to "<<output_file_name<<endl;
-
-    cout << mymax << endl;
+  cout<<" "<<num_trials<<" trials, acceptance "<<Nevents/num_trials<<endl;
+
+  if (num_violations>0){
+    cerr << "WARNING: the weight exceeded its estimated maximum "
+	 << num_violations << " times, by up to a factor " << worst_violation
+	 << "." << endl
+	 << "The events generated before the maximum was raised are biased;"
+	 << " rerun with more warm-up points (-W)." << endl;
+  }
 
   return 0;
 }
@@ -100,6 +100,7 @@ CobremsGenerator::CobremsGenerator(double Emax_GeV, double Epeak_GeV)
    fTargetThickness = 20e-6; // m
    fTargetThetay = 0.050; // radians
    fTargetThetaz = 0; // radians
+   fLatticeTermsValid = false;
    setTargetCrystal("diamond");
    setCoherentEdge(Epeak_GeV);
    fPhotonEnergyMin = 0.211; // GeV
@@ -116,6 +117,7 @@ CobremsGenerator::CobremsGenerator(double Emax_GeV, double Epeak_GeV)
 
 void CobremsGenerator::setTargetCrystal(std::string crystal)
 {
+   fLatticeTermsValid = false;
    // declare the radiator target crystal type by name
 
    if (crystal == "diamond") {
@@ -471,6 +473,7 @@ CobremsGenerator::CobremsGenerator(const CobremsGenerator &src)
    fCollimatorDiameter = src.fCollimatorDiameter;
    fQ2theta2 = src.fQ2theta2;
    fQ2weight = src.fQ2weight;
+   fLatticeTermsValid = false;
 }
 
 CobremsGenerator &CobremsGenerator::operator=(const CobremsGenerator &src)
@@ -493,6 +496,7 @@ CobremsGenerator &CobremsGenerator::operator=(const CobremsGenerator &src)
    fCollimatorDiameter = src.fCollimatorDiameter;
    fQ2theta2 = src.fQ2theta2;
    fQ2weight = src.fQ2weight;
+   fLatticeTermsValid = false;
    return *this;
 }
 
@@ -574,26 +578,19 @@ double CobremsGenerator::Rate_dNcdx(double x,
    return rate;
 }
 
-double CobremsGenerator::Rate_dNcdxdp(double x, double phi)
+void CobremsGenerator::buildLatticeTerms()
 {
-   // Returns the coherent bremsstrahlung probabililty density differential
-   // in x (scaled photon energy) and phi (azimuthal emission angle) for
-   // fixed photon energy k = x*fBeamEnergy and phi. If fPolarizedFlag is
-   // false (0, default) then the total yield is returned, otherwise it is
-   // only the polarized fraction. If fCollimatedFlag is false (0) then
-   // the total yield is returned, otherwise only the part that passes the
-   // collimator is counted (default).
+   // Enumerates the reciprocal lattice vectors that can contribute to
+   // Rate_dNcdxdp, in the lab frame, keeping only those with a non-zero
+   // structure factor and 0 < xmax <= 1. None of this depends on x or
+   // phi, so it is done once per change of crystal, orientation or
+   // beam energy rather than on every call.
 
-   double Z = fTargetCrystal.Z;
    double a = fTargetCrystal.lattice_constant;
-   double sigma0 = 16 * dpi * fTargetThickness * Z*Z * pow(alpha, 3) *
-                   fBeamEnergy * hbarc/(a*a) * pow(hbarc / (a * me), 4);
+   double qnorm = hbarc * 2 * dpi / a;
+   double betaFF2 = pow(fTargetCrystal.betaFF, 2);
 
-   fQ2theta2.clear();
-   fQ2weight.clear();
-   double qzmin = 99;
-   int hmin, kmin, lmin;
-   double sum = 0;
+   fLatticeTerms.clear();
    // can restrict to h=0 for cpu speedup, if crystal alignment is "reasonable"
    for (int h = -4; h <= 4; ++h) {
       for (int k = -10; k <= 10; ++k) {
@@ -620,7 +617,6 @@ double CobremsGenerator::Rate_dNcdxdp(double x, double phi)
             double S2 = ReS*ReS + ImS*ImS;
             if (S2 < 1e-4)
                continue;
-            double qnorm = hbarc * 2 * dpi / a;
             double q[3];
             q[0] = qnorm * (fTargetRmatrix[0][0] * h +
                             fTargetRmatrix[0][1] * k +
@@ -631,42 +627,80 @@ double CobremsGenerator::Rate_dNcdxdp(double x, double phi)
             q[2] = qnorm * (fTargetRmatrix[2][0] * h +
                             fTargetRmatrix[2][1] * k +
                             fTargetRmatrix[2][2] * l);
-            double q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
-            double qT2 = q[0]*q[0] + q[1]*q[1];
             double xmax = 2 * fBeamEnergy * q[2];
             xmax /= xmax + me*me;
-            if (x > xmax || xmax > 1) {
+            if (xmax <= 0 || xmax > 1)   // x > 0 always
                continue;
-            }
+            lattice_term term;
+            term.h = h;
+            term.k = k;
+            term.l = l;
+            term.S2 = S2;
+            term.q2 = q[0]*q[0] + q[1]*q[1] + q[2]*q[2];
+            term.qz = q[2];
+            term.xmax = xmax;
+            double qT2 = q[0]*q[0] + q[1]*q[1];
+            double FF = 1 / (1 + term.q2 * betaFF2);
+            term.weight = qT2 * S2 * pow(FF * betaFF2, 2) *
+                          exp(-term.q2 * fTargetCrystal.Debye_Waller_const);
+            fLatticeTerms.push_back(term);
+         }
+      }
+   }
+   fLatticeTermsValid = true;
+}
+
+double CobremsGenerator::Rate_dNcdxdp(double x, double phi)
+{
+   // Returns the coherent bremsstrahlung probabililty density differential
+   // in x (scaled photon energy) and phi (azimuthal emission angle) for
+   // fixed photon energy k = x*fBeamEnergy and phi. If fPolarizedFlag is
+   // false (0, default) then the total yield is returned, otherwise it is
+   // only the polarized fraction. If fCollimatedFlag is false (0) then
+   // the total yield is returned, otherwise only the part that passes the
+   // collimator is counted (default).
+   if (!fLatticeTermsValid)
+      buildLatticeTerms();
+
+   double Z = fTargetCrystal.Z;
+   double a = fTargetCrystal.lattice_constant;
+   double sigma0 = 16 * dpi * fTargetThickness * Z*Z * pow(alpha, 3) *
+                   fBeamEnergy * hbarc/(a*a) * pow(hbarc / (a * me), 4);
+   double cos2phi = pow(cos(phi), 2);
+
+   fQ2theta2.clear();
+   fQ2weight.clear();
+   double qzmin = 99;
+   int hmin, kmin, lmin;
+   double sum = 0;
+   for (unsigned int n=0; n < fLatticeTerms.size(); ++n) {
+      const lattice_term &term = fLatticeTerms[n];
+      double xmax = term.xmax;
+      if (x > xmax) {
+         continue;
+      }
 
 #if COBREMS_GENERATOR_VERBOSITY > 2
-            else {
-               std::cout << h << "," << k << "," << l << ","
-                         << S2 << "," << q2 << "," << xmax
-                         << std::endl;
-            }
+      std::cout << term.h << "," << term.k << "," << term.l << ","
+                << term.S2 << "," << term.q2 << "," << xmax
+                << std::endl;
 #endif
 
-            if (q[2] < qzmin) {
-               qzmin = q[2];
-               hmin = h;
-               kmin = k;
-               lmin = l;
-            }
-            double theta2 = (1 - x) * xmax / (x * (1 - xmax)) - 1;
-            double betaFF2 = pow(fTargetCrystal.betaFF, 2);
-            double FF = 1 / (1 + q2 * betaFF2);
-            sum += sigma0 * qT2 * S2 * pow(FF * betaFF2, 2) *
-                   exp(-q2 * fTargetCrystal.Debye_Waller_const) *
-                   ((1 - x) / pow(x * (1 + theta2), 2)) *
-                   ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
-                                              (1 - x) * pow(cos(phi), 2))) *
-                   ((fCollimatedFlag)? Acceptance(theta2) : 1) *
-                   ((fPolarizedFlag)? Polarization(x, theta2) : 1);
-            fQ2theta2.push_back(theta2);
-            fQ2weight.push_back(sum);
-         }
+      if (term.qz < qzmin) {
+         qzmin = term.qz;
+         hmin = term.h;
+         kmin = term.k;
+         lmin = term.l;
       }
+      double theta2 = (1 - x) * xmax / (x * (1 - xmax)) - 1;
+      sum += sigma0 * term.weight *
+             ((1 - x) / pow(x * (1 + theta2), 2)) *
+             ((1 + pow(1 - x, 2)) - 8 * (theta2 / pow(1 + theta2, 2) * 
+                                        (1 - x) * cos2phi)) *
+             ((fCollimatedFlag)? Acceptance(theta2) : 1) *
+             ((fPolarizedFlag)? Polarization(x, theta2) : 1);
+      fQ2theta2.push_back(theta2);
+      fQ2weight.push_back(sum);
    }
 
 #if COBREMS_GENERATOR_VERBOSITY > 1
@@ -680,6 +714,17 @@ double CobremsGenerator::Rate_dNcdxdp(double x, double phi)
    return sum;
 }
 
+void CobremsGenerator::Rate_dNcdxdp(int npoints, const double *x, const double *phi,
+                                double *rate)
+{
+   // Evaluates Rate_dNcdxdp(x[i], phi[i]) into rate[i] for npoints
+   // points, sharing one lookup of the lattice terms. On return the
+   // statistical record fQ2theta2, fQ2weight is that of the last point.
+
+   for (int i=0; i < npoints; ++i)
+      rate[i] = Rate_dNcdxdp(x[i], phi[i]);
+}
+
 double CobremsGenerator::Rate_dNidx(double x)
 {
    // Returns the incoherent bremsstrahlung probabililty density differential
@@ -902,6 +947,7 @@ void CobremsGenerator::RotateTarget(double thetax,
    //   Rmatrix(out) = Rx(thx) Ry(thy) Rz(thz) Rmatrix(in)
    // with rotations understood in the passive sense.
 
+   fLatticeTermsValid = false;
    if (thetaz != 0) {
       double sint = sin(thetaz);
       double cost = cos(thetaz);
@@ -1065,6 +1111,7 @@ double (CobremsGenerator::*Rate_dNtdx_1)(double) = &CobremsGenerator::Rate_dNtdx
 double (CobremsGenerator::*Rate_dNtdx_3)(double, double, double) = &CobremsGenerator::Rate_dNtdx;
 double (CobremsGenerator::*Rate_dNcdx_1)(double) = &CobremsGenerator::Rate_dNcdx;
 double (CobremsGenerator::*Rate_dNcdx_3)(double, double, double) = &CobremsGenerator::Rate_dNcdx;
+double (CobremsGenerator::*Rate_dNcdxdp_2)(double, double) = &CobremsGenerator::Rate_dNcdxdp;
 double (CobremsGenerator::*Acceptance_1)(double) = &CobremsGenerator::Acceptance;
 double (CobremsGenerator::*Acceptance_4)(double, double, double, double) = &CobremsGenerator::Acceptance;
 
@@ -1129,7 +1176,7 @@ BOOST_PYTHON_MODULE(libcobrems)
       .def("Rate_dNtdk", &CobremsGenerator::Rate_dNtdk)
       .def("Rate_dNcdx", Rate_dNcdx_1)
       .def("Rate_dNcdx", Rate_dNcdx_3)
-      .def("Rate_dNcdxdp", &CobremsGenerator::Rate_dNcdxdp)
+      .def("Rate_dNcdxdp", Rate_dNcdxdp_2)
       .def("Rate_dNidx", &CobremsGenerator::Rate_dNidx)
       .def("Rate_dNBidx", &CobremsGenerator::Rate_dNBidx)
       .def("Rate_dNidxdt2", &CobremsGenerator::Rate_dNidxdt2)
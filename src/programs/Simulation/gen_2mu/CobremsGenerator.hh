@@ -142,6 +142,8 @@ class CobremsGenerator {
    double Rate_dNcdx(double x);
    double Rate_dNcdx(double x, double distance_m, double diameter_m);
    double Rate_dNcdxdp(double x, double phi);
+   void Rate_dNcdxdp(int npoints, const double *x, const double *phi,
+                     double *rate);
    double Rate_dNidx(double x);
    double Rate_dNBidx(double x);
    double Rate_dNidxdt2(double x, double theta2);
@@ -209,6 +211,22 @@ class CobremsGenerator {
    double fTargetThetaz;
    double fTargetRmatrix[3][3];
 
+   // reciprocal lattice vectors that can contribute to the coherent
+   // rate for the present crystal, orientation and beam energy, with
+   // the factors of the rate that depend only on q; rebuilt by
+   // Rate_dNcdxdp after any of those have changed
+   struct lattice_term {
+      int h, k, l;
+      double S2;
+      double q2;
+      double qz;
+      double xmax;
+      double weight;                   // qT2 S2 (FF betaFF^2)^2 exp(-q2 DW)
+   };
+   std::vector<lattice_term> fLatticeTerms;
+   bool fLatticeTermsValid;
+   void buildLatticeTerms();
+
    // description of the beam at the radiator
    double fBeamEnergy;                 // GeV
    double fBeamErms;                   // GeV
@@ -231,6 +249,7 @@ inline void CobremsGenerator::setBeamEmittance(double emit_m_r) {
 
 inline void CobremsGenerator::setBeamEnergy(double Ebeam_GeV) {
    fBeamEnergy = Ebeam_GeV;
+   fLatticeTermsValid = false;
 }
 
 inline void CobremsGenerator::setBeamErms(double Erms_GeV) {
@@ -278,6 +297,7 @@ inline void CobremsGenerator::setPolarizedFlag(bool flag) {
 }
 
 inline void CobremsGenerator::resetTargetOrientation() {
+   fLatticeTermsValid = false;
    fTargetRmatrix[0][0] = 1;
    fTargetRmatrix[0][1] = 0;
    fTargetRmatrix[0][2] = 0;
@@ -748,19 +748,7 @@ void GlueXPrimaryGeneratorAction::GenerateBeamPhoton(TVector3 &pgamma, TVector3
       while (true) {                             // try coherent generation
          double dNcdxPDF=0.0;
          double u = RAND.Rndm();
-         for (unsigned int i=1; i < fCoherentPDFx.randvar.size(); ++i) {
-            if (u <= fCoherentPDFx.integral[i]) {
-               double x0 = fCoherentPDFx.randvar[i - 1];
-               double x1 = fCoherentPDFx.randvar[i];
-               double f0 = fCoherentPDFx.density[i - 1];
-               double f1 = fCoherentPDFx.density[i];
-               double u0 = fCoherentPDFx.integral[i - 1];
-               double u1 = fCoherentPDFx.integral[i];
-               x = (x0 * (u1 - u) + x1 * (u - u0)) / (u1 - u0);
-               dNcdxPDF = (f0 * (u1 - u) + f1 * (u - u0)) / (u1 - u0);
-               break;
-            }
-         }
+         fCoherentPDFx.sample(u, x, dNcdxPDF);
          double dNcdx = twopi * fCobremsGenerator->Rate_dNcdxdp(x, pi / 4);
          double Pfactor = dNcdx / dNcdxPDF;
          if (Pfactor > fCoherentPDFx.Pmax)
@@ -785,12 +773,11 @@ void GlueXPrimaryGeneratorAction::GenerateBeamPhoton(TVector3 &pgamma, TVector3
                break;
          }
          double uq = RAND.Rndm();
-         for (unsigned int i=0; i < fCobremsGenerator->fQ2theta2.size(); ++i) {
-            if (uq <= fCobremsGenerator->fQ2weight[i]) {
-               theta2 = fCobremsGenerator->fQ2theta2[i];
-               break;
-            }
-         }
+         std::vector<double> &Q2weight = fCobremsGenerator->fQ2weight;
+         std::vector<double>::iterator iq =
+                        std::lower_bound(Q2weight.begin(), Q2weight.end(), uq);
+         if (iq != Q2weight.end())
+            theta2 = fCobremsGenerator->fQ2theta2[iq - Q2weight.begin()];
          polarization = fCobremsGenerator->Polarization(x, theta2);
 		 break;
       }
@@ -800,35 +787,14 @@ void GlueXPrimaryGeneratorAction::GenerateBeamPhoton(TVector3 &pgamma, TVector3
       while (true) {                           // try incoherent generation
          double dNidxdyPDF;
          double u = RAND.Rndm();
-         for (unsigned int i=1; i < fIncoherentPDFlogx.randvar.size(); ++i) {
-            if (u <= fIncoherentPDFlogx.integral[i]) {
-               double logx0 = fIncoherentPDFlogx.randvar[i - 1];
-               double logx1 = fIncoherentPDFlogx.randvar[i];
-               double f0 = fIncoherentPDFlogx.density[i - 1];
-               double f1 = fIncoherentPDFlogx.density[i];
-               double u0 = fIncoherentPDFlogx.integral[i - 1];
-               double u1 = fIncoherentPDFlogx.integral[i];
-               double logx = (logx0 * (u1 - u) + logx1 * (u - u0)) / (u1 - u0);
-               dNidxdyPDF = (f0 * (u1 - u) + f1 * (u - u0)) / (u1 - u0);
-               x = exp(logx);
-               break;
-            }
-         }
+         double logx;
+         if (fIncoherentPDFlogx.sample(u, logx, dNidxdyPDF))
+            x = exp(logx);
          double y=0.0;
          double uy = RAND.Rndm();
-         for (unsigned int i=1; i < fIncoherentPDFy.randvar.size(); ++i) {
-            if (uy <= fIncoherentPDFy.integral[i]) {
-               double y0 = fIncoherentPDFy.randvar[i - 1];
-               double y1 = fIncoherentPDFy.randvar[i];
-               double f0 = fIncoherentPDFy.density[i - 1];
-               double f1 = fIncoherentPDFy.density[i];
-               double u0 = fIncoherentPDFy.integral[i - 1];
-               double u1 = fIncoherentPDFy.integral[i];
-               y = (y0 * (u1 - uy) + y1 * (uy - u0)) / (u1 - u0);
-               dNidxdyPDF *= (f0 * (u1 - uy) + f1 * (uy - u0)) / (u1 - u0);
-               break;
-            }
-         }
+         double dNidyPDF;
+         if (fIncoherentPDFy.sample(uy, y, dNidyPDF))
+            dNidxdyPDF *= dNidyPDF;
          theta2 = fIncoherentPDFtheta02 * (1 / (y + 1e-99) - 1);
          double dNidxdy = fCobremsGenerator->Rate_dNidxdt2(x, theta2) *
                           fIncoherentPDFtheta02 / (y*y + 1e-99);
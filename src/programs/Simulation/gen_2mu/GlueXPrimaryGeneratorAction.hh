@@ -44,6 +44,9 @@
 
 #include <TVector3.h>
 
+#include <vector>
+#include <algorithm>
+
 //class GlueXPrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 class GlueXPrimaryGeneratorAction
 {
@@ -177,6 +180,27 @@ class GlueXPrimaryGeneratorAction
       ImportanceSampler()
        : Psum(1.0), Pcut(1), Pmax(0), Nfailed(0), Npassed(1) {}
 //       : Psum(0), Pcut(1), Pmax(0), Nfailed(0), Npassed(0) {}
+
+      // Map a uniform deviate u onto randvar, interpolating linearly
+      // within the bin of the cumulative integral that contains u, which
+      // is found by bisection. The density interpolated at that point is
+      // returned in pdf. Returns false, leaving var and pdf unchanged,
+      // if u lies beyond the end of the table or the table has fewer
+      // than two entries.
+      bool sample(double u, double &var, double &pdf) const {
+         if (integral.size() < 2)
+            return false;
+         std::vector<double>::const_iterator iter =
+            std::lower_bound(integral.begin() + 1, integral.end(), u);
+         if (iter == integral.end())
+            return false;
+         unsigned int i = iter - integral.begin();
+         double u0 = integral[i - 1];
+         double u1 = integral[i];
+         var = (randvar[i - 1] * (u1 - u) + randvar[i] * (u - u0)) / (u1 - u0);
+         pdf = (density[i - 1] * (u1 - u) + density[i] * (u - u0)) / (u1 - u0);
+         return true;
+      }
    };
 
    static ImportanceSampler fCoherentPDFx; 
@@ -6,9 +6,13 @@
 #include <vector>
 #include <utility>
 #include <map>
+#include <algorithm>
+#include <cmath>
 #include <cassert>
 #include <cstdlib>
 
+#include <pthread.h>
+
 #include "particleType.h"
 
 #include "AMPTOOLS_DATAIO/ROOTDataWriter.h"
@@ -34,6 +38,7 @@
 #include "AMPTOOLS_MCGEN/ProductionMechanism.h"
 #include "AMPTOOLS_MCGEN/GammaPToNPartP.h"
 #include "AMPTOOLS_MCGEN/NBodyPhaseSpaceFactory.h"
+#include "AMPTOOLS_MCGEN/GeneratorRandom.h"
 
 #include "IUAmpTools/AmpToolsInterface.h"
 #include "IUAmpTools/ConfigFileParser.h"
@@ -50,6 +55,277 @@
 using std::complex;
 using namespace std;
 
+// Events are generated in batches.  The four-vectors of a batch are generated,
+// their intensities computed and the accept/reject decisions made on a worker
+// thread, with a random number stream seeded for that batch, and the batches
+// are then written out in order by the main thread.  The output therefore
+// depends on the seed only, not on the number of threads.
+//
+// All batches are accepted against a single intensity envelope.  It is
+// estimated before generation from the maxima of a few independent batches,
+// extrapolated with a Gumbel (extreme-value) distribution to the number of
+// batches the run is expected to need.  Should a batch still contain an
+// intensity above the envelope, the envelope is raised and generation starts
+// over from the first batch, which is regenerated from the same seed, so
+// that no event is ever accepted with a probability that is too large.
+
+struct GenBatch {
+
+	int index;
+	int epoch;                      // envelope the batch was generated with
+	unsigned int seed;
+	double maxIntensity;
+	vector< Kinematics* > events;   // accepted events (all events in diagnostic mode)
+	vector< double > intensities;
+};
+
+struct GenShared {
+
+	// generation settings, read only once the workers have started
+	int batchSize;
+	bool genFlat;
+	bool diag;
+	string reactionName;
+	vector< double > childMasses;
+	vector< double > massesLowerVertex;
+	double thresholdLowerVertex;
+	int nThreads;
+
+	// pre-scan of the intensity, one entry per scan batch
+	vector< unsigned int > scanSeeds;
+	vector< double > scanMax;
+	vector< double > scanSum;
+
+	// batch bookkeeping, guarded by mutex
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	TRandom3* seedRandom;           // draws the seed of each batch in turn
+	vector< unsigned int > seeds;   // seed of each batch index drawn so far
+	int nextScan;
+	int nextBatch;
+	int nWritten;
+	int epoch;
+	double envelope;
+	bool done;
+	map< int, GenBatch* > finished;
+};
+
+struct GenWorker {
+
+	GenShared* shared;
+	AmpToolsInterface* ati;
+	GammaPToNPartP resProd;
+	vector< BreitWignerGenerator > bwGenLowerVertex;
+};
+
+static void deleteBatch( GenBatch* batch ){
+
+	for( unsigned int i = 0; i < batch->events.size(); ++i )
+		delete batch->events[i];
+	delete batch;
+}
+
+// generate a batch of events from the thread's random number stream and
+// load them into the worker's AmpToolsInterface
+static void loadBatch( GenWorker* worker ){
+
+	GenShared* gen = worker->shared;
+	AmpToolsInterface* ati = worker->ati;
+	int batchSize = gen->batchSize;
+
+	ati->clearEvents();
+	int i=0;
+	while( i < batchSize ){
+
+		Kinematics* kin;
+		if(worker->bwGenLowerVertex.size() == 0) 
+			kin = worker->resProd.generate(); // stable particle at lower vertex
+		else { 
+			// unstable particle at lower vertex
+			pair< double, double > bwLowerVertex = worker->bwGenLowerVertex[0]();
+			double lowerVertex_mass_bw = bwLowerVertex.first;
+			if ( lowerVertex_mass_bw < gen->thresholdLowerVertex || lowerVertex_mass_bw > 2.0) continue;
+			worker->resProd.getProductionMechanism().setRecoilMass( lowerVertex_mass_bw );
+			
+			Kinematics* step1 = worker->resProd.generate();
+			TLorentzVector beam = step1->particle( 0 );
+			TLorentzVector recoil = step1->particle( 1 );
+			
+			// loop over meson decay
+			vector<TLorentzVector> mesonChild;
+			for(unsigned int i=0; i<gen->childMasses.size(); i++) 
+				mesonChild.push_back(step1->particle( 2+i ));
+			
+			// decay step for lower vertex
+			TLorentzVector nucleon; // proton or neutron
+			NBodyPhaseSpaceFactory lowerVertex_decay = NBodyPhaseSpaceFactory( lowerVertex_mass_bw, gen->massesLowerVertex);
+			vector<TLorentzVector> lowerVertexChild = lowerVertex_decay.generateDecay();
+			// boost to lab frame via recoil kinematics
+			for(unsigned int j=0; j<lowerVertexChild.size(); j++) 
+			  lowerVertexChild[j].Boost( recoil.BoostVector() );
+			nucleon = lowerVertexChild[0];
+
+			// store particles in kinematic class
+			vector< TLorentzVector > allPart;
+			allPart.push_back( beam );
+			allPart.push_back( nucleon );
+			// loop over meson decay particles
+			for(unsigned int j=0; j<mesonChild.size(); j++) 
+				allPart.push_back(mesonChild[j]);
+			// loop over lower vertex decay particles
+			for(unsigned int j=1; j<lowerVertexChild.size(); j++) 
+				allPart.push_back(lowerVertexChild[j]);
+			
+			kin = new Kinematics( allPart, 1.0 );
+			delete step1;				
+		}
+		
+		ati->loadEvent( kin, i, batchSize );
+		delete kin;
+		i++;
+	}
+}
+
+static void generateBatch( GenWorker* worker, GenBatch* batch, double envelope ){
+
+	GenShared* gen = worker->shared;
+	AmpToolsInterface* ati = worker->ati;
+
+	TRandom3 batchRandom( batch->seed );
+	setThreadRandom( &batchRandom );
+
+	loadBatch( worker );
+	
+	// avoid intensity calculation if we are generating flat data
+	batch->maxIntensity = ( gen->genFlat ? 1 : ati->processEvents( gen->reactionName ) );
+	
+	for( int i = 0; i < gen->batchSize; ++i ){
+		
+		// cannot ask for the intensity if we haven't called process events above
+		double weightedInten = ( gen->genFlat ? 1 : ati->intensity( i ) ); 
+
+		bool keep = gen->diag;
+		if( !gen->diag ){
+			
+			double rand = batchRandom.Uniform() * envelope;
+			keep = ( weightedInten > rand || gen->genFlat );
+		}
+
+		if( keep ){
+
+			batch->events.push_back( ati->kinematics( i ) );
+			batch->intensities.push_back( weightedInten );
+		}
+	}
+
+	setThreadRandom( NULL );
+}
+
+static void* scanWorkerThread( void* arg ){
+
+	GenWorker* worker = (GenWorker*)arg;
+	GenShared* gen = worker->shared;
+
+	while( true ){
+
+		pthread_mutex_lock( &gen->mutex );
+		int scan = gen->nextScan++;
+		pthread_mutex_unlock( &gen->mutex );
+		if( scan >= (int)gen->scanSeeds.size() )
+			break;
+
+		TRandom3 scanRandom( gen->scanSeeds[scan] );
+		setThreadRandom( &scanRandom );
+		loadBatch( worker );
+		gen->scanMax[scan] = worker->ati->processEvents( gen->reactionName );
+		double sum = 0;
+		for( int i = 0; i < gen->batchSize; ++i )
+			sum += worker->ati->intensity( i );
+		gen->scanSum[scan] = sum;
+		setThreadRandom( NULL );
+	}
+
+	return NULL;
+}
+
+static void* genWorkerThread( void* arg ){
+
+	GenWorker* worker = (GenWorker*)arg;
+	GenShared* gen = worker->shared;
+
+	while( true ){
+
+		pthread_mutex_lock( &gen->mutex );
+		// stay at most two batches per thread ahead of the writer
+		while( !gen->done && gen->nextBatch >= gen->nWritten + 2 * gen->nThreads )
+			pthread_cond_wait( &gen->cond, &gen->mutex );
+		if( gen->done ){
+
+			pthread_mutex_unlock( &gen->mutex );
+			break;
+		}
+		GenBatch* batch = new GenBatch;
+		batch->index = gen->nextBatch++;
+		batch->epoch = gen->epoch;
+		// batches are regenerated from their original seed after a restart
+		if( batch->index == (int)gen->seeds.size() )
+			gen->seeds.push_back( 1 + gen->seedRandom->Integer( kMaxUInt - 1 ) );
+		batch->seed = gen->seeds[batch->index];
+		double envelope = gen->envelope;
+		pthread_mutex_unlock( &gen->mutex );
+
+		generateBatch( worker, batch, envelope );
+
+		pthread_mutex_lock( &gen->mutex );
+		// drop batches generated with an envelope that has since been raised
+		if( batch->epoch == gen->epoch )
+			gen->finished[batch->index] = batch;
+		else
+			deleteBatch( batch );
+		pthread_cond_broadcast( &gen->cond );
+		pthread_mutex_unlock( &gen->mutex );
+	}
+
+	return NULL;
+}
+
+// Estimate the intensity envelope from the maxima of batches of events.  The
+// maxima are fit by moments to a Gumbel distribution, and the envelope is put
+// where the chance that any of the batches needed for nEvents accepted events
+// has a larger maximum is about one percent.  It is never below the largest
+// maximum seen.
+static double estimateEnvelope( const vector< double >& maxima, double meanIntensity,
+				int nEvents, int batchSize ){
+
+	double largest = 0, sum = 0, sum2 = 0;
+	for( unsigned int i = 0; i < maxima.size(); ++i ){
+
+		if( maxima[i] > largest ) largest = maxima[i];
+		sum += maxima[i];
+		sum2 += maxima[i] * maxima[i];
+	}
+	int n = maxima.size();
+	if( n < 2 || meanIntensity <= 0 ) return largest;
+
+	double mean = sum / n;
+	double var = ( sum2 - n * mean * mean ) / ( n - 1 );
+	double beta = ( var > 0 ? sqrt( 6 * var ) / PI : 0 );
+	double mu = mean - 0.5772156649 * beta;
+
+	// the number of batches needed depends on the envelope itself, so
+	// iterate starting from the largest maximum seen
+	double envelope = largest;
+	for( int iter = 0; iter < 3; ++iter ){
+
+		double nBatches = nEvents / ( batchSize * meanIntensity / envelope ) + 1;
+		double p = 0.01 / nBatches;
+		double quantile = mu - beta * log( -log( 1 - p ) );
+		envelope = ( quantile > largest ? quantile : largest );
+	}
+
+	return envelope;
+}
+
 int main( int argc, char* argv[] ){
   
 	string  configfile("");
@@ -78,6 +354,8 @@ int main( int argc, char* argv[] ){
 
 	int nEvents = 10000;
 	int batchSize = 10000;
+	int nThreads = 1;
+	int nScan = 10;
 	
 	//parse command line:
 	for (int i = 1; i < argc; i++){
@@ -129,6 +407,12 @@ int main( int argc, char* argv[] ){
 		if (arg == "-tmax"){
                         if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
                         else  highT = atof( argv[++i] ); }
+		if (arg == "-j"){
+			if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+			else  nThreads = atoi( argv[++i] ); }
+		if (arg == "-scan"){
+			if ((i+1 == argc) || (argv[i+1][0] == '-')) arg = "-h";
+			else  nScan = atoi( argv[++i] ); }
 		if (arg == "-d"){
 			diag = true; }
 		if (arg == "-v"){
@@ -152,6 +436,8 @@ int main( int argc, char* argv[] ){
 			cout << "\t -t    <value>\t Momentum transfer slope [optional]" << endl;
 			cout << "\t -tmin <value>\t Minimum momentum transfer [optional]" << endl;
 			cout << "\t -tmax <value>\t Maximum momentum transfer [optional]" << endl;
+			cout << "\t -j    <value>\t Number of generation threads [optional]" << endl;
+			cout << "\t -scan <value>\t Number of batches used to estimate the maximum intensity [optional]" << endl;
 			cout << "\t -v \t\t Throw vertex distribution in gen_amp, not in hdgeant(4) [not recommended]" << endl;
 			cout << "\t -f \t\t Generate flat in M(X) (no physics) [optional]" << endl;
 			cout << "\t -d \t\t Plot only diagnostic histograms [optional]" << endl << endl;
@@ -285,7 +571,10 @@ int main( int argc, char* argv[] ){
 	AmpToolsInterface::registerAmplitude( Zlm() );
 	AmpToolsInterface::registerAmplitude( dblRegge() );
 	AmpToolsInterface::registerAmplitude( dblReggeMod() );
-	AmpToolsInterface ati( cfgInfo, AmpToolsInterface::kMCGeneration );
+	if( nThreads < 1 ) nThreads = 1;
+	vector< AmpToolsInterface* > atis;
+	for( int i = 0; i < nThreads; ++i )
+		atis.push_back( new AmpToolsInterface( cfgInfo, AmpToolsInterface::kMCGeneration ) );
 
 	// loop to look for beam configuration file
         TString beamConfigFile;
@@ -360,7 +649,7 @@ int main( int argc, char* argv[] ){
 
 	HDDMDataWriter* hddmOut = NULL;
 	if( hddmname.size() != 0 ) hddmOut = new HDDMDataWriter( hddmname, runNum, seed);
-	ROOTDataWriter rootOut( outname );
+	ROOTDataWriter* rootOut = new ROOTDataWriter( outname );
 	
 	TFile* diagOut = new TFile( "gen_amp_diagnostic.root", "recreate" );
 	ostringstream locStream;
@@ -392,79 +681,171 @@ int main( int argc, char* argv[] ){
 	TH2F* M_Phi = new TH2F( "M_Phi", "M vs. #varphi", 180, lowMass, highMass, 200, -3.14, 3.14);
 	TH2F* M_Phi_lab = new TH2F( "M_Phi_lab", "M vs. #varphi", 180, lowMass, highMass, 200, -3.14, 3.14);
 	
+	// start the workers, each with its own copy of the generators and
+	// its own AmpToolsInterface
+	GenShared gen;
+	gen.batchSize = batchSize;
+	gen.genFlat = genFlat;
+	gen.diag = diag;
+	gen.reactionName = reaction->reactionName();
+	gen.childMasses = childMasses;
+	gen.massesLowerVertex = massesLowerVertex;
+	gen.thresholdLowerVertex = thresholdLowerVertex;
+	gen.nThreads = nThreads;
+	pthread_mutex_init( &gen.mutex, NULL );
+	pthread_cond_init( &gen.cond, NULL );
+	gen.seedRandom = gRandom;
+	gen.nextScan = 0;
+	gen.nextBatch = 0;
+	gen.nWritten = 0;
+	gen.epoch = 0;
+	gen.envelope = 1;
+	gen.done = false;
+
+	vector< GenWorker > workers( nThreads );
+	vector< pthread_t > threads( nThreads );
+	for( int i = 0; i < nThreads; ++i ){
+
+		workers[i].shared = &gen;
+		workers[i].ati = atis[i];
+		workers[i].resProd = resProd;
+		workers[i].bwGenLowerVertex = bwGenLowerVertex;
+	}
+
+	// estimate the intensity envelope from independent batches -- not
+	// needed for flat or diagnostic generation, which accept everything
+	vector< double > batchMaxima;
+	double meanIntensity = 0;
+	if( !genFlat && !diag && nScan > 0 ){
+
+		for( int i = 0; i < nScan; ++i )
+			gen.scanSeeds.push_back( 1 + gRandom->Integer( kMaxUInt - 1 ) );
+		gen.scanMax.resize( nScan );
+		gen.scanSum.resize( nScan );
+
+		int nScanThreads = ( nThreads < nScan ? nThreads : nScan );
+		for( int i = 0; i < nScanThreads; ++i ){
+
+			if( pthread_create( &threads[i], NULL, scanWorkerThread, &workers[i] ) != 0 ){
+
+				cout << "ERROR:  unable to start generation thread" << endl;
+				exit(1);
+			}
+		}
+		for( int i = 0; i < nScanThreads; ++i )
+			pthread_join( threads[i], NULL );
+
+		for( int i = 0; i < nScan; ++i ){
+
+			batchMaxima.push_back( gen.scanMax[i] );
+			meanIntensity += gen.scanSum[i];
+		}
+		meanIntensity /= (double)nScan * batchSize;
+		gen.envelope = estimateEnvelope( batchMaxima, meanIntensity, nEvents, batchSize );
+
+		cout << "Maximum intensity estimated from " << nScan * batchSize << " events : "
+		     << gen.envelope << " (expected efficiency " << meanIntensity / gen.envelope << ")" << endl;
+	}
+	// without a pre-scan the first batch sets the envelope
+	bool haveEnvelope = ( genFlat || diag || nScan > 0 );
+
+	for( int i = 0; i < nThreads; ++i ){
+
+		if( pthread_create( &threads[i], NULL, genWorkerThread, &workers[i] ) != 0 ){
+
+			cout << "ERROR:  unable to start generation thread" << endl;
+			exit(1);
+		}
+	}
+	
 	int eventCounter = 0;
+	int batchIndex = 0;
+	long long nGenerated = 0;
+	int nRestarts = 0;
+	int nRecorded = 0;   // batches whose maximum intensity is in batchMaxima
 	while( eventCounter < nEvents ){
 		
-		if( batchSize < 1E4 ){
-			
-			cout << "WARNING:  small batches could have batch-to-batch variations\n"
-			     << "          due to different maximum intensities!" << endl;
-		}
-		
-		cout << "Generating four-vectors..." << endl;
-		
-		ati.clearEvents();
-		int i=0;
-                while( i < batchSize ){
-
-			Kinematics* kin;
-			if(bwGenLowerVertex.size() == 0) 
-				kin = resProd.generate(); // stable particle at lower vertex
-			else { 
-				// unstable particle at lower vertex
-				pair< double, double > bwLowerVertex = bwGenLowerVertex[0]();
-				double lowerVertex_mass_bw = bwLowerVertex.first;
-				if ( lowerVertex_mass_bw < thresholdLowerVertex || lowerVertex_mass_bw > 2.0) continue;
-				resProd.getProductionMechanism().setRecoilMass( lowerVertex_mass_bw );
-				
-				Kinematics* step1 = resProd.generate();
-				TLorentzVector beam = step1->particle( 0 );
-				TLorentzVector recoil = step1->particle( 1 );
-				
-				// loop over meson decay
-				vector<TLorentzVector> mesonChild;
-				for(unsigned int i=0; i<childMasses.size(); i++) 
-					mesonChild.push_back(step1->particle( 2+i ));
-				
-				// decay step for lower vertex
-				TLorentzVector nucleon; // proton or neutron
-				NBodyPhaseSpaceFactory lowerVertex_decay = NBodyPhaseSpaceFactory( lowerVertex_mass_bw, massesLowerVertex);
-				vector<TLorentzVector> lowerVertexChild = lowerVertex_decay.generateDecay();
-				// boost to lab frame via recoil kinematics
-				for(unsigned int j=0; j<lowerVertexChild.size(); j++) 
-				  lowerVertexChild[j].Boost( recoil.BoostVector() );
-				nucleon = lowerVertexChild[0];
-
-				// store particles in kinematic class
-				vector< TLorentzVector > allPart;
-				allPart.push_back( beam );
-				allPart.push_back( nucleon );
-				// loop over meson decay particles
-				for(unsigned int j=0; j<mesonChild.size(); j++) 
-					allPart.push_back(mesonChild[j]);
-				// loop over lower vertex decay particles
-				for(unsigned int j=1; j<lowerVertexChild.size(); j++) 
-					allPart.push_back(lowerVertexChild[j]);
-				
-				kin = new Kinematics( allPart, 1.0 );
-				delete step1;				
+		pthread_mutex_lock( &gen.mutex );
+		while( gen.finished.count( batchIndex ) == 0 )
+			pthread_cond_wait( &gen.cond, &gen.mutex );
+		GenBatch* batch = gen.finished[batchIndex];
+		gen.finished.erase( batchIndex );
+		pthread_mutex_unlock( &gen.mutex );
+
+		if( !genFlat && !diag && ( batch->maxIntensity > gen.envelope || !haveEnvelope ) ){
+
+			// some events of this batch were accepted with a probability that
+			// was too large:  raise the envelope and start over
+			if( batchIndex == nRecorded ){
+
+				batchMaxima.push_back( batch->maxIntensity );
+				++nRecorded;
 			}
-			
-			ati.loadEvent( kin, i, batchSize );
-			delete kin;
-			i++;
+			double envelope = estimateEnvelope( batchMaxima, meanIntensity, nEvents, batchSize );
+			if( envelope < 1.1 * batch->maxIntensity ) envelope = 1.1 * batch->maxIntensity;
+
+			if( haveEnvelope ){
+
+				cout << "WARNING:  intensity " << batch->maxIntensity << " exceeds the maximum "
+				     << gen.envelope << " -- restarting with maximum " << envelope << endl;
+				++nRestarts;
+			}
+			haveEnvelope = true;
+			deleteBatch( batch );
+
+			pthread_mutex_lock( &gen.mutex );
+			gen.envelope = envelope;
+			++gen.epoch;
+			gen.nextBatch = 0;
+			gen.nWritten = 0;
+			for( map< int, GenBatch* >::iterator it = gen.finished.begin(); it != gen.finished.end(); ++it )
+				deleteBatch( it->second );
+			gen.finished.clear();
+			pthread_cond_broadcast( &gen.cond );
+			pthread_mutex_unlock( &gen.mutex );
+
+			// discard everything written so far
+			if( eventCounter > 0 ){
+
+				delete rootOut;
+				rootOut = new ROOTDataWriter( outname );
+				if( hddmOut ){
+
+					delete hddmOut;
+					hddmOut = new HDDMDataWriter( hddmname, runNum, seed );
+				}
+				diagOut->cd();
+
+				mass->Reset();
+				massW->Reset();
+				intenW->Reset();
+				intenWVsM->Reset();
+				M_isobar->Reset();
+				M_recoil->Reset();
+				t->Reset();
+				E->Reset();
+				EvsM->Reset();
+				CosTheta_psi->Reset();
+				M_CosTheta->Reset();
+				M_Phi->Reset();
+				M_Phi_lab->Reset();
+			}
+			eventCounter = 0;
+			batchIndex = 0;
+			nGenerated = 0;
+			continue;
 		}
+		// batches written again after a restart are already recorded
+		if( !genFlat && !diag && batchIndex == nRecorded ){
+
+			batchMaxima.push_back( batch->maxIntensity );
+			++nRecorded;
+		}
+		nGenerated += batchSize;
 		
-		cout << "Processing events..." << endl;
-		
-		// include factor of 1.5 to be safe in case we miss peak -- avoid
-		// intensity calculation of we are generating flat data
-		double maxInten = ( genFlat ? 1 : 1.5 * ati.processEvents( reaction->reactionName() ) );
-		
-		
-		for( int i = 0; i < batchSize; ++i ){
+		for( unsigned int k = 0; k < batch->events.size(); ++k ){
 			
-			Kinematics* evt = ati.kinematics( i );
+			Kinematics* evt = batch->events[k];
 			TLorentzVector resonance;
 			for (unsigned int j=2; j<Particles.size(); j++)
 			  resonance += evt->particle( j );
@@ -480,81 +861,72 @@ int main( int argc, char* argv[] ){
 			}
 
 			double genWeight = evt->weight();
-			
-			// cannot ask for the intensity if we haven't called process events above
-			double weightedInten = ( genFlat ? 1 : ati.intensity( i ) ); 
-			// cout << " i=" << i << "  intensity_i=" << weightedInten << endl;
+			double weightedInten = batch->intensities[k];
 
 			if( !diag ){
+
+				mass->Fill( resonance.M() );
+				massW->Fill( resonance.M(), genWeight );
 				
-				// obtain this by looking at the maximum value of intensity * genWeight
-				double rand = gRandom->Uniform() * maxInten;
+				intenW->Fill( weightedInten );
+				intenWVsM->Fill( resonance.M(), weightedInten );
+
+				M_isobar->Fill( isobar.M() );
+				M_recoil->Fill( recoil.M() );
 				
-				if( weightedInten > rand || genFlat ){
-
-					mass->Fill( resonance.M() );
-					massW->Fill( resonance.M(), genWeight );
-					
-					intenW->Fill( weightedInten );
-					intenWVsM->Fill( resonance.M(), weightedInten );
-
-					M_isobar->Fill( isobar.M() );
-					M_recoil->Fill( recoil.M() );
-					
-					// calculate angular variables
-					TLorentzVector beam = evt->particle ( 0 );
-					TLorentzVector rec = evt->particle ( 1 );
-					TLorentzVector p1 = evt->particle ( 2 );
-					TLorentzVector target(0,0,0,rec[3]);
-					
-					if(isBaryonResonance) // assume t-channel
-						t->Fill(-1*(beam-evt->particle(1)).M2());
-					else
-						t->Fill(-1*(recoil-target).M2());
-
-					E->Fill(beam.E());
-					EvsM->Fill(beam.E(),resonance.M());
-
-					TLorentzRotation resonanceBoost( -resonance.BoostVector() );
-					
-					TLorentzVector beam_res = resonanceBoost * beam;
-					TLorentzVector rec_res = resonanceBoost * rec;
-					TLorentzVector p1_res = resonanceBoost * p1;
-					
-					// normal to the production plane
-                                        TVector3 y = (beam.Vect().Unit().Cross(-rec.Vect().Unit())).Unit();
-
-                                        // choose helicity frame: z-axis opposite recoil proton in rho rest frame
-                                        TVector3 z = -1. * rec_res.Vect().Unit();
-                                        TVector3 x = y.Cross(z).Unit();
-                                        TVector3 angles( (p1_res.Vect()).Dot(x),
-                                                         (p1_res.Vect()).Dot(y),
-                                                         (p1_res.Vect()).Dot(z) );
-
-                                        double cosTheta = angles.CosTheta();
-                                        double phi = angles.Phi();
-
-					M_CosTheta->Fill( resonance.M(), cosTheta);
-					M_Phi->Fill( resonance.M(), phi);
-					M_Phi_lab->Fill( resonance.M(), rec.Phi());
-					
-					TVector3 eps(1.0, 0.0, 0.0); // beam polarization vector
-                                        double Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
-
-                                        GDouble psi = phi - Phi;
-                                        if(psi < -1*PI) psi += 2*PI;
-                                        if(psi > PI) psi -= 2*PI;
-					
-					CosTheta_psi->Fill( psi, cosTheta);
-					
-					// we want to save events with weight 1
-					evt->setWeight( 1.0 );
-					
-					if( hddmOut ) hddmOut->writeEvent( *evt, pTypes, centeredVertex );
-					rootOut.writeEvent( *evt );
-					++eventCounter;
-					if(eventCounter >= nEvents) break;
-				}
+				// calculate angular variables
+				TLorentzVector beam = evt->particle ( 0 );
+				TLorentzVector rec = evt->particle ( 1 );
+				TLorentzVector p1 = evt->particle ( 2 );
+				TLorentzVector target(0,0,0,rec[3]);
+				
+				if(isBaryonResonance) // assume t-channel
+					t->Fill(-1*(beam-evt->particle(1)).M2());
+				else
+					t->Fill(-1*(recoil-target).M2());
+
+				E->Fill(beam.E());
+				EvsM->Fill(beam.E(),resonance.M());
+
+				TLorentzRotation resonanceBoost( -resonance.BoostVector() );
+				
+				TLorentzVector beam_res = resonanceBoost * beam;
+				TLorentzVector rec_res = resonanceBoost * rec;
+				TLorentzVector p1_res = resonanceBoost * p1;
+				
+				// normal to the production plane
+                                TVector3 y = (beam.Vect().Unit().Cross(-rec.Vect().Unit())).Unit();
+
+                                // choose helicity frame: z-axis opposite recoil proton in rho rest frame
+                                TVector3 z = -1. * rec_res.Vect().Unit();
+                                TVector3 x = y.Cross(z).Unit();
+                                TVector3 angles( (p1_res.Vect()).Dot(x),
+                                                 (p1_res.Vect()).Dot(y),
+                                                 (p1_res.Vect()).Dot(z) );
+
+                                double cosTheta = angles.CosTheta();
+                                double phi = angles.Phi();
+
+				M_CosTheta->Fill( resonance.M(), cosTheta);
+				M_Phi->Fill( resonance.M(), phi);
+				M_Phi_lab->Fill( resonance.M(), rec.Phi());
+				
+				TVector3 eps(1.0, 0.0, 0.0); // beam polarization vector
+                                double Phi = atan2(y.Dot(eps), beam.Vect().Unit().Dot(eps.Cross(y)));
+
+                                GDouble psi = phi - Phi;
+                                if(psi < -1*PI) psi += 2*PI;
+                                if(psi > PI) psi -= 2*PI;
+				
+				CosTheta_psi->Fill( psi, cosTheta);
+				
+				// we want to save events with weight 1
+				evt->setWeight( 1.0 );
+				
+				if( hddmOut ) hddmOut->writeEvent( *evt, pTypes, centeredVertex );
+				rootOut->writeEvent( *evt );
+				++eventCounter;
+				if(eventCounter >= nEvents) break;
 			}
 			else{
 				
@@ -567,11 +939,35 @@ int main( int argc, char* argv[] ){
 				
 				++eventCounter;
 			}
-			
-			delete evt;
 		}
+		deleteBatch( batch );
 		
 		cout << eventCounter << " events were processed." << endl;
+
+		pthread_mutex_lock( &gen.mutex );
+		gen.nWritten = ++batchIndex;
+		if( eventCounter >= nEvents ) gen.done = true;
+		pthread_cond_broadcast( &gen.cond );
+		pthread_mutex_unlock( &gen.mutex );
+	}
+
+	for( int i = 0; i < nThreads; ++i )
+		pthread_join( threads[i], NULL );
+	for( map< int, GenBatch* >::iterator it = gen.finished.begin(); it != gen.finished.end(); ++it )
+		deleteBatch( it->second );
+	pthread_cond_destroy( &gen.cond );
+	pthread_mutex_destroy( &gen.mutex );
+	for( int i = 0; i < nThreads; ++i )
+		delete atis[i];
+
+	if( !genFlat && !diag && batchMaxima.size() > 0 ){
+
+		cout << "Maximum intensity : " << gen.envelope << ", largest found : "
+		     << *max_element( batchMaxima.begin(), batchMaxima.end() ) << endl;
+		cout << "Accepted " << eventCounter << " of " << nGenerated << " generated events : efficiency "
+		     << ( nGenerated > 0 ? (double)eventCounter / nGenerated : 0 ) << endl;
+		if( nRestarts > 0 )
+			cout << "Generation was restarted " << nRestarts << " time(s) after the maximum intensity was exceeded" << endl;
 	}
 	
 	mass->Write();
@@ -591,6 +987,7 @@ int main( int argc, char* argv[] ){
 	diagOut->Close();
 	
 	if( hddmOut ) delete hddmOut;
+	delete rootOut;
 	
 	return 0;
 }
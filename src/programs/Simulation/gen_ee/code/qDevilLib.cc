@@ -52,59 +52,84 @@ void Complx::Show(void)
 }
 void Complx::Set(double rVal,double iVal){real = rVal;imag=iVal;};
 
+//////////////////////
+// Dirac matrices in the Dirac representation, shared by all elements
+const Complx QedElement::gamma0[4][4] = {
+  {Complx(1,0), Complx(0,0), Complx(0,0),  Complx(0,0)},
+  {Complx(0,0), Complx(1,0), Complx(0,0),  Complx(0,0)},
+  {Complx(0,0), Complx(0,0), Complx(-1,0), Complx(0,0)},
+  {Complx(0,0), Complx(0,0), Complx(0,0),  Complx(-1,0)}};
+const Complx QedElement::gammaX[4][4] = {
+  {Complx(0,0),  Complx(0,0),  Complx(0,0), Complx(1,0)},
+  {Complx(0,0),  Complx(0,0),  Complx(1,0), Complx(0,0)},
+  {Complx(0,0),  Complx(-1,0), Complx(0,0), Complx(0,0)},
+  {Complx(-1,0), Complx(0,0),  Complx(0,0), Complx(0,0)}};
+const Complx QedElement::gammaY[4][4] = {
+  {Complx(0,0),  Complx(0,0), Complx(0,0), Complx(0,-1)},
+  {Complx(0,0),  Complx(0,0), Complx(0,1), Complx(0,0)},
+  {Complx(0,0),  Complx(0,1), Complx(0,0), Complx(0,0)},
+  {Complx(0,-1), Complx(0,0), Complx(0,0), Complx(0,0)}};
+const Complx QedElement::gammaZ[4][4] = {
+  {Complx(0,0),  Complx(0,0), Complx(1,0), Complx(0,0)},
+  {Complx(0,0),  Complx(0,0), Complx(0,0), Complx(-1,0)},
+  {Complx(-1,0), Complx(0,0), Complx(0,0), Complx(0,0)},
+  {Complx(0,0),  Complx(1,0), Complx(0,0), Complx(0,0)}};
+const Complx QedElement::gamma5[4][4] = {
+  {Complx(0,0), Complx(0,0), Complx(1,0), Complx(0,0)},
+  {Complx(0,0), Complx(0,0), Complx(0,0), Complx(1,0)},
+  {Complx(1,0), Complx(0,0), Complx(0,0), Complx(0,0)},
+  {Complx(0,0), Complx(1,0), Complx(0,0), Complx(0,0)}};
+
 //////////////////////
 // define overloaded + (plus) operator
 QedElement QedElement::operator+ (const QedElement& q) const
 {
   QedElement result;
   //START SCALAR + SCALAR
-  if (this->QedType == "scalar" && q.QedType == "scalar") {
+  if (this->QedType == qedScalar && q.QedType == qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       result.scalar = (this->scalar + q.scalar);
-      result.QedType = "scalar";
+      result.QedType = qedScalar;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       result.scalar0 = (this->scalar0 + q.scalar);
       result.scalarX = (this->scalarX + q.scalar);
       result.scalarY = (this->scalarY + q.scalar);
       result.scalarZ = (this->scalarZ + q.scalar);
       result.scalar5 = (this->scalar5 + q.scalar);
-      result.QedType = "scalar";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
       result.scalar0 = (this->scalar + q.scalar0);
       result.scalarX = (this->scalar + q.scalarX);
       result.scalarY = (this->scalar + q.scalarY);
       result.scalarZ = (this->scalar + q.scalarZ);
       result.scalar5 = (this->scalar + q.scalar5);
-      result.QedType = "scalar";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       result.scalar0 = (this->scalar0 + q.scalar0);
       result.scalarX = (this->scalarX + q.scalarX);
       result.scalarY = (this->scalarY + q.scalarY);
       result.scalarZ = (this->scalarZ + q.scalarZ);
       result.scalar5 = (this->scalar5 + q.scalar5);
-      result.QedType = "scalar";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED SCALAR + SCALAR
   //START SCALAR + MATRIX
-  if (this->QedType == "scalar" && q.QedType == "matrix") {
+  if (this->QedType == qedScalar && q.QedType == qedMatrix) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -114,9 +139,9 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -134,11 +159,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -156,11 +180,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -178,15 +201,14 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED SCALAR + MATRIX
   //START MATRIX + SCALAR
-  if (this->QedType == "matrix" && q.QedType == "scalar") {
+  if (this->QedType == qedMatrix && q.QedType == qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -196,9 +218,9 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -216,11 +238,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -238,11 +259,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -260,23 +280,22 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED MATRIX + SCALAR
   //START !SCALAR + !SCALAR
-  if (this->QedType != "scalar" && q.QedType != "scalar") {
+  if (this->QedType != qedScalar && q.QedType != qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix[i][j] = (this->matrix[i][j] +  q.matrix[i][j]);
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix0[i][j] +  q.matrix[i][j]);
@@ -286,11 +305,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix5[i][j] +  q.matrix[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix[i][j] +  q.matrix0[i][j]);
@@ -300,11 +318,10 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix[i][j] +  q.matrix5[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix0[i][j] +  q.matrix0[i][j]);
@@ -314,9 +331,8 @@ QedElement QedElement::operator+ (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix5[i][j] +  q.matrix5[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }//FINISHED !SCALAR + !SCALAR
   return result;
@@ -328,53 +344,50 @@ QedElement QedElement::operator- (const QedElement& q) const
   QedElement result;
   //START SCALAR - SCALAR
   Complx Zero(0.0,0.0);
-  if (this->QedType == "scalar" && q.QedType == "scalar") {
+  if (this->QedType == qedScalar && q.QedType == qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       result.scalar = (this->scalar - q.scalar);
-      result.QedType = "scalar";
+      result.QedType = qedScalar;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       result.scalar0 = (this->scalar0 - q.scalar);
       result.scalarX = (this->scalarX - q.scalar);
       result.scalarY = (this->scalarY - q.scalar);
       result.scalarZ = (this->scalarZ - q.scalar);
       result.scalar5 = (this->scalar5 - q.scalar);
-      result.QedType = "scalar";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
       result.scalar0 = (this->scalar - q.scalar0);
       result.scalarX = (this->scalar - q.scalarX);
       result.scalarY = (this->scalar - q.scalarY);
       result.scalarZ = (this->scalar - q.scalarZ);
       result.scalar5 = (this->scalar - q.scalar5);
-      result.QedType = "scalar";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       result.scalar0 = (this->scalar0 - q.scalar0);
       result.scalarX = (this->scalarX - q.scalarX);
       result.scalarY = (this->scalarY - q.scalarY);
       result.scalarZ = (this->scalarZ - q.scalarZ);
       result.scalar5 = (this->scalar5 - q.scalar5);
-      result.QedType = "scalar";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedScalar;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED SCALAR - SCALAR
   //START SCALAR - MATRIX
-  if (this->QedType == "scalar" && q.QedType == "matrix") {
+  if (this->QedType == qedScalar && q.QedType == qedMatrix) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -384,9 +397,9 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -404,11 +417,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -426,11 +438,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -448,15 +459,14 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED SCALAR - MATRIX
   //START MATRIX - SCALAR
-  if (this->QedType == "matrix" && q.QedType == "scalar") {
+  if (this->QedType == qedMatrix && q.QedType == qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -466,9 +476,9 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -486,11 +496,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -508,11 +517,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  if (i != j) {
@@ -530,23 +538,22 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  }
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }  //FINISHED MATRIX - SCALAR
   //START !SCALAR - !SCALAR
-  if (this->QedType != "scalar" && q.QedType != "scalar") {
+  if (this->QedType != qedScalar && q.QedType != qedScalar) {
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix[i][j] = (this->matrix[i][j] -  q.matrix[i][j]);
 	}
       }
-      result.QedType = "matrix";
+      result.QedType = qedMatrix;
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
+    if (this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix0[i][j] -  q.matrix[i][j]);
@@ -556,11 +563,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix5[i][j] -  q.matrix[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
+    if (!this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix[i][j] -  q.matrix0[i][j]);
@@ -570,11 +576,10 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix[i][j] -  q.matrix5[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = q.lIndexName;
-      result.lIndexName = q.lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = q.lIndexed;
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->matrix0[i][j] -  q.matrix0[i][j]);
@@ -584,9 +589,8 @@ QedElement QedElement::operator- (const QedElement& q) const
 	  result.matrix5[i][j] = (this->matrix5[i][j] -  q.matrix5[i][j]);
 	}
       }
-      result.QedType = "matrix";
-      result.lIndexName = this->lIndexName;
-      result.lIndexName = this->lIndexPosition;
+      result.QedType = qedMatrix;
+      result.lIndexed = this->lIndexed;
     }
   }//FINISHED !SCALAR - !SCALAR
   return result;
@@ -599,14 +603,14 @@ QedElement QedElement::operator* (const QedElement& q) const
 {
   QedElement result;
   //START SCALAR * SCALAR
-  if (this->QedType == "scalar" && q.QedType == "scalar") {
+  if (this->QedType == qedScalar && q.QedType == qedScalar) {
     result.SetZeroNone();
-    result.QedType = "scalar";
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    result.QedType = qedScalar;
+    if (!this->lIndexed && !q.lIndexed){
       result.scalar = (this->scalar * q.scalar);
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       result.scalar0 = (this->scalar0 * q.scalar);
       result.scalarX = (this->scalarX * q.scalar);
@@ -614,8 +618,8 @@ QedElement QedElement::operator* (const QedElement& q) const
       result.scalarZ = (this->scalarZ * q.scalar);
       result.scalar5 = (this->scalar5 * q.scalar);
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
       result.scalar0 = (this->scalar * q.scalar0);
       result.scalarX = (this->scalar * q.scalarX);
@@ -623,7 +627,7 @@ QedElement QedElement::operator* (const QedElement& q) const
       result.scalarZ = (this->scalar * q.scalarZ);
       result.scalar5 = (this->scalar * q.scalar5);
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       result.scalar = (
 		       this->scalar0 * q.scalar0 -
 		       this->scalarX * q.scalarX -
@@ -632,18 +636,18 @@ QedElement QedElement::operator* (const QedElement& q) const
     }
   } //FINISHED SCALAR * SCALAR
   //START SCALAR * !SCALAR
-  if (this->QedType == "scalar" && q.QedType != "scalar") {
+  if (this->QedType == qedScalar && q.QedType != qedScalar) {
     result.SetZeroNone();
     result.QedType = q.QedType;
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix[i][j] = (this->scalar * q.matrix[i][j]);
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
@@ -655,8 +659,8 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
@@ -668,7 +672,7 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix0[i][j] = (this->scalar0 * q.matrix0[i][j] -    
@@ -680,18 +684,18 @@ QedElement QedElement::operator* (const QedElement& q) const
     }
   } //FINISHED SCALAR * !SCALAR
   //START !SCALAR * SCALAR
-  if (this->QedType != "scalar" && q.QedType == "scalar") {
+  if (this->QedType != qedScalar && q.QedType == qedScalar) {
     result.SetZeroNone();
     result.QedType = q.QedType;
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
+    if (!this->lIndexed && !q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix[i][j] = (this->matrix[i][j] * q.scalar);
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
@@ -703,8 +707,8 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
@@ -716,7 +720,7 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
+    if (this->lIndexed && q.lIndexed){
       for (int i=0; i<4; i++) {
 	for (int j=0; j<4; j++) {
 	  result.matrix[i][j] = (this->matrix0[i][j] * q.scalar0 -    
@@ -728,30 +732,35 @@ QedElement QedElement::operator* (const QedElement& q) const
     }
   } //FINISHED !SCALAR * SCALAR
   //START !SCALAR * !SCALAR
-  if (this->QedType != "scalar" && q.QedType != "scalar") {
+  if (this->QedType != qedScalar && q.QedType != qedScalar) {
     Complx zero(0.0,0.0);
     result.SetZeroNone();
-    if (this->lIndexName == "none" && q.lIndexName == "none"){
-      for (int i=0; i<4; i++) {
-	for (int j=0; j<4; j++) {
+    // a vectorT has only row 0 and a vector only column 0, the rest
+    // being zero, so only the entries that can be nonzero are summed
+    int nRows = (this->QedType == qedVectorT) ? 1 : 4;
+    int nCols = (q.QedType == qedVector) ? 1 : 4;
+    int nSum = (this->QedType == qedVector || q.QedType == qedVectorT) ? 1 : 4;
+    if (!this->lIndexed && !q.lIndexed){
+      for (int i=0; i<nRows; i++) {
+	for (int j=0; j<nCols; j++) {
 	  result.matrix[i][j] = zero;
-	  for (int k=0; k<4; k++) {
+	  for (int k=0; k<nSum; k++) {
 	    result.matrix[i][j] = result.matrix[i][j] + (this->matrix[i][k] * q.matrix[k][j]);
 	  }
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName == "none"){
-      result.lIndexName = this->lIndexName;
+    if (this->lIndexed && !q.lIndexed){
+      result.lIndexed = this->lIndexed;
       result.lIndexPosition = this->lIndexPosition;
-      for (int i=0; i<4; i++) {
-	for (int j=0; j<4; j++) {
+      for (int i=0; i<nRows; i++) {
+	for (int j=0; j<nCols; j++) {
 	  result.matrix0[i][j] = zero;
 	  result.matrixX[i][j] = zero;
 	  result.matrixY[i][j] = zero;
 	  result.matrixZ[i][j] = zero;
 	  result.matrix5[i][j] = zero;
-	  for (int k=0; k<4; k++) {
+	  for (int k=0; k<nSum; k++) {
 	    result.matrix0[i][j] = result.matrix0[i][j] + (this->matrix0[i][k] * q.matrix[k][j]);
 	    result.matrixX[i][j] = result.matrixX[i][j] + (this->matrixX[i][k] * q.matrix[k][j]);
 	    result.matrixY[i][j] = result.matrixY[i][j] + (this->matrixY[i][k] * q.matrix[k][j]);
@@ -761,17 +770,17 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName == "none" && q.lIndexName != "none"){
-      result.lIndexName = q.lIndexName;
+    if (!this->lIndexed && q.lIndexed){
+      result.lIndexed = q.lIndexed;
       result.lIndexPosition = q.lIndexPosition;
-      for (int i=0; i<4; i++) {
-	for (int j=0; j<4; j++) {
+      for (int i=0; i<nRows; i++) {
+	for (int j=0; j<nCols; j++) {
 	  result.matrix0[i][j] = zero;
 	  result.matrixX[i][j] = zero;
 	  result.matrixY[i][j] = zero;
 	  result.matrixZ[i][j] = zero;
 	  result.matrix5[i][j] = zero;
-	  for (int k=0; k<4; k++) {
+	  for (int k=0; k<nSum; k++) {
 	    result.matrix0[i][j] = result.matrix0[i][j] + (this->matrix[i][k] * q.matrix0[k][j]);
 	    result.matrixX[i][j] = result.matrixX[i][j] + (this->matrix[i][k] * q.matrixX[k][j]);
 	    result.matrixY[i][j] = result.matrixY[i][j] + (this->matrix[i][k] * q.matrixY[k][j]);
@@ -781,11 +790,11 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }
-    if (this->lIndexName != "none" && q.lIndexName != "none"){
-      for (int i=0; i<4; i++) {
-	for (int j=0; j<4; j++) {
+    if (this->lIndexed && q.lIndexed){
+      for (int i=0; i<nRows; i++) {
+	for (int j=0; j<nCols; j++) {
 	  result.matrix[i][j] = zero;
-	  for (int k=0; k<4; k++) {
+	  for (int k=0; k<nSum; k++) {
 	    result.matrix[i][j] = result.matrix[i][j] + (this->matrix0[i][k] * q.matrix0[k][j] -
 				   this->matrixX[i][k] * q.matrixX[k][j] -
 				   this->matrixY[i][k] * q.matrixY[k][j] -
@@ -794,26 +803,26 @@ QedElement QedElement::operator* (const QedElement& q) const
 	}
       }
     }    
-    if (this->QedType == "matrix" && q.QedType == "matrix") {
-      result.QedType = "matrix";
+    if (this->QedType == qedMatrix && q.QedType == qedMatrix) {
+      result.QedType = qedMatrix;
     }
-    if (this->QedType == "matrix" && q.QedType == "vector") {
-      result.QedType = "vector";
+    if (this->QedType == qedMatrix && q.QedType == qedVector) {
+      result.QedType = qedVector;
     }
-    if (this->QedType == "matrix" && q.QedType == "vectorT") {
-      result.QedType = "matrix";
+    if (this->QedType == qedMatrix && q.QedType == qedVectorT) {
+      result.QedType = qedMatrix;
     }
-    if (this->QedType == "vector" && q.QedType == "matrix") {
-      result.QedType = "matrix";
+    if (this->QedType == qedVector && q.QedType == qedMatrix) {
+      result.QedType = qedMatrix;
     }
-    if (this->QedType == "vectorT" && q.QedType == "matrix") {
-      result.QedType = "vectorT";
+    if (this->QedType == qedVectorT && q.QedType == qedMatrix) {
+      result.QedType = qedVectorT;
     }
-    if (this->QedType == "vector" && q.QedType == "vectorT") {
-      result.QedType = "matrix";
+    if (this->QedType == qedVector && q.QedType == qedVectorT) {
+      result.QedType = qedMatrix;
     }
-    if (this->QedType == "vectorT" && q.QedType == "vector") {
-      result.QedType = "scalar";
+    if (this->QedType == qedVectorT && q.QedType == qedVector) {
+      result.QedType = qedScalar;
       result.scalar = result.matrix[0][0];
       result.scalar0 = result.matrix0[0][0];
       result.scalarX = result.matrixX[0][0];
@@ -826,41 +835,15 @@ QedElement QedElement::operator* (const QedElement& q) const
   return result;
 
 }
-// define overloaded = (equal) operator
-QedElement QedElement::operator= (const QedElement& q) 
-{
-  QedElement result;
-  this->scalar = q.scalar;
-  this->scalar0 = q.scalar0;
-  this->scalarX = q.scalarX;
-  this->scalarY = q.scalarY;
-  this->scalarZ = q.scalarZ;
-  this->scalar5 = q.scalar5;
-
-  for (int i=0; i<4; i++) {
-    for (int j=0; j<4; j++) {
-      this->matrix[i][j] = q.matrix[i][j];
-      this->matrix0[i][j] = q.matrix0[i][j];
-      this->matrixX[i][j] = q.matrixX[i][j];
-      this->matrixY[i][j] = q.matrixY[i][j];
-      this->matrixZ[i][j] = q.matrixZ[i][j];
-      this->matrix5[i][j] = q.matrix5[i][j];
-    }
-  }
-  this->QedType = q.QedType;
-  this->lIndexName = q.lIndexName;
-  this->lIndexPosition = q.lIndexPosition;
-  return *this;
-}
 void QedElement::SetScalar(Complx sVal){
   SetZeroNone();
-  QedType = "scalar";
+  QedType = qedScalar;
   scalar = sVal;
 }
 
 void QedElement::SetZeroNone(){
-  QedType = "none";
-  lIndexName = "none";
+  QedType = qedNone;
+  lIndexed = false;
   lIndexPosition = 0;
   scalar.Set(0,0);
   scalar0.Set(0,0);
@@ -881,9 +864,9 @@ void QedElement::SetZeroNone(){
 }
 void QedElement::SetGamma(string lIndexNameVal){
   SetZeroNone();
-  lIndexName = lIndexNameVal;
+  lIndexed = (lIndexNameVal != "none");
   lIndexPosition = 1;
-  QedType = "matrix";
+  QedType = qedMatrix;
   for (int i=0; i<4; i++) {
     for (int j=0; j<4; j++) {
       matrix0[i][j] = gamma0[i][j];
@@ -940,7 +923,7 @@ void QedElement::SetU(double px,double py,
 	      double pz,double mass,
 	      int spin){
   SetZeroNone();
-  QedType = "vector";
+  QedType = qedVector;
 
   double energy,momentum,norm;
   Complx a00,a10,a20,a30;
@@ -985,7 +968,7 @@ void QedElement::SetV(double px,double py,
   double energy,momentum,norm;
   double tmpValR,tmpValI;
   Complx a00,a10,a20,a30;
-  QedType = "vector";
+  QedType = qedVector;
   momentum = sqrt(pow(px,2)+pow(py,2)+pow(pz,2));
   energy = sqrt(pow(momentum,2) + pow(mass,2));
   norm = sqrt(energy + mass);
@@ -1034,7 +1017,7 @@ void QedElement::SetUBar(double px,double py,
     }
   }
     
-  QedType = "vectorT";
+  QedType = qedVectorT;
 }
 void QedElement::SetVBar(double px,double py,
 	      double pz,double mass,
@@ -1053,7 +1036,7 @@ void QedElement::SetVBar(double px,double py,
       matrix[i][j] = tmp[i][j];
     }
   }
-  QedType = "vectorT";
+  QedType = qedVectorT;
 }
 void QedElement::SetMomentumSlash(double px,double py,
 				  double pz,double mass){
@@ -1074,7 +1057,7 @@ void QedElement::SetMomentumSlash(double px,double py,
 	  cPz* gammaZ[i][j];
     }
   }
-  QedType = "matrix";
+  QedType = qedMatrix;
 }
 void QedElement::SetEpsilonSlash(double cx,double cy,
 				  double cz){
@@ -1090,7 +1073,7 @@ void QedElement::SetEpsilonSlash(double cx,double cy,
 	  cCz*gammaZ[i][j];
     }
   }
-  QedType = "matrix";
+  QedType = qedMatrix;
 }
 void QedElement::ShowMatrix(int matNumber){
   if (matNumber == -1) {
@@ -1174,8 +1157,9 @@ void QedElement::ShowMatrix(int matNumber){
 
 }
 void QedElement::ShowAll(){
-  cout<<"QedType = "<<QedType<<endl;
-  cout<<"lIndexName = "<<lIndexName<<endl;
+  const char *typeNames[] = {"none","scalar","vector","vectorT","matrix"};
+  cout<<"QedType = "<<typeNames[QedType]<<endl;
+  cout<<"lIndexName = "<<(lIndexed ? "indexed" : "none")<<endl;
   cout<<"scalar = ";scalar.Show();
   cout<<"scalar0 = ";scalar0.Show();
   cout<<"scalarX = ";scalarX.Show();
@@ -1383,45 +1367,55 @@ double ampSqPT(int rxnType,int polDirection, TLorentzVector target, TLorentzVect
     phoSpin2 = 1; //X-DIRECTION
   }
 
-  //Sum over spin assignments
+  //Fermion propagators do not depend on the spins
+  QedElement propE31 = (p3Slash - p1Slash) + mValElectron;
+  QedElement propE14 = (p1Slash - p4Slash) + mValElectron;
+  QedElement propE51 = (p5Slash - p1Slash) + mValElectron;
+  QedElement propT12 = p1Slash + p2Slash + mValTarget;
+  QedElement propT51 = p5Slash - p1Slash + mValTarget;
+  QedElement propT31 = p3Slash - p1Slash + mValTarget;
+  QedElement lepton1,lepton2,current34,current52;
+
+  //Sum over spin assignments, filling each spinor in the loop over its own spin.
+  //The products are evaluated left to right, so the leading factors that only
+  //depend on the outer spins are formed outside the inner loops.
   for (spin1=phoSpin1;spin1<=phoSpin2;spin1+=2){//SUMMING OVER INITIAL PHOTON SPINS
+    if (spin1 == -1) ep1Slash.SetEpsilonSlash(0,1,0); //PHOTON POLARIZED IN Y-DIRECTION
+    if (spin1 ==  1) ep1Slash.SetEpsilonSlash(1,0,0); //PHOTON POLARIZED IN X-DIRECTION
     for (spin2=-1;spin2<=+1;spin2+=2){ //SUMMING OVER INITIAL TARGET SPINS
+      u2.SetU(px2,py2,pz2,massTarget,spin2);
       for (spin3=-1;spin3<=+1;spin3+=2){//SUMMING OVER ELECTRON SPINS
+        u3Bar.SetUBar(px3,py3,pz3,massElectron,spin3);
         for (spin4=-1;spin4<=+1;spin4+=2){//SUMMING OVER POSITRON SPINS
+          v4.SetV(px4,py4,pz4,massElectron,spin4);
+          lepton1 = u3Bar*ep1Slash*propE31*gammaMu1*v4;
+          lepton2 = u3Bar*gammaMu1*propE14*ep1Slash*v4;
+          current34 = u3Bar*gammaMu2*v4;
           for (spin5=-1;spin5<=+1;spin5+=2){//SUMMING OVER RECOIL SPINS
-            u2.SetU(px2,py2,pz2,massTarget,spin2);
-            u3Bar.SetUBar(px3,py3,pz3,massElectron,spin3);
-            v4.SetV(px4,py4,pz4,massElectron,spin4);
             u5Bar.SetUBar(px5,py5,pz5,massTarget,spin5);
-
-            if (spin1 == -1) ep1Slash.SetEpsilonSlash(0,1,0); //PHOTON POLARIZED IN Y-DIRECTION
-            if (spin1 ==  1) ep1Slash.SetEpsilonSlash(1,0,0); //PHOTON POLARIZED IN X-DIRECTION
+            current52 = u5Bar*gammaMu2*u2;
 
             //create the matrix elements
-            matrixElementTmp1 = u3Bar*ep1Slash*((p3Slash - p1Slash) + mValElectron)*gammaMu1*v4*
-              (u5Bar*gammaMu2*u2);
-            matrixElementTmp2 = u3Bar*gammaMu1*((p1Slash - p4Slash) + mValElectron)*ep1Slash*v4*
-              (u5Bar*gammaMu2*u2);
+            matrixElementTmp1 = lepton1*current52;
+            matrixElementTmp2 = lepton2*current52;
 
 	    if (rxnType == 3) {
 	      //Swap the 5 and 3 electron legs                                    
-	      matrixElementTmp3 = u5Bar*ep1Slash*((p5Slash - p1Slash) + mValElectron)*gammaMu1*v4*
+	      matrixElementTmp3 = u5Bar*ep1Slash*propE51*gammaMu1*v4*
 		(u3Bar*gammaMu2*u2);
-	      matrixElementTmp4 = u5Bar*gammaMu1*((p1Slash - p4Slash) + mValElectron)*ep1Slash*v4*
+	      matrixElementTmp4 = u5Bar*gammaMu1*propE14*ep1Slash*v4*
 		(u3Bar*gammaMu2*u2);
-	    }
 
-            //Compton like diagrams
-            matrixElementTmp5 = u5Bar*gammaMu1*(p1Slash + p2Slash + mValTarget)*ep1Slash*u2*
-	      (u3Bar*gammaMu2*v4);
-            matrixElementTmp6 = u5Bar*ep1Slash*(p5Slash - p1Slash + mValTarget)*gammaMu1*u2*
-	      (u3Bar*gammaMu2*v4);
+	      //Compton like diagrams, only in the rxnType 3 sum
+	      matrixElementTmp5 = u5Bar*gammaMu1*propT12*ep1Slash*u2*
+		current34;
+	      matrixElementTmp6 = u5Bar*ep1Slash*propT51*gammaMu1*u2*
+		current34;
 
-	    if (rxnType == 3) {	    
 	      //Swap the 5 and 3 electron legs                                                   
-	      matrixElementTmp7 = u3Bar*gammaMu1*(p1Slash + p2Slash + mValTarget)*ep1Slash*u2*
+	      matrixElementTmp7 = u3Bar*gammaMu1*propT12*ep1Slash*u2*
 		(u5Bar*gammaMu2*v4);
-	      matrixElementTmp8 = u3Bar*ep1Slash*(p3Slash - p1Slash + mValTarget)*gammaMu1*u2*
+	      matrixElementTmp8 = u3Bar*ep1Slash*propT31*gammaMu1*u2*
 		(u5Bar*gammaMu2*v4);
 	    }
 
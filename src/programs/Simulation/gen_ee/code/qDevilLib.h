@@ -45,13 +45,13 @@ class Complx
   Complx operator=(const Complx&);       // operator=()
   void Show();
   void Set(double rVal,double iVal);
-  double r(){return real;}
-  double i(){return imag;}
-  Complx Star(){
+  double r() const {return real;}
+  double i() const {return imag;}
+  Complx Star() const {
     Complx starVal(real,-imag);
     return starVal;
   }
-  double Abs(){return sqrt(pow(real,2)+pow(imag,2));}
+  double Abs() const {return sqrt(pow(real,2)+pow(imag,2));}
 };
 /*
 // define constructor
@@ -61,6 +61,14 @@ Complx::Complx( double r, double i )
 }
 */
 /////////////////////////////
+// Spinors and Dirac matrices are held as 4x4 matrices: a "vector" uses
+// only column 0 and a "vectorT" only row 0, which operator* exploits.
+// An element carrying a free Lorentz index keeps one component per
+// index value (0,X,Y,Z,5); two indexed elements are contracted when
+// multiplied. The index name given to SetGamma is not kept, since any
+// two indices are contracted.
+enum QedTypes {qedNone, qedScalar, qedVector, qedVectorT, qedMatrix};
+
 class QedElement
 {
   Complx scalar,scalar0,scalarX,scalarY,scalarZ,scalar5;
@@ -69,68 +77,19 @@ class QedElement
     matrixX[4][4],
     matrixY[4][4],
     matrixZ[4][4],
-    matrix5[4][4],
-    gamma0[4][4],
+    matrix5[4][4];
+  static const Complx gamma0[4][4],
     gammaX[4][4],
     gammaY[4][4],
     gammaZ[4][4],
     gamma5[4][4];
-  string QedType;
-  string lIndexName;
+  int QedType;
+  bool lIndexed;
   int lIndexPosition;
  public:
   QedElement()  { // constructor
-  QedType = "none";
-  lIndexName = "none";
-  lIndexPosition = 0;
-  scalar.Set(0,0);
-  scalar0.Set(0,0);
-  scalarX.Set(0,0);
-  scalarY.Set(0,0);
-  scalarZ.Set(0,0);
-  scalar5.Set(0,0);
-  for (int i=0; i<4; i++) {
-    for (int j=0; j<4; j++) {
-      matrix[i][j].Set(0,0); 
-      matrix0[i][j].Set(0,0); 
-      matrixX[i][j].Set(0,0); 
-      matrixY[i][j].Set(0,0); 
-      matrixZ[i][j].Set(0,0); 
-      matrix5[i][j].Set(0,0); 
-      gamma0[i][j].Set(0,0); 
-      gammaX[i][j].Set(0,0); 
-      gammaY[i][j].Set(0,0); 
-      gammaZ[i][j].Set(0,0); 
-      gamma5[i][j].Set(0,0); 
-    }
-  }
-  //Gamma0                                                                      
-  gamma0[0][0].Set(1,0);
-  gamma0[1][1].Set(1,0);
-  gamma0[2][2].Set(-1,0);
-  gamma0[3][3].Set(-1,0);
-  //GammaX                                                                      
-  gammaX[0][3].Set(1,0);
-  gammaX[1][2].Set(1,0);
-  gammaX[2][1].Set(-1,0);
-  gammaX[3][0].Set(-1,0);
-  //GammaY                                                                      
-  gammaY[0][3].Set(0,-1);
-  gammaY[1][2].Set(0,1);
-  gammaY[2][1].Set(0,1);
-  gammaY[3][0].Set(0,-1);
-  //GammaZ                                                                      
-  gammaZ[0][2].Set(1,0);
-  gammaZ[1][3].Set(-1,0);
-  gammaZ[2][0].Set(-1,0);
-  gammaZ[3][1].Set(1,0);
-  //Gamma5                                                                      
-  gamma5[0][2].Set(1,0);
-  gamma5[1][3].Set(1,0);
-  gamma5[2][0].Set(1,0);
-  gamma5[3][1].Set(1,0);
+  SetZeroNone();
   }
-  QedElement operator=(const QedElement&);             // operator=()
   QedElement operator*(const QedElement&) const;       // operator*()
   QedElement operator+(const QedElement&) const;       // operator+()
   QedElement operator-(const QedElement&) const;       // operator-()
@@ -155,60 +114,5 @@ class QedElement
   void ShowAll();
   void ShowMatrix(int matNumber);
 };
-/*
-// define constructor
-QedElement::QedElement()
-{
-  QedType = "none";
-  lIndexName = "none";
-  lIndexPosition = 0;
-  scalar.Set(0,0);
-  scalar0.Set(0,0);
-  scalarX.Set(0,0);
-  scalarY.Set(0,0);
-  scalarZ.Set(0,0);
-  scalar5.Set(0,0);
-  for (int i=0; i<4; i++) {
-    for (int j=0; j<4; j++) {
-      matrix[i][j].Set(0,0); 
-      matrix0[i][j].Set(0,0); 
-      matrixX[i][j].Set(0,0); 
-      matrixY[i][j].Set(0,0); 
-      matrixZ[i][j].Set(0,0); 
-      matrix5[i][j].Set(0,0); 
-      gamma0[i][j].Set(0,0); 
-      gammaX[i][j].Set(0,0); 
-      gammaY[i][j].Set(0,0); 
-      gammaZ[i][j].Set(0,0); 
-      gamma5[i][j].Set(0,0); 
-    }
-  }
-  //Gamma0                                                                      
-  gamma0[0][0].Set(1,0);
-  gamma0[1][1].Set(1,0);
-  gamma0[2][2].Set(-1,0);
-  gamma0[3][3].Set(-1,0);
-  //GammaX                                                                      
-  gammaX[0][3].Set(1,0);
-  gammaX[1][2].Set(1,0);
-  gammaX[2][1].Set(-1,0);
-  gammaX[3][0].Set(-1,0);
-  //GammaY                                                                      
-  gammaY[0][3].Set(0,-1);
-  gammaY[1][2].Set(0,1);
-  gammaY[2][1].Set(0,1);
-  gammaY[3][0].Set(0,-1);
-  //GammaZ                                                                      
-  gammaZ[0][2].Set(1,0);
-  gammaZ[1][3].Set(-1,0);
-  gammaZ[2][0].Set(-1,0);
-  gammaZ[3][1].Set(1,0);
-  //Gamma5                                                                      
-  gamma5[0][2].Set(1,0);
-  gamma5[1][3].Set(1,0);
-  gamma5[2][0].Set(1,0);
-  gamma5[3][1].Set(1,0);
-}
-*/
 
 #endif // _QDEVILLIB_
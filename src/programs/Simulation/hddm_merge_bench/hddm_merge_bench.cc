@@ -0,0 +1,290 @@
+// hddm_merge_bench
+//
+// Times the merging of background records into a simulated event, as
+// mcsmear does it with -P: adding the records one at a time with the
+// pairwise += operators of hddm_s_merger (mcsmear -P -M), and merging
+// them all at once with hddm_s_merger::merge_records (the default). Both
+// are run on copies of the same synthetic records, for 1, 10 and 50
+// background records per event, and the merged records are compared
+// with each other. They must be identical; the program exits with a
+// non-zero status if any of them differ.
+//
+// Every record has hits in the CDC, FDC wires, BCAL, TOF and FCAL, in
+// random channels, with hit times spread over a few hundred ns so that
+// some of the hits from different records fall within the same
+// integration window and get summed. The background records are shifted
+// in time by a random multiple of the beam bunch period, as in mcsmear.
+//
+// Usage: hddm_merge_bench [nevents [nchannels]]   (default 20 100)
+//
+// where nchannels is the mean number of hit CDC straws per record; the
+// other detectors scale with it.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+
+#include <HDDM/hddm_s.hpp>
+
+// mcsmear is a program, not a library, so build its merger in directly
+#include "hddm_s_merger.cc"
+
+using namespace std;
+
+static double Uniform(double a, double b)
+{
+	return a + (b - a) * rand() / RAND_MAX;
+}
+
+//-----------
+// Channels
+//
+// A sorted set of random channel indices, as the merger requires the
+// channel lists of each record to be in order without duplicates
+//-----------
+static set<vector<int> > Channels(int n, int n0, int n1, int n2=1)
+{
+	set<vector<int> > chans;
+	for (int i = 0; i < n; i++) {
+		vector<int> chan(3);
+		chan[0] = 1 + rand() % n0;
+		chan[1] = 1 + rand() % n1;
+		chan[2] = 1 + rand() % n2;
+		chans.insert(chan);
+	}
+	return chans;
+}
+
+//-----------
+// HitTimes
+//
+// 1 to 3 hit times in increasing order
+//-----------
+static vector<double> HitTimes()
+{
+	vector<double> times;
+	double t = Uniform(-100, 100);
+	int nhits = 1 + rand() % 3;
+	for (int i = 0; i < nhits; i++) {
+		t += Uniform(0, 300);
+		times.push_back(t);
+	}
+	return times;
+}
+
+//-----------
+// MakeRecord
+//
+// Lists are filled by adding an element at the end and setting it up
+// through the list, as the merger itself does
+//-----------
+static void MakeRecord(hddm_s::HDDM &record, int nchannels)
+{
+	record.getPhysicsEvents().add(1);
+	hddm_s::HitViewList &views = record.getPhysicsEvents()(0).getHitViews();
+	views.add(1);
+	hddm_s::HitView &hits = views(0);
+	set<vector<int> >::iterator ch;
+
+	hits.getCentralDCs().add(1);
+	hddm_s::CdcStrawList &cdc = hits.getCentralDCs()(0).getCdcStraws();
+	set<vector<int> > straws = Channels(nchannels, 28, 200);
+	for (ch = straws.begin(); ch != straws.end(); ++ch) {
+		cdc.add(1);
+		hddm_s::CdcStraw &straw = cdc(cdc.size() - 1);
+		straw.setRing((*ch)[0]);
+		straw.setStraw((*ch)[1]);
+		hddm_s::CdcStrawHitList &cdchits = straw.getCdcStrawHits();
+		vector<double> times = HitTimes();
+		for (size_t j = 0; j < times.size(); j++) {
+			cdchits.add(1);
+			cdchits(j).setT(times[j]);
+			cdchits(j).setQ(Uniform(0, 10));
+		}
+	}
+
+	hits.getForwardDCs().add(1);
+	hddm_s::FdcChamberList &fdc = hits.getForwardDCs()(0).getFdcChambers();
+	set<vector<int> > wires = Channels(nchannels / 2, 4, 6, 96);
+	for (ch = wires.begin(); ch != wires.end(); ++ch) {
+		if (fdc.size() == 0 ||
+		    fdc(fdc.size() - 1).getModule() != (*ch)[0] ||
+		    fdc(fdc.size() - 1).getLayer() != (*ch)[1])
+		{
+			fdc.add(1);
+			fdc(fdc.size() - 1).setModule((*ch)[0]);
+			fdc(fdc.size() - 1).setLayer((*ch)[1]);
+		}
+		hddm_s::FdcAnodeWireList &fdcwires = fdc(fdc.size() - 1).getFdcAnodeWires();
+		fdcwires.add(1);
+		hddm_s::FdcAnodeWire &wire = fdcwires(fdcwires.size() - 1);
+		wire.setWire((*ch)[2]);
+		hddm_s::FdcAnodeHitList &fdchits = wire.getFdcAnodeHits();
+		vector<double> times = HitTimes();
+		for (size_t j = 0; j < times.size(); j++) {
+			fdchits.add(1);
+			fdchits(j).setT(times[j]);
+			fdchits(j).setDE(Uniform(0, 1e-5));
+		}
+	}
+
+	hits.getBarrelEMcals().add(1);
+	hddm_s::BcalCellList &bcal = hits.getBarrelEMcals()(0).getBcalCells();
+	set<vector<int> > cells = Channels(nchannels / 2, 48, 4, 4);
+	for (ch = cells.begin(); ch != cells.end(); ++ch) {
+		bcal.add(1);
+		hddm_s::BcalCell &cell = bcal(bcal.size() - 1);
+		cell.setModule((*ch)[0]);
+		cell.setLayer((*ch)[1]);
+		cell.setSector((*ch)[2]);
+		hddm_s::BcalfADCHitList &adc = cell.getBcalfADCHits();
+		hddm_s::BcalTDCHitList &tdc = cell.getBcalTDCHits();
+		hddm_s::BcalfADCDigiHitList &adcdigi = cell.getBcalfADCDigiHits();
+		hddm_s::BcalTDCDigiHitList &tdcdigi = cell.getBcalTDCDigiHits();
+		for (int end = 0; end < 2; end++) {
+			vector<double> times = HitTimes();
+			for (size_t j = 0; j < times.size(); j++) {
+				int n = adc.size();
+				double E = Uniform(0, 0.1);
+				adc.add(1);
+				adc(n).setEnd(end);
+				adc(n).setE(E);
+				adc(n).setT(times[j]);
+				tdc.add(1);
+				tdc(n).setEnd(end);
+				tdc(n).setT(times[j]);
+				adcdigi.add(1);
+				adcdigi(n).setEnd(end);
+				adcdigi(n).setPulse_integral(E * 1e4);
+				adcdigi(n).setPulse_time(times[j]);
+				tdcdigi.add(1);
+				tdcdigi(n).setEnd(end);
+				tdcdigi(n).setTime(times[j]);
+			}
+		}
+	}
+
+	hits.getForwardTOFs().add(1);
+	hddm_s::FtofCounterList &tof = hits.getForwardTOFs()(0).getFtofCounters();
+	set<vector<int> > counters = Channels(nchannels / 5, 2, 46);
+	for (ch = counters.begin(); ch != counters.end(); ++ch) {
+		tof.add(1);
+		hddm_s::FtofCounter &counter = tof(tof.size() - 1);
+		counter.setPlane((*ch)[0] - 1);
+		counter.setBar((*ch)[1]);
+		hddm_s::FtofHitList &tofhits = counter.getFtofHits();
+		for (int end = 0; end < 2; end++) {
+			vector<double> times = HitTimes();
+			for (size_t j = 0; j < times.size(); j++) {
+				int n = tofhits.size();
+				tofhits.add(1);
+				tofhits(n).setEnd(end);
+				tofhits(n).setT(times[j]);
+				tofhits(n).setDE(Uniform(0, 0.01));
+			}
+		}
+	}
+
+	hits.getForwardEMcals().add(1);
+	hddm_s::FcalBlockList &fcal = hits.getForwardEMcals()(0).getFcalBlocks();
+	set<vector<int> > blocks = Channels(nchannels, 59, 59);
+	for (ch = blocks.begin(); ch != blocks.end(); ++ch) {
+		fcal.add(1);
+		hddm_s::FcalBlock &block = fcal(fcal.size() - 1);
+		block.setColumn((*ch)[0]);
+		block.setRow((*ch)[1]);
+		hddm_s::FcalHitList &fcalhits = block.getFcalHits();
+		vector<double> times = HitTimes();
+		for (size_t j = 0; j < times.size(); j++) {
+			fcalhits.add(1);
+			fcalhits(j).setT(times[j]);
+			fcalhits(j).setE(Uniform(0, 0.5));
+		}
+	}
+}
+
+//-----------
+// main
+//-----------
+int main(int narg, char *argv[])
+{
+	int nevents   = (narg > 1)? atoi(argv[1]) : 20;
+	int nchannels = (narg > 2)? atoi(argv[2]) : 100;
+	if (nevents < 1 || nchannels < 5) {
+		cout << "Usage: hddm_merge_bench [nevents [nchannels]]" << endl;
+		return 1;
+	}
+
+	const int nbackgrounds[] = {1, 10, 50};
+	const double bunch_period_ns = 4.008;
+
+	srand(1);
+	int nmismatch = 0;
+	cout << setw(12) << "backgrounds"
+	     << setw(18) << "pairwise us/ev"
+	     << setw(18) << "one-pass us/ev"
+	     << setw(10) << "speedup"
+	     << setw(12) << "mismatches" << endl;
+	for (int ib = 0; ib < 3; ib++) {
+		int nbg = nbackgrounds[ib];
+		double pairwise_ns = 0;
+		double onepass_ns = 0;
+		int nbad = 0;
+		for (int iev = 0; iev < nevents; iev++) {
+			hddm_s::HDDM event;
+			MakeRecord(event, nchannels);
+			vector<hddm_s::HDDM*> bgs;
+			vector<double> shifts;
+			for (int i = 0; i < nbg; i++) {
+				bgs.push_back(new hddm_s::HDDM());
+				MakeRecord(*bgs.back(), nchannels);
+				shifts.push_back(bunch_period_ns * (rand() % 100 - 50));
+			}
+
+			// the copies are made outside of the timed regions
+			hddm_s::HDDM pairwise;
+			pairwise = event;
+			vector<hddm_s::HDDM*> bgs_pairwise;
+			for (int i = 0; i < nbg; i++) {
+				bgs_pairwise.push_back(new hddm_s::HDDM());
+				*bgs_pairwise.back() = *bgs[i];
+			}
+
+			chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+			for (int i = 0; i < nbg; i++) {
+				hddm_s_merger::set_t_shift_ns(shifts[i]);
+				pairwise += *bgs_pairwise[i];
+			}
+			chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+			hddm_s_merger::merge_records(event, bgs, shifts);
+			chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+
+			pairwise_ns += chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+			onepass_ns += chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+			if (pairwise.toString() != event.toString())
+				++nbad;
+
+			for (int i = 0; i < nbg; i++) {
+				delete bgs[i];
+				delete bgs_pairwise[i];
+			}
+		}
+		cout << setw(12) << nbg
+		     << setw(18) << fixed << setprecision(1) << pairwise_ns / nevents / 1000
+		     << setw(18) << onepass_ns / nevents / 1000
+		     << setw(10) << setprecision(2) << pairwise_ns / onepass_ns
+		     << setw(12) << nbad << endl;
+		nmismatch += nbad;
+	}
+
+	if (nmismatch > 0) {
+		cerr << nmismatch << " merged events differ between pairwise and "
+		     << "one-pass merging" << endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,288 @@
+// SiPM and readout channel hit lists of the BCAL smearing
+//
+// These only depend on the standard library, so that the merging of
+// SiPM hits can be exercised outside of mcsmear (see bcal_merge_bench).
+
+#ifndef _BCALSIPMHITS_H_
+#define _BCALSIPMHITS_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+using namespace std;
+
+//..........................
+// bcal_index is a utility class that encapsulates the
+// module, layer, sector, and end in a single object that
+// can be used as a key to index an STL map. 
+//..........................
+class bcal_index{
+   public:
+      enum EndType{
+         kUp,
+         kDown
+      };
+      
+      bcal_index(unsigned int module, unsigned int layer,
+                 unsigned int sector, unsigned int incident_id,
+                 EndType end)
+       : module(module),
+         layer(layer),
+         sector(sector),
+         incident_id(incident_id),
+         end(end)
+      {}
+   
+      unsigned int module;
+      unsigned int layer;
+      unsigned int sector;
+      unsigned int incident_id;
+      EndType end;
+      
+      bool operator<(const bcal_index &idx) const {
+         if (module < idx.module)
+            return true;
+         if (module > idx.module)
+            return false;
+         if (layer < idx.layer)
+            return true;
+         if (layer > idx.layer)
+            return false;
+         if (sector < idx.sector)
+            return true;
+         if (sector > idx.sector)
+            return false;
+         if (incident_id < idx.incident_id)
+            return true;
+         if (incident_id > idx.incident_id)
+            return false;
+         if ((end==kUp) && (idx.end==kDown))
+            return true;
+         return false;
+      }
+};
+
+//..........................
+// CellHits is a utility class that holds information
+// regarding the energy and time of depostions in a cell
+//..........................
+class CellHits{
+   public:
+      enum EndType{
+         kUp,
+         kDown
+      };
+
+      CellHits() : E(0.0), t(0.0)
+      {}
+      
+      double E;
+      double t;
+      double Etruth;
+      EndType end;
+};
+
+//..........................
+// SiPMHit couples a CellHits object with the index of the
+// SiPM it belongs to and the fADC channel that SiPM is summed
+// into. All SiPM hits of an event are held in a single flat
+// vector so that hits sharing a cell (or a readout channel) can
+// be brought together with one sort and merged in time order
+// in a single pass.
+//..........................
+class SiPMHit{
+   public:
+      SiPMHit(const bcal_index &idx, int channel) : idx(idx), channel(channel)
+      {}
+      
+      bcal_index idx;
+      int channel;   // summed readout channel, see BCALChannelHits
+      CellHits cell;
+      
+      bool SameCell(const SiPMHit &hit) const {
+         return (idx.module == hit.idx.module && idx.layer == hit.idx.layer &&
+                 idx.sector == hit.idx.sector && idx.end == hit.idx.end);
+      }
+      
+      // order by cell and end, then time
+      static bool CellTimeOrder(const SiPMHit &a, const SiPMHit &b) {
+         if (a.idx.module != b.idx.module)
+            return a.idx.module < b.idx.module;
+         if (a.idx.layer != b.idx.layer)
+            return a.idx.layer < b.idx.layer;
+         if (a.idx.sector != b.idx.sector)
+            return a.idx.sector < b.idx.sector;
+         if (a.idx.end != b.idx.end)
+            return a.idx.end < b.idx.end;
+         return a.cell.t < b.cell.t;
+      }
+      
+      // order by readout channel and end, then time
+      static bool ChannelTimeOrder(const SiPMHit &a, const SiPMHit &b) {
+         if (a.channel != b.channel)
+            return a.channel < b.channel;
+         if (a.idx.end != b.idx.end)
+            return a.idx.end < b.idx.end;
+         return a.cell.t < b.cell.t;
+      }
+      
+      // order by bcal_index (module, layer, sector, incident_id, end)
+      static bool IndexOrder(const SiPMHit &a, const SiPMHit &b) {
+         return a.idx < b.idx;
+      }
+};
+
+//..........................
+// BCALChannelHits holds the hits of one event on every BCAL
+// readout channel (summed fADC or TDC channel) in dense arrays
+// indexed by channel number, i.e. GetCalibIndex() of the summed
+// module, layer and sector. The energies and times of all hits
+// live in two flat arrays and each channel/end records where its
+// hits start and how many there are, so the hits of one channel
+// and end must be added consecutively. An occupancy bitmap lets
+// the per-event loops visit only the channels that were hit, and
+// Clear() only resets those, so one object can be reused from
+// event to event without returning to the heap once its arrays
+// have grown to the typical event size.
+//..........................
+class BCALChannelHits{
+   public:
+      BCALChannelHits()
+      {}
+      
+      void Clear(unsigned int nchannels) {
+         if (occupancy.size() != (nchannels + 63)/64) {
+            first.assign(2*nchannels, 0);
+            count.assign(2*nchannels, 0);
+            occupancy.assign((nchannels + 63)/64, 0);
+         }
+         for (int chan = NextChannel(-1); chan >= 0; chan = NextChannel(chan)) {
+            count[2*chan] = 0;
+            count[2*chan+1] = 0;
+         }
+         std::fill(occupancy.begin(), occupancy.end(), 0);
+         E.clear();
+         t.clear();
+      }
+      
+      void Add(int chan, int end, double Ehit, double thit) {
+         int k = 2*chan + end;
+         if (count[k] == 0)
+            first[k] = E.size();
+         E.push_back(Ehit);
+         t.push_back(thit);
+         count[k]++;
+         occupancy[chan >> 6] |= (1ULL << (chan & 63));
+      }
+      
+      // next occupied channel after chan (pass -1 to start), -1 if none
+      int NextChannel(int chan) const {
+         unsigned int next = chan + 1;
+         unsigned int word = next >> 6;
+         if (word >= occupancy.size())
+            return -1;
+         uint64_t bits = occupancy[word] & (~0ULL << (next & 63));
+         while (bits == 0) {
+            if (++word >= occupancy.size())
+               return -1;
+            bits = occupancy[word];
+         }
+         return (word << 6) + __builtin_ctzll(bits);
+      }
+      
+      bool Empty() const { return E.empty(); }
+      unsigned int Nhits(int chan, int end) const { return count[2*chan + end]; }
+      double &GetE(int chan, int end, unsigned int i) { return E[first[2*chan + end] + i]; }
+      double &Gett(int chan, int end, unsigned int i) { return t[first[2*chan + end] + i]; }
+      
+      vector<double> E;   // all hits, in the order they were added
+      vector<double> t;
+      
+   private:
+      vector<unsigned int> first;   // indexed by 2*channel + end
+      vector<unsigned int> count;
+      vector<uint64_t> occupancy;
+};
+
+//-----------
+// MergeSiPMHits
+//-----------
+inline void MergeSiPMHits(vector<SiPMHit> &SiPMHits, double Resolution)
+{
+   /// Combine all SiPM CellHits corresponding to the same
+   /// cell but different incident particles into a single
+   /// hit. This is done after the sampling fluctuations
+   /// have been applied so there is no more dependence on
+   /// the incident particle parameters.
+   ///
+   /// The hits are sorted by cell, end and time, so each hit
+   /// only needs to be compared with the last surviving hit.
+   /// A merged hit keeps the earlier of the two times, and the
+   /// lower of the two bcal_index keys, like the map did.
+   
+   sort(SiPMHits.begin(), SiPMHits.end(), SiPMHit::CellTimeOrder);
+   
+   size_t nkeep = 0;
+   for (size_t i = 0; i < SiPMHits.size(); ++i) {
+      if (nkeep > 0) {
+         CellHits &last = SiPMHits[nkeep-1].cell;
+         CellHits &next = SiPMHits[i].cell;
+         if (SiPMHits[nkeep-1].SameCell(SiPMHits[i]) &&
+             fabs(next.t - last.t) < Resolution)
+         {
+            if (SiPMHits[i].idx < SiPMHits[nkeep-1].idx)
+               SiPMHits[nkeep-1].idx = SiPMHits[i].idx;
+            // It may be possible that one or both of the hits we wish to merge
+            // don't exist. Check for this and handle accordingly.
+            if (last.E == 0.0) {
+               last.E = next.E;
+               last.t = next.t;
+            }
+            else if (next.E != 0.0) {
+               last.E += next.E;
+            }
+            continue;
+         }
+      }
+      if (nkeep != i)
+         SiPMHits[nkeep] = SiPMHits[i];
+      nkeep++;
+   }
+   SiPMHits.erase(SiPMHits.begin() + nkeep, SiPMHits.end());
+}
+
+//-----------
+// SumSiPMHits
+//-----------
+inline void SumSiPMHits(vector<SiPMHit> &SiPMHits, BCALChannelHits &bcalfADC, double Resolution)
+{
+   /// Loop over the CellHits objects and sum them into readout channel hits.
+   ///
+   /// For the BCAL, multiple SiPMs are summed together. This routine gathers individual
+   /// SiPM hits into the hits of the summed cell that is readout by an fADC channel.
+   ///
+   /// The SiPM hits are first sorted by readout channel, end and time. A summed hit keeps
+   /// the time of its earliest contribution, and a new one is only started when a SiPM
+   /// hit is at least Resolution later than the previous one, so each SiPM hit can only
+   /// overlap the most recent summed hit on its channel.
+   
+   sort(SiPMHits.begin(), SiPMHits.end(), SiPMHit::ChannelTimeOrder);
+   
+   vector<SiPMHit>::iterator iter = SiPMHits.begin();
+   for(; iter!=SiPMHits.end(); iter++){
+      CellHits &cellhits = iter->cell;
+      if (cellhits.E == 0.0)
+         continue;
+      
+      int chan = iter->channel;
+      int end = (cellhits.end == CellHits::kUp)? bcal_index::kUp : bcal_index::kDown;
+      unsigned int nhits = bcalfADC.Nhits(chan, end);
+      if (nhits > 0 && fabs(cellhits.t - bcalfADC.Gett(chan, end, nhits-1)) < Resolution)
+         bcalfADC.GetE(chan, end, nhits-1) += cellhits.E;
+      else
+         bcalfADC.Add(chan, end, cellhits.E, cellhits.t);
+   }
+}
+
+#endif // _BCALSIPMHITS_H_
@@ -42,20 +42,21 @@ void BCALSmearer::SmearEvent(hddm_s::HDDM *record)
    /// In addition to the sampling fluctuations, Poisson statistics and
    /// dark pulses are applied.
    
-   // n.b. This code is slightly more complex than it might otherwise be because
-   // it uses sparsified lists as opposed to full data structures for every SiPM
-   // and every summed cell. It is done this way for two reasons:
-   //
-   // 1.) Sparsified lists are quicker to loop through and make the code faster.
-   //
-   // 2.) Sparsified lists are easier to keep on the stack rather than the heap
-   //     avoiding expensive, large memory allocations every event. Alternatively
-   //     one could keep the large structures in global variables but that would 
-   //     not allow for efficient multi-threading.
+   // n.b. The SiPM hits are kept in a flat list of only the cells that were hit.
+   // The summed cells are kept in dense arrays indexed by readout channel with an
+   // occupancy bitmap (see BCALChannelHits), so loops still only visit channels
+   // with hits. The smearer object is shared by all threads, so these work areas
+   // are thread_local; they keep their storage from one event to the next to
+   // avoid going back to the heap for every event.
+   static thread_local vector<SiPMHit> SiPMHits;
+   static thread_local vector<IncidentParticle_t> incident_particles;
+   static thread_local BCALChannelHits bcalfADC;
+   static thread_local BCALChannelHits fADCHits;
+   static thread_local BCALChannelHits TDCHits;
    
     // First, we extract the energies and times for hit cells
-    map<bcal_index, CellHits> SiPMHits;
-    vector<IncidentParticle_t> incident_particles;
+    SiPMHits.clear();
+    incident_particles.clear();
     GetSiPMHits(record, SiPMHits, incident_particles);
 
     // Sampling fluctuations
@@ -64,23 +65,23 @@ void BCALSmearer::SmearEvent(hddm_s::HDDM *record)
     }
 	
     // Merge hits associated with different incident particles
-    MergeHits(SiPMHits, bcal_config->BCAL_TWO_HIT_RESO);
+    MergeSiPMHits(SiPMHits, bcal_config->BCAL_TWO_HIT_RESO);
 
     // Poisson Statistics
 	if(config->SMEAR_HITS) 
     	ApplyPoissonStatistics(SiPMHits);
    
-    // Place all hit cells into list indexed by fADC ID
-    map<int, SumHits> bcalfADC;
-    SortSiPMHits(SiPMHits, bcalfADC, bcal_config->BCAL_TWO_HIT_RESO);
+    // Place all hit cells into list indexed by readout channel
+    bcalfADC.Clear(GetNumChannels());
+    SumSiPMHits(SiPMHits, bcalfADC, bcal_config->BCAL_TWO_HIT_RESO);
 
     // Electronic noise/Dark hits Smearing
 	if(config->SMEAR_HITS) 
     	SimpleDarkHitsSmear(bcalfADC);
     
     // Apply energy threshold to dismiss low-energy hits
-    map<int, fADCHitList> fADCHits;
-    map<int, TDCHitList> TDCHits;
+    fADCHits.Clear(GetNumChannels());
+    TDCHits.Clear(GetNumChannels());
     FindHits(bcal_config->BCAL_ADC_THRESHOLD_MEV, bcalfADC, fADCHits, TDCHits);
 
     // Apply time smearing to emulate the fADC resolution
@@ -89,8 +90,6 @@ void BCALSmearer::SmearEvent(hddm_s::HDDM *record)
    
     // Copy hits into HDDM tree
     CopyBCALHitsToHDDM(fADCHits, TDCHits, record);
-   
-    bcalfADC.clear();
 }
 
 int inline BCALSmearer::GetCalibIndex(int module, int layer, int sector) {
@@ -103,7 +102,7 @@ int inline BCALSmearer::GetCalibIndex(int module, int layer, int sector) {
 // GetSiPMHits
 //-----------
 void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
-                   			  map<bcal_index, CellHits> &SiPMHits,
+                   			  vector<SiPMHit> &SiPMHits,
                    			  vector<IncidentParticle_t> &incident_particles)
 {
    /// Loop through input HDDM data and extract the energy and time info into
@@ -149,27 +148,41 @@ void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
      	layer = 4;
      }
      int table_id = GetCalibIndex( iter->getModule(), layer, iter->getSector() );  // key the cell identification off of the upstream cell
+     int fADCId = dBCALGeom->fADCId( iter->getModule(), iter->getLayer(), iter->getSector() );
+     int channel = GetCalibIndex( dBCALGeom->module(fADCId), dBCALGeom->layer(fADCId), dBCALGeom->sector(fADCId) );
      double cEff = bcal_config->GetEffectiveVelocity(table_id);
      //double attenuation_length = 0; // initialize variable
      //double attenuation_L1=-1., attenuation_L2=-1.;  // these parameters are ignored for now
      //bcal_config->GetAttenuationParameters(table_id, attenuation_length, attenuation_L1, attenuation_L2);
     
-     // Get reference to existing CellHits, or create one if it doesn't exist
-     CellHits &cellhitsup = SiPMHits[idxup];
+     SiPMHits.push_back(SiPMHit(idxup, channel));
+     CellHits &cellhitsup = SiPMHits.back().cell;
      cellhitsup.Etruth = iter->getE(); // Energy deposited in the cell in GeV
      //cellhitsup.E = iter->getE()*exp(-dist_up/attenuation_length)*1000.; // in attenuated MeV
      cellhitsup.E = iter->getE()*exp(-dist_up/bcal_config->BCAL_ATTENUATION_LENGTH)*1000.; // in attenuated MeV
      cellhitsup.t = iter->getT() + dist_up/cEff; // in ns
      cellhitsup.end = CellHits::kUp; // Keep track of BCal end
 
-     // Get reference to existing CellHits, or create one if it doesn't exist
-     CellHits &cellhitsdn = SiPMHits[idxdn];
+     SiPMHits.push_back(SiPMHit(idxdn, channel));
+     CellHits &cellhitsdn = SiPMHits.back().cell;
      cellhitsdn.Etruth = iter->getE(); // Energy deposited in the cell in GeV
      cellhitsdn.E = iter->getE()*exp(-dist_dn/bcal_config->BCAL_ATTENUATION_LENGTH)*1000.; // in attenuated MeV
      cellhitsdn.t = iter->getT() + dist_dn/cEff; // in ns
      cellhitsdn.end = CellHits::kDown; // Keep track of BCal end
    }
 
+   // Put the hits in bcal_index order. If the same index appears
+   // more than once, the last truth hit for it wins.
+   stable_sort(SiPMHits.begin(), SiPMHits.end(), SiPMHit::IndexOrder);
+   size_t nkeep = 0;
+   for (size_t i = 0; i < SiPMHits.size(); ++i) {
+      if (nkeep > 0 && !(SiPMHits[nkeep-1].idx < SiPMHits[i].idx))
+         SiPMHits[nkeep-1] = SiPMHits[i];
+      else
+         SiPMHits[nkeep++] = SiPMHits[i];
+   }
+   SiPMHits.erase(SiPMHits.begin() + nkeep, SiPMHits.end());
+
    // Loop over incident particle list
    hddm_s::BcalTruthIncidentParticleList iparts = 
                                     bcals().getBcalTruthIncidentParticles();
@@ -191,7 +204,7 @@ void BCALSmearer::GetSiPMHits(hddm_s::HDDM *record,
 //-----------
 // ApplySamplingFluctuations
 //-----------
-void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits, vector<IncidentParticle_t> &incident_particles)
+void BCALSmearer::ApplySamplingFluctuations(vector<SiPMHit> &SiPMHits, vector<IncidentParticle_t> &incident_particles)
 {
    /// Loop over the CellHits objects and apply sampling fluctuations.
    ///
@@ -211,10 +224,10 @@ void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits,
    if(bcal_config->NO_SAMPLING_FLOOR_TERM)
    		bcal_config->BCAL_SAMPLINGCOEFB=0.0; // (redundant, yes, but located in more obvious place here)
 
-   map<bcal_index, CellHits>::iterator iter=SiPMHits.begin();
+   vector<SiPMHit>::iterator iter=SiPMHits.begin();
    
    for(; iter!=SiPMHits.end(); iter++){
-      CellHits &cellhits = iter->second;
+      CellHits &cellhits = iter->cell;
       
       // Find fractional sampling sigma based on deposited energy (whole colorimeter, not just fibers)
       double Etruth = cellhits.Etruth;
@@ -236,79 +249,10 @@ void BCALSmearer::ApplySamplingFluctuations(map<bcal_index, CellHits> &SiPMHits,
    }
 }
 
-//-----------
-// MergeHits
-//-----------
-void BCALSmearer::MergeHits(map<bcal_index, CellHits> &SiPMHits, double Resolution)
-{
-   /// Combine all SiPM CellHits corresponding to the same
-   /// cell but different incident particles into a single
-   /// hit. This is done after the sampling fluctuations
-   /// have been applied so there is no more dependence on
-   /// the incident particle parameters.
-   
-   // Loop until no merges are made
-   while(true){
-      bool merge=false;
-      bool merged=false;
-      map<bcal_index, CellHits>::iterator iter1=SiPMHits.begin();
-      for(;iter1!=SiPMHits.end(); iter1++){
-         map<bcal_index, CellHits>::iterator iter2 = iter1;
-         for(++iter2; iter2!=SiPMHits.end(); iter2++){
-         
-            // If hits are not from same module,layer,sector,end
-            // then just continue the loop
-            if(iter1->first.module != iter2->first.module)continue;
-            if(iter1->first.layer  != iter2->first.layer )continue;
-            if(iter1->first.sector != iter2->first.sector)continue;
-            if(iter1->first.end    != iter2->first.end   )continue;
-
-            // If hits are far enough apart in time, don't merge them
-            if(fabs(iter1->second.t - iter2->second.t) < Resolution) merge = true;
-            if(!merge)continue;
-
-            // ----- Merge hits -----
-            if(merge){
-              // Get values
-              double E1 = iter1->second.E;
-              double t1 = iter1->second.t;
-              double E2 = iter2->second.E;
-              double t2 = iter2->second.t;
-              // It may be possible that one or both of the hits we wish to merge
-              // don't exist. Check for this and handle accordingly.
-              if(E1!=0.0 && E2!=0.0){
-                 iter1->second.E += E2;
-                 if(t1 > t2) iter1->second.t = t2; // Keep the earlier of the two times
-              }
-              if(E1==0.0 && E2!=0.0){
-                 iter1->second.E = E2;
-                 iter1->second.t = t2;
-                 iter2->second.E = 0.0;
-                 iter2->second.t = 0.0;
-              }
-            }
-
-            // Erase second one
-            SiPMHits.erase(iter2);
-
-            // Set flag that we did merge hits and break
-            // the loops so we can try again.
-            merged = true;
-            break;
-         }
-         if(merged)break;
-      }
-
-      // When we make it through without merging any hits,
-      // we're done so break out of the infinite while loop.
-      if(!merged)break;
-   }
-}
-
 //-----------
 // ApplyPoissonStatistics
 //-----------
-void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
+void BCALSmearer::ApplyPoissonStatistics(vector<SiPMHit> &SiPMHits)
 {
    /// Loop over the CellHits objects and apply Poisson Statistics.
    ///
@@ -323,9 +267,13 @@ void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
 
    if(bcal_config->NO_POISSON_STATISTICS) return;
 
-   map<bcal_index, CellHits>::iterator iter=SiPMHits.begin();
+   // draw in bcal_index order, the order of the old map, so that the
+   // smeared energies for a given seed do not change
+   sort(SiPMHits.begin(), SiPMHits.end(), SiPMHit::IndexOrder);
+
+   vector<SiPMHit>::iterator iter=SiPMHits.begin();
    for(; iter!=SiPMHits.end(); iter++){
-      CellHits &cellhits = iter->second;
+      CellHits &cellhits = iter->cell;
 
       if(cellhits.E>0.0){
          // Convert to number of PE
@@ -339,144 +287,35 @@ void BCALSmearer::ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits)
    }
 }
 
-//-----------
-// SortSiPMHits
-//-----------
-void BCALSmearer::SortSiPMHits(map<bcal_index, CellHits> &SiPMHits, map<int, SumHits> &bcalfADC, double Resolution)
-{
-   /// Loop over the CellHits objects and copy pointers to them into SumHits objects.
-   ///
-   /// For the BCAL, multiple SiPMs are summed together. This routine gathers individual
-   /// SiPM hits into single SumHits objects. Each SumHits represents a summed
-   /// cell that is readout by an fADC channel. Since not every cell has signal in it, each
-   /// SumHits object may not have as many input cells as SiPMs that will actually be
-   /// contributing.
-   
-   // Loop over SiPMHits and copy a pointer to it to the correct SumHits
-   // element in the bcalfADC container. The bcalfADC container is an STL map which is
-   // convenient since it creates a new SumHits object for us if it doesn't exist,
-   // but otherwise, returns a reference to the existing object.
-   
-   map<bcal_index, CellHits>::iterator iter = SiPMHits.begin();
-   for(; iter!=SiPMHits.end(); iter++){
-      
-      // Get reference to SumHits object
-      const bcal_index &idx = iter->first;
-      int fADCId = dBCALGeom->fADCId( idx.module, idx.layer, idx.sector);
-      SumHits &sumhits = bcalfADC[fADCId];
-      
-      // Add CellHits object to list in SumHits
-      CellHits &cellhits = iter->second;
-      sumhits.cellhits.push_back(&cellhits);
-      
-      // If this is the first cell added to the SumHits, assign its
-      // values to the first elements of the data arrays. Otherwise,
-      // test if the hit overlaps in time with an existing element.
-      bool mergedUP = false;
-      bool mergedDN = false;
-
-      // Upstream
-      if(cellhits.end == CellHits::kUp && cellhits.E != 0.0){
-        if(sumhits.EUP.empty()){
-          sumhits.EUP.push_back(cellhits.E);
-          sumhits.tUP.push_back(cellhits.t);
-        }else{
-          for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
-            if(fabs(cellhits.t - sumhits.tUP[ii]) < Resolution){
-              sumhits.EUP[ii] += cellhits.E;
-              if(sumhits.tUP[ii] > cellhits.t) sumhits.tUP[ii] = cellhits.t; // Again, keep the earlier of the two times
-              mergedUP = true;
-              break;
-            }
-          }
-          if (!mergedUP){
-            sumhits.EUP.push_back(cellhits.E);
-            sumhits.tUP.push_back(cellhits.t);
-          }
-        }
-      }
-      
-      // Downstream
-      if(cellhits.end == CellHits::kDown && cellhits.E != 0.0){
-        if(sumhits.EDN.empty()){
-          sumhits.EDN.push_back(cellhits.E);
-          sumhits.tDN.push_back(cellhits.t);
-        }else{
-          for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){
-            if(fabs(cellhits.t - sumhits.tDN[ii]) < Resolution){
-              sumhits.EDN[ii] += cellhits.E;
-              if(sumhits.tDN[ii] > cellhits.t) sumhits.tDN[ii] = cellhits.t; // Again, keep the earlier of the two times
-              mergedDN = true;
-              break;
-            }
-          }
-          if (!mergedDN){
-            sumhits.EDN.push_back(cellhits.E);
-            sumhits.tDN.push_back(cellhits.t);
-          }
-        }
-      }
-   }
-}
-
 //-----------
 // SimpleDarkHitsSmear
 //-----------
-void BCALSmearer::SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC)
+void BCALSmearer::SimpleDarkHitsSmear(BCALChannelHits &bcalfADC)
 {
-   /// Loop over the SumHits objects and add Electronic noise and
+   /// Loop over the summed hits and add Electronic noise and
    /// Dark hits smearing.
    ///
-   /// Take SumHits objects and add to their energy values a random
+   /// Take summed hits and add to their energy values a random
    /// energy as sampled from a Gaussian.  The Gaussian for each 
    /// BCAL layer is based on data taken in May of 2015.
    /// In future, data on a channel-by-channel basis will be implemented.
 
    if(bcal_config->NO_DARK_PULSES) return;
    
-   double Esmeared = 0;
-   double sigma = 0;
-   
-   double sigma1 = bcal_config->BCAL_LAYER1_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
-   double sigma2 = bcal_config->BCAL_LAYER2_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
-   double sigma3 = bcal_config->BCAL_LAYER3_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
-   double sigma4 = bcal_config->BCAL_LAYER4_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
-
-   // Loop over all fADC readout cells
-   for(int imodule=1; imodule<=bcal_config->BCAL_NUM_MODULES; imodule++){
-
-      int n_layers = bcal_config->BCAL_NUM_LAYERS;
-      for(int fADC_lay=1; fADC_lay<=n_layers; fADC_lay++){
-         if(fADC_lay == 1) 
-         	sigma = sigma1;
-         else if(fADC_lay == 2) 
-         	sigma = sigma2;
-         else if(fADC_lay == 3) 
-         	sigma = sigma3;
-         else if(fADC_lay == 4) 
-         	sigma = sigma4;
-
-		 // there's a constant number of sectors now...
-         //int n_sectors = (fADC_lay <= dBCALGeom->GetBCAL_NInnerLayers())? dBCALGeom->GetBCAL_NInnerSectors() : dBCALGeom->GetBCAL_NOuterSectors();
-		 int n_sectors = bcal_config->BCAL_NUM_SECTORS;
-         for(int fADC_sec=1; fADC_sec<=n_sectors; fADC_sec++){
-
-            // Use cellId(...) to convert fADC layer and sector into fADCId
-            // (see dBCALGeom->fADCId)
-            int fADCId = dBCALGeom->cellId(imodule, fADC_lay, fADC_sec);
-            
-            // Get SumHits object if it already exists or create new one 
-            // if it doesn't.
-            SumHits &sumhits = bcalfADC[fADCId];
-
-            for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
-				Esmeared = gDRandom.Gaus(sumhits.EUP[ii],sigma);
-				sumhits.EUP[ii] = Esmeared;
-            }
-            for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){
-            	Esmeared = gDRandom.Gaus(sumhits.EDN[ii],sigma);
-            	sumhits.EDN[ii] = Esmeared;
-            }
+   double sigma[4];
+   sigma[0] = bcal_config->BCAL_LAYER1_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
+   sigma[1] = bcal_config->BCAL_LAYER2_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
+   sigma[2] = bcal_config->BCAL_LAYER3_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
+   sigma[3] = bcal_config->BCAL_LAYER4_SIGMA_SCALE*bcal_config->BCAL_MEV_PER_ADC_COUNT; 
+
+   // Loop over the fADC readout cells that have hits, in the same
+   // module/layer/sector order as a loop over all of them
+   for(int chan = bcalfADC.NextChannel(-1); chan >= 0; chan = bcalfADC.NextChannel(chan)){
+      double layer_sigma = sigma[ChannelLayer(chan)-1];
+      for(int end = 0; end < 2; end++){
+         for(unsigned int ii = 0; ii < bcalfADC.Nhits(chan, end); ii++){
+            double &E = bcalfADC.GetE(chan, end, ii);
+            E = gDRandom.Gaus(E, layer_sigma);
          }
       }
    }
@@ -485,7 +324,7 @@ void BCALSmearer::SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC)
 //-----------
 // ApplyTimeSmearing
 //-----------
-void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<int, fADCHitList> &fADCHits, map<int, TDCHitList> &TDCHits)
+void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, BCALChannelHits &fADCHits, BCALChannelHits &TDCHits)
 {
    /// The fADC250 will extract a time from the samples by applying an algorithm
    /// to a few of the samples taken every 4ns. The perfect times from HDGeant
@@ -498,124 +337,54 @@ void BCALSmearer::ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<in
    double BCAL_TIMINGADCCOEFA = 0.055;
    double BCAL_TIMINGADCCOEFB = 0.000;
 
-   map<int, fADCHitList>::iterator it = fADCHits.begin();
-   for(; it!=fADCHits.end(); it++){
-      fADCHitList &hitlist = it->second;
-      
-      // upstream
-      for(unsigned int i=0; i<hitlist.uphits.size(); i++){
-         double EGeV = hitlist.uphits[i].E/1000;
-         double sqrtterm = BCAL_TIMINGADCCOEFA / sqrt(EGeV);
-         double linterm = BCAL_TIMINGADCCOEFB;
-         double sigma_ns_ADC = sqrt(sqrtterm*sqrtterm + linterm*linterm);
-         hitlist.uphits[i].t += gDRandom.SampleGaussian(sigma_ns_ADC);
-      }
-
-      // downstream
-      for(unsigned int i=0; i<hitlist.dnhits.size(); i++){
-         double EGeV = hitlist.dnhits[i].E/1000;
-         double sqrtterm = BCAL_TIMINGADCCOEFA / sqrt(EGeV);
-         double linterm = BCAL_TIMINGADCCOEFB;
-         double sigma_ns_ADC = sqrt(sqrtterm*sqrtterm + linterm*linterm);
-         hitlist.dnhits[i].t += gDRandom.SampleGaussian(sigma_ns_ADC);
-      }
+   // The hits are stored channel by channel, upstream before downstream,
+   // so looping over the flat arrays visits them in readout order.
+   for(unsigned int i=0; i<fADCHits.E.size(); i++){
+      double EGeV = fADCHits.E[i]/1000;
+      double sqrtterm = BCAL_TIMINGADCCOEFA / sqrt(EGeV);
+      double linterm = BCAL_TIMINGADCCOEFB;
+      double sigma_ns_ADC = sqrt(sqrtterm*sqrtterm + linterm*linterm);
+      fADCHits.t[i] += gDRandom.SampleGaussian(sigma_ns_ADC);
    }
 
-   map<int, TDCHitList>::iterator itTDC = TDCHits.begin();
-   for(; itTDC!=TDCHits.end(); itTDC++){
-      TDCHitList &TDChitlist = itTDC->second;
-      
-      // upstream
-      for(unsigned int i=0; i<TDChitlist.uphits.size(); i++){
-         TDChitlist.uphits[i] += gDRandom.SampleGaussian(sigma_ns_TDC);
-      }
-
-      // downstream
-      for(unsigned int i=0; i<TDChitlist.dnhits.size(); i++){
-         TDChitlist.dnhits[i] += gDRandom.SampleGaussian(sigma_ns_TDC);
-      }
+   for(unsigned int i=0; i<TDCHits.t.size(); i++){
+      TDCHits.t[i] += gDRandom.SampleGaussian(sigma_ns_TDC);
    }
 }
 
 //-----------
 // FindHits
 //-----------
-void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<int, fADCHitList> &fADCHits, map<int,TDCHitList> &TDCHits)
+void BCALSmearer::FindHits(double thresh_MeV, BCALChannelHits &bcalfADC, BCALChannelHits &fADCHits, BCALChannelHits &TDCHits)
 {
-   /// Loop over Sumhits objects and find hits that cross the energy threshold (ADC)
-   map<int, SumHits>::iterator iter = bcalfADC.begin();
-   for(; iter!=bcalfADC.end(); iter++){
-      
-      int fADCId = iter->first;
-      SumHits &sumhits = iter->second;
+   /// Loop over summed hits and find hits that cross the energy threshold (ADC)
 
-      vector<fADCHit> uphits;
-      vector<fADCHit> dnhits;
+   // The histogram should have the signal size for the ADC, but the TDC
+   // leg will actually have a larger size since the pre-amp gain will be
+   // set differently. Scale the threshold down here to accomodate this.
+   double preamp_gain_tdc = 5.0;
+   double thresh_MeV_TDC = thresh_MeV/preamp_gain_tdc;
 
-      vector<double> uphitsTDC;
-      vector<double> dnhitsTDC;
-
-      // The histogram should have the signal size for the ADC, but the TDC
-      // leg will actually have a larger size since the pre-amp gain will be
-      // set differently. Scale the threshold down here to accomodate this.
-      double preamp_gain_tdc = 5.0;
-      double thresh_MeV_TDC = thresh_MeV/preamp_gain_tdc;
+   for(int chan = bcalfADC.NextChannel(-1); chan >= 0; chan = bcalfADC.NextChannel(chan)){
 	  //the outermost layer of the detector is not equipped with TDCs, so don't generate any TDC hits
-	  int layer = dBCALGeom->layer(fADCId);
-
-      for(int ii = 0; ii < (int)sumhits.EUP.size(); ii++){
-        // correct simulation efficiencies 
-		if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
-		 																				  dBCALGeom->layer(fADCId),
-		 																				  dBCALGeom->sector(fADCId)),
-		 																				  DBCALGeometry::End::kUpstream)))
-		 			continue;
-		 			
-        if(sumhits.EUP[ii] > thresh_MeV && sumhits.tUP[ii] < 2000) uphits.push_back(fADCHit(sumhits.EUP[ii],sumhits.tUP[ii])); // Fill uphits and dnhits with energies (in MeV)
-        if(layer != 4 && sumhits.EUP[ii] > thresh_MeV_TDC && sumhits.tUP[ii] < 2000) uphitsTDC.push_back(sumhits.tUP[ii]);     // and times when they cross an energy threshold.
-      }                                                                                                                        // Also fill TDC uphits and dnhits with times if
-      for(int ii = 0; ii < (int)sumhits.EDN.size(); ii++){                                                                     // they are not layer 4 hits and cross threshold.
-        // correct simulation efficiencies 
-		if (config->APPLY_EFFICIENCY_CORRECTIONS
-		 		&& !gDRandom.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(GetCalibIndex(dBCALGeom->module(fADCId),
-		 																				  dBCALGeom->layer(fADCId),
-		 																				  dBCALGeom->sector(fADCId)),
-		 																				  DBCALGeometry::End::kDownstream)))
-		 			continue;
-
-        if(sumhits.EDN[ii] > thresh_MeV && sumhits.tDN[ii] < 2000) dnhits.push_back(fADCHit(sumhits.EDN[ii],sumhits.tDN[ii]));
-        if(layer != 4 && sumhits.EDN[ii] > thresh_MeV_TDC && sumhits.tDN[ii] < 2000) dnhitsTDC.push_back(sumhits.tDN[ii]);
-      }
-      
-      // If at least one ADC readout channel has a hit, add the readout cell to fADCHits
-      if(uphits.size()>0 || dnhits.size()>0){
-         fADCHitList &hitlist = fADCHits[fADCId];
-
-         // The module, fADC layer, and fADC sector are encoded in fADCId
-         // (n.b. yes, these are the same methods used for extracting 
-         // similar quantities from the cellId.)
-         hitlist.module = dBCALGeom->module(fADCId);
-         hitlist.sumlayer = dBCALGeom->layer(fADCId);
-         hitlist.sumsector = dBCALGeom->sector(fADCId);
-         
-         hitlist.uphits = uphits;
-         hitlist.dnhits = dnhits;
-      }
-      
-      // If at least one TDC readout channel has a hit, add the readout cell to TDCHits
-      if(uphitsTDC.size()>0 || dnhitsTDC.size()>0){
-         TDCHitList &hitlistTDC = TDCHits[fADCId];
-
-         // The module, fADC layer, and fADC sector are encoded in fADCId
-         // (n.b. yes, these are the same methods used for extracting 
-         // similar quantities from the cellId.)
-         hitlistTDC.module = dBCALGeom->module(fADCId);
-         hitlistTDC.sumlayer = dBCALGeom->layer(fADCId);
-         hitlistTDC.sumsector = dBCALGeom->sector(fADCId);
-         
-         hitlistTDC.uphits = uphitsTDC;
-         hitlistTDC.dnhits = dnhitsTDC;
+	  int layer = ChannelLayer(chan);
+
+      for(int end = 0; end < 2; end++){
+         DBCALGeometry::End the_end = (end == bcal_index::kUp)? DBCALGeometry::End::kUpstream
+                                                             : DBCALGeometry::End::kDownstream;
+         for(unsigned int ii = 0; ii < bcalfADC.Nhits(chan, end); ii++){
+            // correct simulation efficiencies 
+            if (config->APPLY_EFFICIENCY_CORRECTIONS
+                  && !gDRandom.DecideToAcceptHit(bcal_config->GetEfficiencyCorrectionFactor(chan, the_end)))
+               continue;
+
+            // Fill fADC hits with energies (in MeV) and times when they cross an energy threshold.
+            // Also fill TDC hits with times if they are not layer 4 hits and cross threshold.
+            double E = bcalfADC.GetE(chan, end, ii);
+            double t = bcalfADC.Gett(chan, end, ii);
+            if(E > thresh_MeV && t < 2000) fADCHits.Add(chan, end, E, t);
+            if(layer != 4 && E > thresh_MeV_TDC && t < 2000) TDCHits.Add(chan, end, E, t);
+         }
       }
    }
 }
@@ -623,11 +392,11 @@ void BCALSmearer::FindHits(double thresh_MeV, map<int, SumHits> &bcalfADC, map<i
 //-----------
 // CopyBCALHitsToHDDM
 //-----------
-void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
-						map<int, TDCHitList> &TDCHits,
+void BCALSmearer::CopyBCALHitsToHDDM(BCALChannelHits &fADCHits,
+						BCALChannelHits &TDCHits,
                         hddm_s::HDDM *record)
 {
-   /// Loop over fADCHitList objects and copy the fADC hits into the HDDM tree.
+   /// Loop over the readout channels and copy the fADC and TDC hits into the HDDM tree.
    ///
    /// This will copy all of the hits found into the first physicsEvent found
    /// in the HDDM file. Note that the hits were formed from data that may
@@ -659,29 +428,30 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
    }
 
    // If we have no cells over threshold, then bail now.
-   if (fADCHits.size() == 0 && TDCHits.size() == 0)
+   if (fADCHits.Empty() && TDCHits.Empty())
       return;
    
    // Create bcalfADCHit structures to hold our fADC hits
-   map<int, fADCHitList>::iterator it;
-   for (it = fADCHits.begin(); it != fADCHits.end(); ++it) {
-      // Get pointer to our fADC cell information that needs to be copied to HDDM
-      fADCHitList &hitlist = it->second;
+   for (int chan = fADCHits.NextChannel(-1); chan >= 0; chan = fADCHits.NextChannel(chan)) {
+      // The module, fADC layer, and fADC sector are encoded in the channel number
+      int module = ChannelModule(chan);
+      int sumlayer = ChannelLayer(chan);
+      int sumsector = ChannelSector(chan);
       // Check if this cell is already present in the cells list
       cells = bcals().getBcalCells();
       for (iter = cells.begin(); iter != cells.end(); ++iter) {
-         if (iter->getModule() == it->second.module &&
-             iter->getSector() == it->second.sumsector &&
-             iter->getLayer() == it->second.sumlayer)
+         if (iter->getModule() == module &&
+             iter->getSector() == sumsector &&
+             iter->getLayer() == sumlayer)
          {
             break;
          }
       }
       if (iter == cells.end()) {
          iter = bcals().addBcalCells().begin();
-         iter->setModule(hitlist.module);
-         iter->setLayer(hitlist.sumlayer);
-         iter->setSector(hitlist.sumsector);
+         iter->setModule(module);
+         iter->setLayer(sumlayer);
+         iter->setSector(sumsector);
       }
       
       // Copy hits into BcalfADCDigiHit HDDM structure.
@@ -691,33 +461,33 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
       // fix the offset layer in the hit factories.  Also, any hit that still has a negative time
       // will be ignored.
 
-      for (unsigned int i = 0; i < hitlist.uphits.size(); i++) {
-      	int integer_time = round((hitlist.uphits[i].t-bcal_config->BCAL_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_ADC_COUNT);
+      for (unsigned int i = 0; i < fADCHits.Nhits(chan, bcal_index::kUp); i++) {
+      	int integer_time = round((fADCHits.Gett(chan, bcal_index::kUp, i)-bcal_config->BCAL_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_ADC_COUNT);
       	if (integer_time >= 0){
             hddm_s::BcalfADCDigiHitList fadcs = iter->addBcalfADCDigiHits();
             fadcs().setEnd(bcal_index::kUp);
-	    double integral = round(hitlist.uphits[i].E/bcal_config->BCAL_MEV_PER_ADC_COUNT);
-	    double pulse_peak = integral/bcal_config->integral_to_peak[0][hitlist.sumlayer-1];
+	    double integral = round(fADCHits.GetE(chan, bcal_index::kUp, i)/bcal_config->BCAL_MEV_PER_ADC_COUNT);
+	    double pulse_peak = integral/bcal_config->integral_to_peak[0][sumlayer-1];
 	    if (!bcal_config->NO_SIPM_SATURATION) {
 	      double integral_true = integral;
-	      // double pulse_peak_true = integral_true/bcal_config->integral_to_peak[0][hitlist.sumlayer-1];
-	      double Mpixels = bcal_config->sipm_npixels[0][hitlist.sumlayer-1];
-	      double Npixels_true = round(bcal_config->pixel_per_count[0][hitlist.sumlayer-1]*integral_true);
+	      // double pulse_peak_true = integral_true/bcal_config->integral_to_peak[0][sumlayer-1];
+	      double Mpixels = bcal_config->sipm_npixels[0][sumlayer-1];
+	      double Npixels_true = round(bcal_config->pixel_per_count[0][sumlayer-1]*integral_true);
 	      double Npixels_measured = round(Mpixels*(1-exp(-Npixels_true/Mpixels)));
-	      integral = round(Npixels_measured/bcal_config->pixel_per_count[0][hitlist.sumlayer-1]);
-	      pulse_peak = integral/bcal_config->integral_to_peak[0][hitlist.sumlayer-1];
-	      // cout << "End=0, Layer=" << hitlist.sumlayer << " Mpixels=" << Mpixels << " Npixels_true=" << Npixels_true << " Npixels_measured=" << Npixels_measured 
+	      integral = round(Npixels_measured/bcal_config->pixel_per_count[0][sumlayer-1]);
+	      pulse_peak = integral/bcal_config->integral_to_peak[0][sumlayer-1];
+	      // cout << "End=0, Layer=" << sumlayer << " Mpixels=" << Mpixels << " Npixels_true=" << Npixels_true << " Npixels_measured=" << Npixels_measured 
 	      //    << " pulse_peak=" << pulse_peak << " integral_true=" << integral_true << " integral=" << integral << endl;
 	    }
 	    if (pulse_peak > 4095) pulse_peak=4095;
 
 	    // fADC saturation based on waveforms from data
 	    if(!bcal_config->NO_FADC_SATURATION) { 
-		    if(integral > bcal_config->fADC_MinIntegral_Saturation[0][hitlist.sumlayer-1]) {
+		    if(integral > bcal_config->fADC_MinIntegral_Saturation[0][sumlayer-1]) {
 			    double y = integral; 
-			    double a = bcal_config->fADC_Saturation_Linear[0][hitlist.sumlayer-1];
-			    double b = bcal_config->fADC_Saturation_Quadratic[0][hitlist.sumlayer-1];
-			    double c = bcal_config->fADC_MinIntegral_Saturation[0][hitlist.sumlayer-1];
+			    double a = bcal_config->fADC_Saturation_Linear[0][sumlayer-1];
+			    double b = bcal_config->fADC_Saturation_Quadratic[0][sumlayer-1];
+			    double c = bcal_config->fADC_MinIntegral_Saturation[0][sumlayer-1];
 			    // "invert" saturation correction for MC
 			    integral = (1 - a*y + 2.*b*c*y - sqrt(1. - 2.*a*y + 4.*b*c*y + (a*a - 4.*b)*y*y))/(2.*b*y);
 			    pulse_peak = 4095;
@@ -729,33 +499,33 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
             fadcs().setPulse_time(integer_time);
         }
       }
-      for (unsigned int i = 0; i < hitlist.dnhits.size(); i++) {
-      	int integer_time = round((hitlist.dnhits[i].t-bcal_config->BCAL_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_ADC_COUNT);
+      for (unsigned int i = 0; i < fADCHits.Nhits(chan, bcal_index::kDown); i++) {
+      	int integer_time = round((fADCHits.Gett(chan, bcal_index::kDown, i)-bcal_config->BCAL_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_ADC_COUNT);
       	if (integer_time >= 0){
             hddm_s::BcalfADCDigiHitList fadcs = iter->addBcalfADCDigiHits();
             fadcs().setEnd(bcal_index::kDown);
-	    double integral = round(hitlist.dnhits[i].E/bcal_config->BCAL_MEV_PER_ADC_COUNT);
-	    double pulse_peak = integral/bcal_config->integral_to_peak[1][hitlist.sumlayer-1];
+	    double integral = round(fADCHits.GetE(chan, bcal_index::kDown, i)/bcal_config->BCAL_MEV_PER_ADC_COUNT);
+	    double pulse_peak = integral/bcal_config->integral_to_peak[1][sumlayer-1];
 	    if (!bcal_config->NO_SIPM_SATURATION) {
 	      double integral_true = integral;
-	      // double pulse_peak_true = integral_true/bcal_config->integral_to_peak[1][hitlist.sumlayer-1];
-	      double Mpixels = bcal_config->sipm_npixels[1][hitlist.sumlayer-1];
-	      double Npixels_true = round(bcal_config->pixel_per_count[1][hitlist.sumlayer-1]*integral_true);
+	      // double pulse_peak_true = integral_true/bcal_config->integral_to_peak[1][sumlayer-1];
+	      double Mpixels = bcal_config->sipm_npixels[1][sumlayer-1];
+	      double Npixels_true = round(bcal_config->pixel_per_count[1][sumlayer-1]*integral_true);
 	      double Npixels_measured = round(Mpixels*(1-exp(-Npixels_true/Mpixels)));
-	      integral = round(Npixels_measured/bcal_config->pixel_per_count[1][hitlist.sumlayer-1]);
-	      pulse_peak = integral/bcal_config->integral_to_peak[1][hitlist.sumlayer-1];
-	      // cout << "End=1, Layer=" << hitlist.sumlayer << " Mpixels=" << Mpixels << " Npixels_true=" << Npixels_true << " Npixels_measured=" << Npixels_measured 
+	      integral = round(Npixels_measured/bcal_config->pixel_per_count[1][sumlayer-1]);
+	      pulse_peak = integral/bcal_config->integral_to_peak[1][sumlayer-1];
+	      // cout << "End=1, Layer=" << sumlayer << " Mpixels=" << Mpixels << " Npixels_true=" << Npixels_true << " Npixels_measured=" << Npixels_measured 
               //    << " pulse_peak=" << pulse_peak << " integral_true=" << integral_true << " integral=" << integral << endl;
 	    }
 	    if (pulse_peak > 4095) pulse_peak=4095;
 	    
 	    // fADC saturation based on waveforms from data
 	    if(!bcal_config->NO_FADC_SATURATION) { 
-		    if(integral > bcal_config->fADC_MinIntegral_Saturation[1][hitlist.sumlayer-1]) {
+		    if(integral > bcal_config->fADC_MinIntegral_Saturation[1][sumlayer-1]) {
 			    double y = integral; 
-			    double a = bcal_config->fADC_Saturation_Linear[1][hitlist.sumlayer-1];
-			    double b = bcal_config->fADC_Saturation_Quadratic[1][hitlist.sumlayer-1];
-			    double c = bcal_config->fADC_MinIntegral_Saturation[1][hitlist.sumlayer-1];
+			    double a = bcal_config->fADC_Saturation_Linear[1][sumlayer-1];
+			    double b = bcal_config->fADC_Saturation_Quadratic[1][sumlayer-1];
+			    double c = bcal_config->fADC_MinIntegral_Saturation[1][sumlayer-1];
 			    // "invert" saturation correction for MC
 			    integral = (1 - a*y + 2.*b*c*y - sqrt(1. - 2.*a*y + 4.*b*c*y + (a*a - 4.*b)*y*y))/(2.*b*y);
 			    pulse_peak = 4095;
@@ -771,43 +541,43 @@ void BCALSmearer::CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
    }
    
    // Create bcalTDCDigiHit structures to hold our F1TDC hits
-   map<int, TDCHitList>::iterator ittdc;
-   for (ittdc = TDCHits.begin(); ittdc != TDCHits.end(); ittdc++) {
-      // Get pointer to our TDC hit information that needs to be copied to HDDM
-      TDCHitList &hitlist = ittdc->second;
+   for (int chan = TDCHits.NextChannel(-1); chan >= 0; chan = TDCHits.NextChannel(chan)) {
+      int module = ChannelModule(chan);
+      int sumlayer = ChannelLayer(chan);
+      int sumsector = ChannelSector(chan);
       // Check if this cell is already present in the cells list
       cells = bcals().getBcalCells();
       for (iter = cells.begin(); iter != cells.end(); ++iter) {
-         if (iter->getModule() == ittdc->second.module &&
-             iter->getSector() == ittdc->second.sumsector &&
-             iter->getLayer() == ittdc->second.sumlayer)
+         if (iter->getModule() == module &&
+             iter->getSector() == sumsector &&
+             iter->getLayer() == sumlayer)
          {
             break;
          }
       }
       if (iter == cells.end()) {
          iter = bcals().addBcalCells().begin();
-         iter->setModule(hitlist.module);
-         iter->setLayer(hitlist.sumlayer);
-         iter->setSector(hitlist.sumsector);
+         iter->setModule(module);
+         iter->setLayer(sumlayer);
+         iter->setSector(sumsector);
       }
       
       // Copy hits into BcalTDCDigiHit HDDM structure.
       // Times must be converted to units of TDC counts.
-      for (unsigned int i = 0; i < hitlist.uphits.size(); ++i) {
-         int integer_time = round((hitlist.uphits[i]-bcal_config->BCAL_TDC_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_TDC_COUNT);
+      for (unsigned int i = 0; i < TDCHits.Nhits(chan, bcal_index::kUp); ++i) {
+         int integer_time = round((TDCHits.Gett(chan, bcal_index::kUp, i)-bcal_config->BCAL_TDC_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_TDC_COUNT);
          if (integer_time >= 0){
             hddm_s::BcalTDCDigiHitList tdcs = iter->addBcalTDCDigiHits();
             tdcs().setEnd(bcal_index::kUp);
             tdcs().setTime(integer_time);
          }
       }
-      for (unsigned int i = 0; i < hitlist.dnhits.size(); i++) {
-         int integer_time = round((hitlist.dnhits[i]-bcal_config->BCAL_TDC_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_TDC_COUNT);
+      for (unsigned int i = 0; i < TDCHits.Nhits(chan, bcal_index::kDown); i++) {
+         int integer_time = round((TDCHits.Gett(chan, bcal_index::kDown, i)-bcal_config->BCAL_TDC_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_TDC_COUNT);
          if (integer_time >= 0){
             hddm_s::BcalTDCDigiHitList tdcs = iter->addBcalTDCDigiHits();
             tdcs().setEnd(bcal_index::kDown);
-            tdcs().setTime(round((hitlist.dnhits[i]-bcal_config->BCAL_TDC_BASE_TIME_OFFSET)/bcal_config->BCAL_NS_PER_TDC_COUNT));
+            tdcs().setTime(integer_time);
          }
       }
    }
@@ -11,6 +11,8 @@
 #include <sstream>
 #include <queue>
 #include <cmath>
+#include <algorithm>
+#include <stdint.h>
 using namespace std;
 
 #include <DHistogram.h>
@@ -23,6 +25,7 @@ using namespace std;
 #include <TDirectory.h>
 
 #include "Smearer.h"
+#include "BCALSiPMHits.h"
 
 class bcal_config_t 
 {
@@ -102,144 +105,7 @@ class bcal_config_t
 
 
 
-// utility classes
-
-//..........................
-// bcal_index is a utility class that encapsulates the
-// module, layer, sector, and end in a single object that
-// can be used as a key to index an STL map. 
-//..........................
-class bcal_index{
-   public:
-      enum EndType{
-         kUp,
-         kDown
-      };
-      
-      bcal_index(unsigned int module, unsigned int layer,
-                 unsigned int sector, unsigned int incident_id,
-                 EndType end)
-       : module(module),
-         layer(layer),
-         sector(sector),
-         incident_id(incident_id),
-         end(end)
-      {}
-   
-      unsigned int module;
-      unsigned int layer;
-      unsigned int sector;
-      unsigned int incident_id;
-      EndType end;
-      
-      bool operator<(const bcal_index &idx) const {
-         if (module < idx.module)
-            return true;
-         if (module > idx.module)
-            return false;
-         if (layer < idx.layer)
-            return true;
-         if (layer > idx.layer)
-            return false;
-         if (sector < idx.sector)
-            return true;
-         if (sector > idx.sector)
-            return false;
-         if (incident_id < idx.incident_id)
-            return true;
-         if (incident_id > idx.incident_id)
-            return false;
-         if ((end==kUp) && (idx.end==kDown))
-            return true;
-         return false;
-      }
-};
-
-//..........................
-// CellHits is a utility class that holds information
-// regarding the energy and time of depostions in a cell
-//..........................
-class CellHits{
-   public:
-      enum EndType{
-         kUp,
-         kDown
-      };
-
-      CellHits() : E(0.0), t(0.0)
-      {}
-      
-      double E;
-      double t;
-      double Etruth;
-      EndType end;
-};
-
-//..........................
-// SumHits is a utility class that is used to hold info
-// from the SiPMs contributing to that readout channel.
-// This includes a list of CellHits objects, but also
-// the total number of SiPMs that should be in the sum
-// and the total up/downstream energies and times.
-//..........................
-class SumHits{
-   public:
-      SumHits()
-      {}
-      
-      vector<CellHits *> cellhits;
-      vector<double> EUP;
-      vector<double> tUP;
-      vector<double> EDN;
-      vector<double> tDN;
-};
-
-//..........................
-// fADCHit is a utility class that is used to hold info
-// for a single fADC hit. 
-//..........................
-class fADCHit{
-   public:
-      fADCHit(double E, double t) : E(E), t(t)
-      {}
-      
-      double E;
-      double t;
-};
-
-//..........................
-// fADCHitList is a utility class that is used to hold info
-// for a set of fADCHit objects. 
-//..........................
-class fADCHitList{
-   public:
-      fADCHitList()
-      {}
-      
-      int module;
-      int sumlayer;
-      int sumsector;
-      
-      vector<fADCHit> uphits;
-      vector<fADCHit> dnhits;
-};
-
-//..........................
-// TDCHitList is a utility class that is used to hold info
-// for a single F1TDC hit
-//..........................
-class TDCHitList{
-   public:
-      TDCHitList()
-      {}
-      
-      int module;
-      int sumlayer;
-      int sumsector;
-      
-      vector<double> uphits;
-      vector<double> dnhits;
-};
+// utility classes (the SiPM and readout channel hit lists are in BCALSiPMHits.h)
 
 //..........................
 // IncidentParticle_t is a utility class for holding the
@@ -297,27 +163,34 @@ class BCALSmearer : public Smearer
         const DBCALGeometry *dBCALGeom;
 		
 		int inline GetCalibIndex(int module, int layer, int sector);
+		int inline GetNumChannels() {
+			return bcal_config->BCAL_NUM_MODULES*bcal_config->BCAL_NUM_LAYERS*bcal_config->BCAL_NUM_SECTORS;
+		}
+		int inline ChannelModule(int chan) {
+			return chan/(bcal_config->BCAL_NUM_LAYERS*bcal_config->BCAL_NUM_SECTORS) + 1;
+		}
+		int inline ChannelLayer(int chan) {
+			return (chan/bcal_config->BCAL_NUM_SECTORS)%bcal_config->BCAL_NUM_LAYERS + 1;
+		}
+		int inline ChannelSector(int chan) {
+			return chan%bcal_config->BCAL_NUM_SECTORS + 1;
+		}
 
 		void GetSiPMHits(hddm_s::HDDM *record,
-        	             map<bcal_index, CellHits> &SiPMHits,
+        	             vector<SiPMHit> &SiPMHits,
               	         vector<IncidentParticle_t> &incident_particles);
-		void ApplySamplingFluctuations(map<bcal_index,
-           		                       CellHits> &SiPMHits,
+		void ApplySamplingFluctuations(vector<SiPMHit> &SiPMHits,
                    		               vector<IncidentParticle_t> &incident_particles);
-		void MergeHits(map<bcal_index, CellHits> &SiPMHits, double Resolution);
-		void ApplyPoissonStatistics(map<bcal_index, CellHits> &SiPMHits);
-		void SortSiPMHits(map<bcal_index,
-        	              CellHits> &SiPMHits,
-             	          map<int, SumHits> &bcalfADC, double Resolution);
-		void SimpleDarkHitsSmear(map<int, SumHits> &bcalfADC);
-		void ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, map<int, fADCHitList> &fADCHits, 
-							   map<int, TDCHitList> &TDCHits);
+		void ApplyPoissonStatistics(vector<SiPMHit> &SiPMHits);
+		void SimpleDarkHitsSmear(BCALChannelHits &bcalfADC);
+		void ApplyTimeSmearing(double sigma_ns, double sigma_ns_TDC, BCALChannelHits &fADCHits, 
+							   BCALChannelHits &TDCHits);
 		void FindHits(double thresh_MeV,
-              		  map<int, SumHits> &bcalfADC,
-              		  map<int, fADCHitList> &fADCHits,
-              		  map<int, TDCHitList> &TDCHits);
-		void CopyBCALHitsToHDDM(map<int, fADCHitList> &fADCHits,
-                        		map<int, TDCHitList> &TDCHits,
+              		  BCALChannelHits &bcalfADC,
+              		  BCALChannelHits &fADCHits,
+              		  BCALChannelHits &TDCHits);
+		void CopyBCALHitsToHDDM(BCALChannelHits &fADCHits,
+                        		BCALChannelHits &TDCHits,
                         		hddm_s::HDDM *record);
 		
 };
@@ -0,0 +1,285 @@
+// Source of background (noise) events to be merged into mcsmear events
+//
+// See BackgroundEventPool.h for a description.
+
+#include "BackgroundEventPool.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+using namespace std;
+
+
+//-----------
+// BackgroundEventPool (constructor)
+//-----------
+BackgroundEventPool::BackgroundEventPool(hddm_s::istream *in_istr,
+                                         hddm_s::streamposition in_start,
+                                         double in_weight)
+{
+	istr = in_istr;
+	start = in_start;
+	weight = in_weight;
+	stride = (weight > 1.0)? (uint64_t)ceil(weight) : 1;
+	cached = false;
+	queue_size = 1;
+	window_first = 0;
+	furthest = 0;
+	running = false;
+	stopping = false;
+	failed = false;
+	Nreread = 0;
+	first_pass = 0;
+	wrapped = false;
+	cycle_known = false;
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_mutex_init(&istr_mutex, NULL);
+	pthread_cond_init(&cond_filled, NULL);
+	pthread_cond_init(&cond_wanted, NULL);
+}
+
+//-----------
+// BackgroundEventPool (destructor)
+//-----------
+BackgroundEventPool::~BackgroundEventPool()
+{
+	Stop();
+	for (size_t i=0; i < cache.size(); ++i)
+		delete cache[i];
+	window.clear();
+	pthread_cond_destroy(&cond_wanted);
+	pthread_cond_destroy(&cond_filled);
+	pthread_mutex_destroy(&istr_mutex);
+	pthread_mutex_destroy(&mutex);
+}
+
+//-----------
+// Start
+//-----------
+void BackgroundEventPool::Start(int skip, unsigned int in_queue_size,
+                                unsigned int max_cached)
+{
+	queue_size = (in_queue_size > 0)? in_queue_size : 1;
+
+	istr->setPosition(start);
+	istr->skip(skip);
+
+	// Try to hold the whole sample in memory. The skipped events
+	// are not part of the sample, matching what the reader thread
+	// would hand out before its first restart.
+	while (cache.size() < max_cached) {
+		hddm_s::streamposition pos = istr->getPosition();
+		hddm_s::HDDM *record = new hddm_s::HDDM();
+		if (!(*istr >> *record)) {
+			delete record;
+			break;
+		}
+		cache.push_back(record);
+		positions.push_back(pos);
+	}
+	if (cache.size() > 0 && cache.size() < max_cached) {
+		cached = true;
+		positions.clear();
+		return;
+	}
+
+	// Too big (or caching disabled): stream it instead, starting
+	// with the events already read.
+	for (size_t i=0; i < cache.size(); ++i)
+		window.push_back(std::shared_ptr<hddm_s::HDDM>(cache[i]));
+	cache.clear();
+
+	if (window.empty()) {
+		hddm_s::HDDM *record = new hddm_s::HDDM();
+		if (!ReadNext(*record)) {
+			cerr << "Trying to merge from empty input file, "
+			     << "cannot continue!" << endl;
+			exit(-1);
+		}
+		window.push_back(std::shared_ptr<hddm_s::HDDM>(record));
+	}
+
+	running = (pthread_create(&thread, NULL, ReaderThread, this) == 0);
+	if (!running) {
+		cerr << "BackgroundEventPool: unable to start reader thread, "
+		     << "cannot continue!" << endl;
+		exit(-1);
+	}
+}
+
+//-----------
+// Get
+//-----------
+void BackgroundEventPool::Get(uint64_t seqno, int i, hddm_s::HDDM &record)
+{
+	if (cached) {
+		// splitmix64 of (event, i) picks the event from the sample
+		uint64_t z = (seqno << 16) + i + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= (z >> 31);
+		record = *cache[z % cache.size()];
+		return;
+	}
+
+	uint64_t index = seqno*stride + i;
+
+	pthread_mutex_lock(&mutex);
+	if (index > furthest) {
+		furthest = index;
+		pthread_cond_signal(&cond_wanted);
+	}
+	while (index >= window_first + window.size() && !failed)
+		pthread_cond_wait(&cond_filled, &mutex);
+	if (index >= window_first + window.size()) {
+		pthread_mutex_unlock(&mutex);
+		cerr << "Trying to merge from empty input file, "
+		     << "cannot continue!" << endl;
+		exit(-1);
+	}
+	std::shared_ptr<hddm_s::HDDM> found;
+	if (index >= window_first)
+		found = window[index - window_first];
+	else
+		++Nreread;
+	pthread_mutex_unlock(&mutex);
+
+	if (found) {
+		record = *found;
+		return;
+	}
+
+	// Already dropped from the window: read it again from the file,
+	// then put the reader back where it was
+	pthread_mutex_lock(&istr_mutex);
+	hddm_s::streamposition pos;
+	bool ok = FindPosition(index, pos);
+	if (ok) {
+		hddm_s::streamposition resume = istr->getPosition();
+		istr->setPosition(pos);
+		if (!(*istr >> record))
+			ok = false;
+		istr->setPosition(resume);
+	}
+	pthread_mutex_unlock(&istr_mutex);
+	if (!ok) {
+		cerr << "BackgroundEventPool: unable to read background event "
+		     << index << " again, cannot continue!" << endl;
+		exit(-1);
+	}
+}
+
+//-----------
+// ReadNext
+//-----------
+bool BackgroundEventPool::ReadNext(hddm_s::HDDM &record)
+{
+	/// Read the next record, starting over at the beginning
+	/// of the file when the end is reached, and remember where
+	/// it was. Must be called with istr_mutex held, except
+	/// before the reader thread is started.
+	hddm_s::streamposition pos = istr->getPosition();
+	if (!(*istr >> record)) {
+		if (!wrapped) {
+			first_pass = positions.size();
+			wrapped = true;
+		}
+		else {
+			cycle_known = true;
+		}
+		istr->setPosition(start);
+		pos = istr->getPosition();
+		if (!(*istr >> record))
+			return false;
+	}
+	if (!cycle_known)
+		positions.push_back(pos);
+	return true;
+}
+
+//-----------
+// FindPosition
+//-----------
+bool BackgroundEventPool::FindPosition(uint64_t index, hddm_s::streamposition &pos)
+{
+	/// Position in the file of record number "index" of the
+	/// stream. Must be called with istr_mutex held.
+	if (index < positions.size()) {
+		pos = positions[index];
+		return true;
+	}
+	if (cycle_known && positions.size() > first_pass) {
+		uint64_t cycle = positions.size() - first_pass;
+		pos = positions[first_pass + (index - first_pass) % cycle];
+		return true;
+	}
+	return false;
+}
+
+//-----------
+// ReaderThread
+//-----------
+void *BackgroundEventPool::ReaderThread(void *arg)
+{
+	static_cast<BackgroundEventPool*>(arg)->Run();
+	return NULL;
+}
+
+//-----------
+// Run
+//-----------
+void BackgroundEventPool::Run(void)
+{
+	while (true) {
+		pthread_mutex_lock(&mutex);
+		while (window_first + window.size() > furthest + queue_size && !stopping)
+			pthread_cond_wait(&cond_wanted, &mutex);
+		if (stopping) {
+			pthread_mutex_unlock(&mutex);
+			return;
+		}
+		pthread_mutex_unlock(&mutex);
+
+		// decode outside the window lock
+		hddm_s::HDDM *record = new hddm_s::HDDM();
+		pthread_mutex_lock(&istr_mutex);
+		bool ok = ReadNext(*record);
+		pthread_mutex_unlock(&istr_mutex);
+
+		pthread_mutex_lock(&mutex);
+		if (ok) {
+			window.push_back(std::shared_ptr<hddm_s::HDDM>(record));
+
+			// keep queue_size records behind the furthest one asked
+			// for, for events that are still being processed
+			while (window_first + queue_size < furthest && !window.empty()) {
+				window.pop_front();
+				++window_first;
+			}
+		}
+		else {
+			delete record;
+			failed = true;
+		}
+		pthread_cond_broadcast(&cond_filled);
+		pthread_mutex_unlock(&mutex);
+		if (!ok)
+			return;
+	}
+}
+
+//-----------
+// Stop
+//-----------
+void BackgroundEventPool::Stop(void)
+{
+	if (!running)
+		return;
+	pthread_mutex_lock(&mutex);
+	stopping = true;
+	pthread_cond_broadcast(&cond_wanted);
+	pthread_mutex_unlock(&mutex);
+	pthread_join(thread, NULL);
+	running = false;
+}
@@ -0,0 +1,98 @@
+// Source of background (noise) events to be merged into mcsmear events
+//
+// One pool is created for each noise file given on the command line.
+// Which background events go into which signal event is fixed by the
+// signal event's input sequence number (see DEventSourceHDDMSequenced),
+// so the output does not depend on how many threads are running or in
+// what order they finish their events.
+//
+// If the whole noise sample fits within the cache limit, it is read
+// into memory once and the background events for a signal event are
+// chosen by hashing its sequence number.
+//
+// Otherwise the file is streamed. Its records, read in order and
+// starting over at the beginning whenever the end of the file is
+// reached, are numbered 0, 1, 2, ... and signal event s is given
+// records s*n, s*n+1, ..., where n is the pileup factor rounded up.
+// With a Poisson pileup factor an event that draws more than n
+// background events shares the extra ones with the next signal event.
+// A reader thread decodes records ahead of the furthest one asked for
+// and keeps as many behind it for events that are still running.
+// A record that has already been dropped from memory is read again
+// from its position in the file.
+
+#ifndef _BACKGROUNDEVENTPOOL_H_
+#define _BACKGROUNDEVENTPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <HDDM/hddm_s.hpp>
+
+class BackgroundEventPool
+{
+  public:
+	BackgroundEventPool(hddm_s::istream *in_istr, hddm_s::streamposition in_start,
+	                    double in_weight);
+	~BackgroundEventPool();
+
+	// Position the file after "skip" events and start filling the
+	// pool. Up to max_cached events are kept in memory if the file
+	// is that short, otherwise up to queue_size events are decoded
+	// ahead by the reader thread.
+	void Start(int skip, unsigned int queue_size, unsigned int max_cached);
+
+	// Copy the i'th background event for the signal event with the
+	// given input sequence number into record
+	void Get(uint64_t seqno, int i, hddm_s::HDDM &record);
+
+	double GetWeight(void) const { return weight; }
+	bool IsCached(void) const { return cached; }
+	size_t GetNcached(void) const { return cache.size(); }
+	unsigned long GetNreread(void) const { return Nreread; }
+
+  private:
+	static void *ReaderThread(void *arg);
+	void Run(void);
+	bool ReadNext(hddm_s::HDDM &record);
+	bool FindPosition(uint64_t index, hddm_s::streamposition &pos);
+	void Stop(void);
+
+	hddm_s::istream *istr;   // not owned
+	hddm_s::streamposition start;
+	double weight;
+	uint64_t stride;         // records set aside for each signal event
+
+	bool cached;
+	std::vector<hddm_s::HDDM*> cache;
+
+	// streaming mode: records window_first, window_first+1, ...
+	// of the file read over and over
+	unsigned int queue_size;
+	std::deque<std::shared_ptr<hddm_s::HDDM> > window;
+	uint64_t window_first;
+	uint64_t furthest;       // highest record index asked for so far
+	bool running;
+	bool stopping;
+	bool failed;
+	unsigned long Nreread;
+
+	// file positions of the records read so far, for reading one
+	// again: first the records after the skipped ones, then, once
+	// the file has started over, all of them once
+	std::vector<hddm_s::streamposition> positions;
+	uint64_t first_pass;     // records before the first restart
+	bool wrapped;
+	bool cycle_known;
+
+	pthread_mutex_t mutex;       // guards the window
+	pthread_mutex_t istr_mutex;  // guards istr and positions
+	pthread_cond_t cond_filled;
+	pthread_cond_t cond_wanted;
+	pthread_t thread;
+};
+
+#endif // _BACKGROUNDEVENTPOOL_H_
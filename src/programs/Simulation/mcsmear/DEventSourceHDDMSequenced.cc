@@ -0,0 +1,67 @@
+// HDDM event source for mcsmear that numbers records as they are read
+//
+// See DEventSourceHDDMSequenced.h for a description.
+
+#include "DEventSourceHDDMSequenced.h"
+
+using namespace jana;
+
+uint64_t DEventSourceHDDMSequenced::Nread = 0;
+
+//-----------
+// DEventSourceHDDMSequenced (constructor)
+//-----------
+DEventSourceHDDMSequenced::DEventSourceHDDMSequenced(const char *source_name)
+ : DEventSourceHDDM(source_name)
+{
+	pthread_mutex_init(&sequence_mutex, NULL);
+}
+
+//-----------
+// DEventSourceHDDMSequenced (destructor)
+//-----------
+DEventSourceHDDMSequenced::~DEventSourceHDDMSequenced()
+{
+	pthread_mutex_destroy(&sequence_mutex);
+}
+
+//-----------
+// GetEvent
+//-----------
+jerror_t DEventSourceHDDMSequenced::GetEvent(JEvent &event)
+{
+	/// JANA reads events one at a time, so numbering them here
+	/// follows the order of the input files.
+	jerror_t err = DEventSourceHDDM::GetEvent(event);
+	if (err == NOERROR && event.GetRef() != NULL) {
+		pthread_mutex_lock(&sequence_mutex);
+		sequence[event.GetRef()] = Nread++;
+		pthread_mutex_unlock(&sequence_mutex);
+	}
+	return err;
+}
+
+//-----------
+// FreeEvent
+//-----------
+void DEventSourceHDDMSequenced::FreeEvent(JEvent &event)
+{
+	pthread_mutex_lock(&sequence_mutex);
+	sequence.erase(event.GetRef());
+	pthread_mutex_unlock(&sequence_mutex);
+	DEventSourceHDDM::FreeEvent(event);
+}
+
+//-----------
+// GetSequenceNumber
+//-----------
+bool DEventSourceHDDMSequenced::GetSequenceNumber(const void *record, uint64_t &seqno)
+{
+	pthread_mutex_lock(&sequence_mutex);
+	std::map<const void*, uint64_t>::iterator iter = sequence.find(record);
+	bool found = (iter != sequence.end());
+	if (found)
+		seqno = iter->second;
+	pthread_mutex_unlock(&sequence_mutex);
+	return found;
+}
@@ -0,0 +1,67 @@
+// HDDM event source for mcsmear that numbers records as they are read
+//
+// JANA hands events to the processing threads in the order they are
+// read, but the threads finish them in any order, and the physics
+// event numbers in the records need not be increasing (concatenated
+// hdgeant files, several runs in one file). This source gives every
+// record a sequence number when it is read, counting across all input
+// files, so that MyProcessor can restore the input order on output
+// and key anything that has to be reproducible on the input position.
+
+#ifndef _DEVENTSOURCEHDDMSEQUENCED_H_
+#define _DEVENTSOURCEHDDMSEQUENCED_H_
+
+#include <map>
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <JANA/JEvent.h>
+#include <JANA/JEventSourceGenerator.h>
+#include <HDDM/DEventSourceHDDM.h>
+#include <HDDM/DEventSourceHDDMGenerator.h>
+
+class DEventSourceHDDMSequenced: public DEventSourceHDDM
+{
+	public:
+		DEventSourceHDDMSequenced(const char *source_name);
+		virtual ~DEventSourceHDDMSequenced();
+		virtual const char* className(void){return static_className();}
+		static const char* static_className(void){return "DEventSourceHDDMSequenced";}
+
+		jerror_t GetEvent(jana::JEvent &event);
+		void FreeEvent(jana::JEvent &event);
+
+		// Position of the record in the input, counting from 0 over
+		// all input files. Returns false for a record not read here.
+		bool GetSequenceNumber(const void *record, uint64_t &seqno);
+
+	private:
+		std::map<const void*, uint64_t> sequence;   // records in flight
+		pthread_mutex_t sequence_mutex;
+
+		static uint64_t Nread;   // shared by the sources of all input files
+};
+
+// Makes sure mcsmear reads its input through DEventSourceHDDMSequenced:
+// it accepts whatever DEventSourceHDDMGenerator accepts, with a higher
+// likelihood so that it is chosen over the stock HDDM source.
+class JEventSourceGenerator_SequencedHDDM: public jana::JEventSourceGenerator
+{
+	public:
+		virtual ~JEventSourceGenerator_SequencedHDDM(){}
+		const char* Description(void){return "HDDM input numbered in read order (mcsmear)";}
+
+		double CheckOpenable(std::string source){
+			return (hddm_generator.CheckOpenable(source) > 0.0)? 1.0 : 0.0;
+		}
+
+		jana::JEventSource* MakeJEventSource(std::string source){
+			return new DEventSourceHDDMSequenced(source.c_str());
+		}
+
+	private:
+		DEventSourceHDDMGenerator hddm_generator;
+};
+
+#endif // _DEVENTSOURCEHDDMSEQUENCED_H_
@@ -13,12 +13,20 @@
 // the class with no methods to access/set them, we derive
 // a new class, DRandom2 from TRandom2. This allows us access
 // to the numbers for easy recording/retrieving. 
+//
+// The generator is thread_local so that each JANA thread owns
+// an independent stream. Every event reseeds it from the HDDM
+// Random record, or from SetSeedsFromCounter() when the seeds
+// in the file are ignored, so that the random sequence seen by
+// an event depends only on (seed key, run, event) and not on
+// which thread processes it or in what order.
 
 #ifndef _DRANDOM2_H_
 #define _DRANDOM2_H_
 
 #include <TRandom2.h>
 #include <iostream>
+#include <stdint.h>
 using std::cerr;
 using std::endl;
 
@@ -59,6 +67,28 @@ class DRandom2:public TRandom2{
 			this->fSeed2 = seed2;		
 		}
 		
+		// Derive the three TRandom2 seeds for one event from a fixed
+		// key and the (run, event) counter. The mixing is a stateless
+		// function of its inputs (splitmix64 finalizer), so any thread
+		// can position its generator at the start of any event.
+		void SetSeedsFromCounter(const UInt_t key[3], uint64_t run, uint64_t event){
+			uint64_t ctr = (run << 40) ^ event;
+			UInt_t seeds[3];
+			for (int i=0; i<3; i++) {
+				uint64_t z = ctr + (uint64_t(key[i]) << 32) + 0x9E3779B97F4A7C15ULL*(i+1);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				z ^= (z >> 31);
+				seeds[i] = (UInt_t)(z >> 32);
+			}
+			
+			// keep clear of the forbidden low values (see SetSeeds)
+			if (seeds[0] < 2)  seeds[0] += 2;
+			if (seeds[1] < 8)  seeds[1] += 8;
+			if (seeds[2] < 16) seeds[2] += 16;
+			SetSeeds(seeds[0], seeds[1], seeds[2]);
+		}
+		
 		// legacy mcsmear interface
 		inline double SampleGaussian(double sigma) {
 			return Gaus(0.0, sigma);
@@ -145,6 +175,6 @@ class DRandom2:public TRandom2{
 
 #endif  // _DRANDOM2_H_
 
-extern DRandom2 gDRandom;
+extern thread_local DRandom2 gDRandom;
 
 
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <vector>
 #include <map>
+#include <chrono>
 
 using namespace std;
 
@@ -18,7 +19,7 @@ using namespace std;
 
 #include <JANA/JEvent.h>
 
-#include <HDDM/DEventSourceHDDM.h>
+#include "DEventSourceHDDMSequenced.h"
 #include <JANA/JGeometryXML.h>
 #include <TRACKING/DMCThrown.h>
 #include <DRandom2.h>
@@ -34,6 +35,7 @@ static pthread_mutex_t input_file_mutex;
 static pthread_t input_file_mutex_last_owner;
 
 #include <JANA/JCalibration.h>
+#include <CALIB_SNAPSHOT/JCalibrationSnapshot.h>
 //static JCalibration *jcalib=NULL;
 static bool locCheckCCDBContext = true;
 
@@ -131,6 +133,35 @@ jerror_t MyProcessor::init(void)
       jout << " HDDM integrity checks disabled" << std::endl;
    }
 
+   // Records are written by a separate thread that restores the
+   // order in which events were read. The window must exceed the number of events
+   // in flight across all processing threads.
+   OUTPUT_REORDER_WINDOW = 64;
+   gPARMS->SetDefaultParameter("MCSMEAR:OUTPUT_REORDER_WINDOW",
+                                OUTPUT_REORDER_WINDOW,
+                          "Number of smeared events buffered to restore input"
+                          " order before they are written to the output file");
+   writer = new OrderedHDDMWriter(fout, OUTPUT_REORDER_WINDOW);
+
+   // Background events to merge are decoded ahead of time by one
+   // reader thread per noise file, or held in memory if they fit.
+   BACKGROUND_QUEUE_SIZE = 100;
+   gPARMS->SetDefaultParameter("MCSMEAR:BACKGROUND_QUEUE_SIZE",
+                                BACKGROUND_QUEUE_SIZE,
+                          "Number of background events decoded ahead for"
+                          " each noise file being merged, and kept behind"
+                          " for events still being processed");
+   BACKGROUND_CACHE_EVENTS = 0;
+   gPARMS->SetDefaultParameter("MCSMEAR:BACKGROUND_CACHE_EVENTS",
+                                BACKGROUND_CACHE_EVENTS,
+                          "Keep a noise file in memory if it has fewer than"
+                          " this many events (0=always stream from disk)");
+
+   CALIB_SNAPSHOT_LIST = "";
+   gPARMS->SetDefaultParameter("CALIB:SNAPSHOT_LIST", CALIB_SNAPSHOT_LIST,
+                          "Append the names of the calibration tables used to"
+                          " this file, for making a snapshot with calib_snapshot");
+
    // We set the mutex type to "ERRORCHECK" so that if the
    // signal handler is called, we can unlock the mutex
    // safely whether we have it locked or not.
@@ -162,6 +193,8 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
     // Note that for now, we only print a warning and do not exit immediately.
     // It might be advisable to apply some tougher love.
 
+    std::chrono::steady_clock::time_point calib_start = std::chrono::steady_clock::now();
+
     if(locCheckCCDBContext) {
         // only do this once
         locCheckCCDBContext = false;        
@@ -200,6 +233,13 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
 		delete smearer;
 	smearer = new Smear(config, loop, config->DETECTORS_TO_LOAD);
 
+	// Most of the time above goes into reading calibration constants,
+	// report it so that the database and a snapshot can be compared
+	std::chrono::duration<double> calib_elapsed = std::chrono::steady_clock::now() - calib_start;
+	calib = dynamic_cast<DApplication*>(japp)->GetJCalibration(locRunNumber);
+	jout << " Calibrations for run " << locRunNumber << " loaded in "
+	     << calib_elapsed.count() << " s from " << calib->GetURL() << endl;
+
 #ifdef HAVE_RCDB
 	// Pull configuration parameters from RCDB
 	bool haveRCDBConfigFile = false;
@@ -438,20 +478,22 @@ jerror_t MyProcessor::brun(JEventLoop *loop, int locRunNumber)
 #endif  // HAVE_RCDB
 
     // fast forward any merger input files over skipped events
-    std::map<hddm_s::istream*,hddm_s::streamposition>::iterator iter;
-    for (iter = start2merge.begin(); iter != start2merge.end(); ++iter) {
-        hddm_s::HDDM record2;
-
-        iter->first->setPosition(start2merge.at(iter->first));
-        iter->first->skip(skip2merge[iter->first]);
-          
-		if (!(*iter->first >> record2)) {
-			std::cerr << "Trying to merge from empty input file, "
-					  << "cannot continue!" << std::endl;
-			exit(-1);
-		}
-
-        skip2merge[iter->first] = 0;
+    // and start reading background events ahead
+    if (bg_pools.empty()) {
+        std::map<hddm_s::istream*,double>::iterator iter;
+        for (iter = files2merge.begin(); iter != files2merge.end(); ++iter) {
+            BackgroundEventPool *pool = new BackgroundEventPool(iter->first,
+                                          start2merge.at(iter->first), iter->second);
+            pool->Start(skip2merge[iter->first], BACKGROUND_QUEUE_SIZE,
+                        BACKGROUND_CACHE_EVENTS);
+            if (pool->IsCached())
+                jout << " Holding " << pool->GetNcached()
+                     << " background events in memory" << endl;
+            else
+                jout << " Streaming background events from disk" << endl;
+            skip2merge[iter->first] = 0;
+            bg_pools.push_back(pool);
+        }
     }
 
     return NOERROR;
@@ -464,7 +506,7 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
 {
    JEvent& event = loop->GetJEvent();
    JEventSource *source = event.GetJEventSource();
-   DEventSourceHDDM *hddm_source = dynamic_cast<DEventSourceHDDM*>(source);
+   DEventSourceHDDMSequenced *hddm_source = dynamic_cast<DEventSourceHDDMSequenced*>(source);
    if (!hddm_source) {
       cerr << " This program MUST be used with an HDDM file as input!" << endl;
       exit(-1);
@@ -472,6 +514,15 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
    hddm_s::HDDM *record = (hddm_s::HDDM*)event.GetRef();
    if (!record)
       return NOERROR;
+
+   // Position of this event in the input, which unlike the physics
+   // event number always increases
+   uint64_t seqno;
+   if (!hddm_source->GetSequenceNumber(record, seqno)) {
+      cerr << " Event " << eventnumber << " has no input sequence number,"
+           << " cannot continue!" << endl;
+      exit(-1);
+   }
  
    // Handle geometry records
    hddm_s::GeometryList geom = record->getGeometrys();
@@ -488,53 +539,64 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
    }
    
    // Smear values
-   smearer->SmearEvent(record);
+   smearer->SmearEvent(record, seqno);
 
    // Load any external events to be merged during smearing
-   std::map<hddm_s::istream*,double>::iterator iter;
-   for (iter = files2merge.begin(); iter != files2merge.end(); ++ iter) {
-      int count = iter->second;
-      if (count != iter->second) {
-         count = gDRandom.Poisson(iter->second);
+   std::vector<hddm_s::HDDM*> bg_records;
+   std::vector<double> bg_t_shifts_ns;
+   for (size_t ipool=0; ipool < bg_pools.size(); ++ipool) {
+      double weight = bg_pools[ipool]->GetWeight();
+      int count = weight;
+      if (count != weight) {
+         count = gDRandom.Poisson(weight);
       }
       for (int i=0; i < count; ++i) {
-         hddm_s::HDDM record2;
-         if (!(*iter->first >> record2)) {
-            //pthread_mutex_lock(&input_file_mutex);
-            //input_file_mutex_last_owner = pthread_self();
-            iter->first->setPosition(start2merge.at(iter->first));
-            if (!(*iter->first >> record2)) {
-               //pthread_mutex_unlock(&input_file_mutex);
-               std::cerr << "Trying to merge from empty input file, "
-                         << "cannot continue!" << std::endl;
-               exit(-1);
-            }
-            //pthread_mutex_unlock(&input_file_mutex);
-         }
+         hddm_s::HDDM *record2 = new hddm_s::HDDM();
+         bg_pools[ipool]->Get(seqno, i, *record2);
          
-         if(config->MERGE_TAGGER_HITS == false) {
-         	hddm_s_merger::set_tag_merging(false);
-         }
-         hddm_s_merger::set_t_shift_ns(0);
-         hddm_s::RFsubsystemList RFtimes = record2.getRFsubsystems();
+         double t_shift_ns = 0;
+         hddm_s::RFsubsystemList RFtimes = record2->getRFsubsystems();
          hddm_s::RFsubsystemList::iterator RFiter;
          for (RFiter = RFtimes.begin(); RFiter != RFtimes.end(); ++RFiter)
             if (RFiter->getJtag() == "TAGH")
-               hddm_s_merger::set_t_shift_ns(-RFiter->getTsync());
-         *record += record2;
+               t_shift_ns = -RFiter->getTsync();
+         bg_records.push_back(record2);
+         bg_t_shifts_ns.push_back(t_shift_ns);
       }
    }
 
+   // Merge them all into the event, in one pass unless asked to merge
+   // them one at a time
+   if (bg_records.size() > 0) {
+      if(config->MERGE_TAGGER_HITS == false) {
+      	hddm_s_merger::set_tag_merging(false);
+      }
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if (config->MERGE_PAIRWISE) {
+         for (size_t i=0; i < bg_records.size(); ++i) {
+            hddm_s_merger::set_t_shift_ns(bg_t_shifts_ns[i]);
+            *record += *bg_records[i];
+         }
+      }
+      else {
+         hddm_s_merger::merge_records(*record, bg_records, bg_t_shifts_ns);
+      }
+      std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+      merge_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      Nbackground_merged += bg_records.size();
+      for (size_t i=0; i < bg_records.size(); ++i)
+         delete bg_records[i];
+   }
+
    // Apply DAQ truncation to hit lists
    if (config->APPLY_HITS_TRUNCATION)
       hddm_s_merger::truncate_hits(*record);
 
-   // Write event to output file
-   //pthread_mutex_lock(&output_file_mutex);
-   //output_file_mutex_last_owner = pthread_self();
-   *fout << *record;
-   Nevents_written++;
-   //pthread_mutex_unlock(&output_file_mutex);
+   // Hand a copy of the event to the output thread. The original
+   // record belongs to the event source and is freed after evnt.
+   hddm_s::HDDM *output_record = new hddm_s::HDDM();
+   *output_record = *record;
+   writer->Write(seqno, output_record);
 
    return NOERROR;
 }
@@ -544,6 +606,20 @@ jerror_t MyProcessor::evnt(JEventLoop *loop, uint64_t eventnumber)
 //------------------------------------------------------------------
 jerror_t MyProcessor::fini(void)
 {
+   for (size_t ipool=0; ipool < bg_pools.size(); ++ipool) {
+      if (bg_pools[ipool]->GetNreread() > 0)
+         cout << " " << bg_pools[ipool]->GetNreread() << " background events"
+              << " had to be read again from disk; consider increasing"
+              << " MCSMEAR:BACKGROUND_QUEUE_SIZE" << endl;
+      delete bg_pools[ipool];
+   }
+   bg_pools.clear();
+   if (writer) {
+      writer->Close();
+      Nevents_written = writer->GetNwritten();
+      delete writer;
+      writer = NULL;
+   }
    if (fout)
       delete fout;
    if (ofs) {
@@ -552,6 +628,17 @@ jerror_t MyProcessor::fini(void)
    }
    cout << " " << Nevents_written << " event written to " << OUTFILENAME
         << endl;
+   if (Nbackground_merged > 0) {
+      cout << " " << Nbackground_merged << " background events merged in "
+           << merge_time_ns * 1e-9 << " s"
+           << (config->MERGE_PAIRWISE ? " (one at a time)" : "") << endl;
+   }
+   if (calib && CALIB_SNAPSHOT_LIST.size() > 0) {
+      if (WriteCalibAccessList(calib, CALIB_SNAPSHOT_LIST))
+         cout << " Calibration tables used were added to " << CALIB_SNAPSHOT_LIST << endl;
+      else
+         cerr << " Unable to write " << CALIB_SNAPSHOT_LIST << endl;
+   }
    
    return NOERROR;
 }
@@ -10,9 +10,11 @@
 #define _MYPROCESSOR_H_
 
 #include <string>
+#include <atomic>
 
 #include <JANA/JEventProcessor.h>
 #include <JANA/JEventLoop.h>
+#include <JANA/JCalibration.h>
 using namespace jana;
 
 #include <fstream>
@@ -20,6 +22,8 @@ using namespace jana;
 
 #include "smear.h"
 #include "mcsmear_config.h"
+#include "OrderedHDDMWriter.h"
+#include "BackgroundEventPool.h"
 
 class MyProcessor:public JEventProcessor
 {
@@ -27,6 +31,10 @@ class MyProcessor:public JEventProcessor
    	  MyProcessor(mcsmear_config_t *in_config) {
    	  	 config = in_config;
    	  	 smearer = NULL;
+   	  	 calib = NULL;
+   	  	 writer = NULL;
+   	  	 merge_time_ns = 0;
+   	  	 Nbackground_merged = 0;
    	  }
    
       jerror_t init(void);                              ///< Called once at program start.
@@ -39,11 +47,21 @@ class MyProcessor:public JEventProcessor
 
       ofstream *ofs;
       hddm_s::ostream *fout; 
+      OrderedHDDMWriter *writer;
       unsigned long Nevents_written;
+      std::atomic<long long> merge_time_ns;       ///< time spent merging background events
+      std::atomic<unsigned long> Nbackground_merged;
 
    private:
       int  HDDM_USE_COMPRESSION;
       bool HDDM_USE_INTEGRITY_CHECKS;
+      int  OUTPUT_REORDER_WINDOW;
+      int  BACKGROUND_QUEUE_SIZE;
+      int  BACKGROUND_CACHE_EVENTS;
+      string CALIB_SNAPSHOT_LIST;
+      JCalibration *calib;
+      
+      vector<BackgroundEventPool*> bg_pools;
       
       mcsmear_config_t *config;
       Smear *smearer;
@@ -0,0 +1,161 @@
+// Ordered, asynchronous output stage for mcsmear
+//
+// See OrderedHDDMWriter.h for a description.
+
+#include "OrderedHDDMWriter.h"
+
+#include <iostream>
+using namespace std;
+
+
+//-----------
+// OrderedHDDMWriter (constructor)
+//-----------
+OrderedHDDMWriter::OrderedHDDMWriter(hddm_s::ostream *in_fout, unsigned int in_window)
+{
+	fout = in_fout;
+	window = (in_window > 0)? in_window : 1;
+	last_released = 0;
+	released_any = false;
+	closing = false;
+	Nwritten = 0;
+	Nlate = 0;
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&cond_ready, NULL);
+	pthread_cond_init(&cond_space, NULL);
+
+	running = (pthread_create(&thread, NULL, WriterThread, this) == 0);
+	if (!running) {
+		cerr << "OrderedHDDMWriter: unable to start writer thread, "
+		     << "cannot continue!" << endl;
+		exit(-1);
+	}
+}
+
+//-----------
+// OrderedHDDMWriter (destructor)
+//-----------
+OrderedHDDMWriter::~OrderedHDDMWriter()
+{
+	Close();
+	pthread_cond_destroy(&cond_space);
+	pthread_cond_destroy(&cond_ready);
+	pthread_mutex_destroy(&mutex);
+}
+
+//-----------
+// Write
+//-----------
+void OrderedHDDMWriter::Write(uint64_t seqno, hddm_s::HDDM *record)
+{
+	pthread_mutex_lock(&mutex);
+
+	if (released_any && seqno < last_released) {
+		// Arrived after a later event was already released,
+		// so it can no longer go out in order. Don't lose it.
+		ready.push_back(record);
+		Nlate++;
+	}
+	else {
+		pending.insert(std::make_pair(seqno, record));
+		Release();
+	}
+	pthread_cond_signal(&cond_ready);
+
+	// Throttle the event threads if the writer falls behind
+	while (ready.size() > window && !closing)
+		pthread_cond_wait(&cond_space, &mutex);
+
+	pthread_mutex_unlock(&mutex);
+}
+
+//-----------
+// Release
+//-----------
+void OrderedHDDMWriter::Release(void)
+{
+	/// Move records from the reorder buffer to the output queue
+	/// until the buffer is back within its window. Must be called
+	/// with the mutex held.
+	while (pending.size() > window) {
+		std::multimap<uint64_t, hddm_s::HDDM*>::iterator iter = pending.begin();
+		last_released = iter->first;
+		released_any = true;
+		ready.push_back(iter->second);
+		pending.erase(iter);
+	}
+}
+
+//-----------
+// Close
+//-----------
+void OrderedHDDMWriter::Close(void)
+{
+	pthread_mutex_lock(&mutex);
+	if (!running) {
+		pthread_mutex_unlock(&mutex);
+		return;
+	}
+
+	// Everything still buffered goes out in order
+	std::multimap<uint64_t, hddm_s::HDDM*>::iterator iter;
+	for (iter = pending.begin(); iter != pending.end(); ++iter)
+		ready.push_back(iter->second);
+	pending.clear();
+
+	closing = true;
+	pthread_cond_signal(&cond_ready);
+	pthread_cond_broadcast(&cond_space);
+	pthread_mutex_unlock(&mutex);
+
+	pthread_join(thread, NULL);
+	running = false;
+
+	if (Nlate > 0)
+		cerr << "OrderedHDDMWriter: " << Nlate << " events arrived too late"
+		     << " to be written in order; consider increasing"
+		     << " MCSMEAR:OUTPUT_REORDER_WINDOW" << endl;
+}
+
+//-----------
+// WriterThread
+//-----------
+void *OrderedHDDMWriter::WriterThread(void *arg)
+{
+	static_cast<OrderedHDDMWriter*>(arg)->Run();
+	return NULL;
+}
+
+//-----------
+// Run
+//-----------
+void OrderedHDDMWriter::Run(void)
+{
+	std::deque<hddm_s::HDDM*> batch;
+
+	pthread_mutex_lock(&mutex);
+	while (true) {
+		while (ready.empty() && !closing)
+			pthread_cond_wait(&cond_ready, &mutex);
+		if (ready.empty() && closing)
+			break;
+
+		batch.swap(ready);
+		pthread_cond_broadcast(&cond_space);
+		pthread_mutex_unlock(&mutex);
+
+		// Serialization, compression and CRC happen here,
+		// outside the lock and off the event threads
+		std::deque<hddm_s::HDDM*>::iterator iter;
+		for (iter = batch.begin(); iter != batch.end(); ++iter) {
+			*fout << **iter;
+			delete *iter;
+		}
+
+		pthread_mutex_lock(&mutex);
+		Nwritten += batch.size();
+		batch.clear();
+	}
+	pthread_mutex_unlock(&mutex);
+}
@@ -0,0 +1,67 @@
+// Ordered, asynchronous output stage for mcsmear
+//
+// Event threads hand finished records to Write() and return
+// immediately. Records wait in a small reorder buffer keyed by
+// their input sequence number (see DEventSourceHDDMSequenced), not
+// the physics event number, which may restart or jump between input
+// files. A single writer thread takes them out in ascending order and streams them through hddm_s::ostream, so
+// that serialization, compression and the CRC integrity checks
+// run on the writer thread and not on the event threads.
+//
+// The reorder buffer holds at most "window" records. When it is
+// full the record with the lowest sequence number is released to
+// the writer. As long as the window is larger than the number of
+// events in flight across all threads, output order equals input
+// order. A record that arrives after a later one has already been
+// released is written immediately and counted in GetNlate().
+
+#ifndef _ORDEREDHDDMWRITER_H_
+#define _ORDEREDHDDMWRITER_H_
+
+#include <map>
+#include <deque>
+#include <pthread.h>
+#include <stdint.h>
+
+#include <HDDM/hddm_s.hpp>
+
+class OrderedHDDMWriter
+{
+  public:
+	OrderedHDDMWriter(hddm_s::ostream *in_fout, unsigned int in_window=64);
+	~OrderedHDDMWriter();
+
+	// takes ownership of record; seqno is its position in the input
+	void Write(uint64_t seqno, hddm_s::HDDM *record);
+
+	// flush everything still buffered and stop the writer thread
+	void Close(void);
+
+	unsigned long GetNwritten(void) const { return Nwritten; }
+	unsigned long GetNlate(void) const { return Nlate; }
+
+  private:
+	static void *WriterThread(void *arg);
+	void Run(void);
+	void Release(void);
+
+	hddm_s::ostream *fout;   // not owned
+	unsigned int window;
+
+	std::multimap<uint64_t, hddm_s::HDDM*> pending;   // reorder buffer
+	std::deque<hddm_s::HDDM*> ready;                  // in output order
+	uint64_t last_released;
+	bool released_any;
+	bool closing;
+	bool running;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond_ready;
+	pthread_cond_t cond_space;
+	pthread_t thread;
+
+	unsigned long Nwritten;
+	unsigned long Nlate;
+};
+
+#endif // _ORDEREDHDDMWRITER_H_
@@ -20,6 +20,7 @@
 //    subsequent analysis.
 
 #include <iostream>
+#include <algorithm>
 #include <hddm_s_merger.h>
 #include <mcsmear_config.h>
 
@@ -2013,6 +2014,639 @@ hddm_s::FmwpcHitList &operator+=(hddm_s::FmwpcHitList &dst,
    return dst;
 }
 
+// K-way merging of many records at once
+//
+// The += operators above fold one background record at a time into the
+// destination, locating each channel by walking the destination list with
+// dst(i), which steps through the list from its head. With many records
+// merged into each event this does work quadratic in the number of channels.
+// merge_records instead collects the channels of the destination and of all
+// of the background records together, sorts them by channel index once, and
+// rebuilds each channel list in a single pass. The hits of every channel are
+// then folded in with the hit-level += operators above, record by record in
+// the order given, so the time window and charge summing rules are applied
+// exactly as when the records are merged one at a time. As with the pairwise
+// operators, channel lists are assumed to be in order without duplicates.
+
+namespace {
+
+   // one input to a k-way merge, with the time shift of the record it is from
+   template <class T>
+   struct merge_input {
+      T *elem;
+      double t_shift_ns;
+   };
+
+   struct channel_key {
+      int index[3];
+   };
+
+   bool operator<(const channel_key &a, const channel_key &b) {
+      for (int i=0; i < 3; ++i) {
+         if (a.index[i] != b.index[i])
+            return a.index[i] < b.index[i];
+      }
+      return false;
+   }
+
+   channel_key make_key(int i0, int i1=0, int i2=0) {
+      channel_key key;
+      key.index[0] = i0;
+      key.index[1] = i1;
+      key.index[2] = i2;
+      return key;
+   }
+
+   template <class Elem>
+   struct channel_entry {
+      channel_key key;
+      int source;   // 0 for the destination record
+      Elem *elem;
+      double t_shift_ns;
+   };
+
+   template <class Elem>
+   bool operator<(const channel_entry<Elem> &a, const channel_entry<Elem> &b) {
+      return a.key < b.key;
+   }
+
+   // gather a child list from each of the inputs
+   template <class Elem, class List>
+   std::vector<merge_input<List> > children(std::vector<merge_input<Elem> > &srcs,
+                                            List &(Elem::*get)())
+   {
+      std::vector<merge_input<List> > lists;
+      for (size_t i=0; i < srcs.size(); ++i) {
+         merge_input<List> input = {&(srcs[i].elem->*get)(), srcs[i].t_shift_ns};
+         lists.push_back(input);
+      }
+      return lists;
+   }
+
+   // fold the hits of each input into dst, in order, with the time shift
+   // of the record each one is from
+   template <class Elem, class List>
+   void fold_hits(Elem &dst, std::vector<merge_input<Elem> > &srcs,
+                  List &(Elem::*get)())
+   {
+      double t_shift_saved = t_shift_ns;
+      for (size_t i=0; i < srcs.size(); ++i) {
+         t_shift_ns = srcs[i].t_shift_ns;
+         (dst.*get)() += (srcs[i].elem->*get)();
+      }
+      t_shift_ns = t_shift_saved;
+   }
+
+   // containers hold at most one element per record, into which the
+   // contents of all of the inputs are merged
+   template <class List, class Elem>
+   void merge_container(List &dst, std::vector<merge_input<List> > &srcs,
+                        void (*merge)(Elem &dst,
+                                      std::vector<merge_input<Elem> > &srcs))
+   {
+      std::vector<merge_input<Elem> > elems;
+      for (size_t i=0; i < srcs.size(); ++i) {
+         typename List::iterator iter;
+         for (iter = srcs[i].elem->begin(); iter != srcs[i].elem->end(); ++iter) {
+            merge_input<Elem> input = {&*iter, srcs[i].t_shift_ns};
+            elems.push_back(input);
+         }
+      }
+      if (elems.size() == 0)
+         return;
+      if (dst.size() == 0)
+         dst.add(1);
+      merge(dst(0), elems);
+   }
+
+   // channel lists are merged by sorting the channels of dst and of all
+   // of the inputs together, then rebuilding dst in order if any channels
+   // are new, appending the new list and dropping the old one
+   template <class List, class Elem>
+   void merge_channels(List &dst, std::vector<merge_input<List> > &srcs,
+                       channel_key (*key)(Elem &elem),
+                       void (*init)(Elem &dst, Elem &src),
+                       void (*merge)(Elem &dst,
+                                     std::vector<merge_input<Elem> > &srcs))
+   {
+      std::vector<channel_entry<Elem> > entries;
+      typename List::iterator iter;
+      for (iter = dst.begin(); iter != dst.end(); ++iter) {
+         channel_entry<Elem> entry = {key(*iter), 0, &*iter, 0};
+         entries.push_back(entry);
+      }
+      int ndst = entries.size();
+      for (size_t i=0; i < srcs.size(); ++i) {
+         for (iter = srcs[i].elem->begin(); iter != srcs[i].elem->end(); ++iter) {
+            channel_entry<Elem> entry = {key(*iter), int(i) + 1, &*iter,
+                                         srcs[i].t_shift_ns};
+            entries.push_back(entry);
+         }
+      }
+      if (int(entries.size()) == ndst)
+         return;
+      // stable, so that the inputs to each channel stay in record order
+      std::stable_sort(entries.begin(), entries.end());
+
+      // every channel of dst keeps its place, and each channel found only
+      // in the inputs takes a new one (within a channel, dst comes first)
+      int nslots = 0;
+      for (size_t i=0; i < entries.size(); ++i) {
+         if (entries[i].source == 0 || i == 0 ||
+             entries[i - 1].key < entries[i].key)
+         {
+            ++nslots;
+         }
+      }
+
+      // if every channel is already in dst it can be merged in place,
+      // otherwise the merged list is built after the old one
+      bool rebuild = (nslots > ndst);
+      typename List::iterator out;
+      if (rebuild) {
+         dst.add(nslots);
+         out = dst.begin();
+         for (int n=0; n < ndst; ++n)
+            ++out;
+      }
+      std::vector<merge_input<Elem> > inputs;
+      size_t i = 0;
+      while (i < entries.size()) {
+         size_t end = i + 1;
+         while (end < entries.size() && !(entries[i].key < entries[end].key))
+            ++end;
+         Elem *target = 0;
+         inputs.clear();
+         for (size_t j=i; j < end; ++j) {
+            if (entries[j].source > 0) {
+               merge_input<Elem> input = {entries[j].elem, entries[j].t_shift_ns};
+               inputs.push_back(input);
+            }
+            else if (rebuild) {
+               *out = *entries[j].elem;
+               if (target == 0)
+                  target = &*out;
+               ++out;
+            }
+            else if (target == 0) {
+               target = entries[j].elem;
+            }
+         }
+         if (target == 0) {
+            target = &*out;
+            init(*out, *inputs[0].elem);
+            ++out;
+         }
+         if (inputs.size() > 0)
+            merge(*target, inputs);
+         i = end;
+      }
+      if (rebuild)
+         dst.del(ndst, 0);
+   }
+
+   channel_key cdc_straw_key(hddm_s::CdcStraw &straw) {
+      return make_key(straw.getRing(), straw.getStraw());
+   }
+
+   void cdc_straw_init(hddm_s::CdcStraw &dst, hddm_s::CdcStraw &src) {
+      dst.setRing(src.getRing());
+      dst.setStraw(src.getStraw());
+   }
+
+   void cdc_straw_merge(hddm_s::CdcStraw &dst,
+                        std::vector<merge_input<hddm_s::CdcStraw> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::CdcStraw::getCdcStrawHits);
+   }
+
+   void central_dc_merge(hddm_s::CentralDC &dst,
+                         std::vector<merge_input<hddm_s::CentralDC> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::CdcStrawList> > straws =
+                     children(srcs, &hddm_s::CentralDC::getCdcStraws);
+      merge_channels(dst.getCdcStraws(), straws,
+                     cdc_straw_key, cdc_straw_init, cdc_straw_merge);
+   }
+
+   channel_key fdc_anode_wire_key(hddm_s::FdcAnodeWire &wire) {
+      return make_key(wire.getWire());
+   }
+
+   void fdc_anode_wire_init(hddm_s::FdcAnodeWire &dst,
+                            hddm_s::FdcAnodeWire &src)
+   {
+      dst.setWire(src.getWire());
+   }
+
+   void fdc_anode_wire_merge(hddm_s::FdcAnodeWire &dst,
+                        std::vector<merge_input<hddm_s::FdcAnodeWire> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::FdcAnodeWire::getFdcAnodeHits);
+   }
+
+   channel_key fdc_cathode_strip_key(hddm_s::FdcCathodeStrip &strip) {
+      return make_key(strip.getPlane(), strip.getStrip());
+   }
+
+   void fdc_cathode_strip_init(hddm_s::FdcCathodeStrip &dst,
+                               hddm_s::FdcCathodeStrip &src)
+   {
+      dst.setPlane(src.getPlane());
+      dst.setStrip(src.getStrip());
+   }
+
+   void fdc_cathode_strip_merge(hddm_s::FdcCathodeStrip &dst,
+                     std::vector<merge_input<hddm_s::FdcCathodeStrip> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::FdcCathodeStrip::getFdcCathodeHits);
+   }
+
+   channel_key fdc_chamber_key(hddm_s::FdcChamber &chamber) {
+      return make_key(chamber.getModule(), chamber.getLayer());
+   }
+
+   void fdc_chamber_init(hddm_s::FdcChamber &dst, hddm_s::FdcChamber &src) {
+      dst.setModule(src.getModule());
+      dst.setLayer(src.getLayer());
+   }
+
+   void fdc_chamber_merge(hddm_s::FdcChamber &dst,
+                          std::vector<merge_input<hddm_s::FdcChamber> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::FdcAnodeWireList> > wires =
+                     children(srcs, &hddm_s::FdcChamber::getFdcAnodeWires);
+      merge_channels(dst.getFdcAnodeWires(), wires, fdc_anode_wire_key,
+                     fdc_anode_wire_init, fdc_anode_wire_merge);
+      std::vector<merge_input<hddm_s::FdcCathodeStripList> > strips =
+                     children(srcs, &hddm_s::FdcChamber::getFdcCathodeStrips);
+      merge_channels(dst.getFdcCathodeStrips(), strips, fdc_cathode_strip_key,
+                     fdc_cathode_strip_init, fdc_cathode_strip_merge);
+   }
+
+   void forward_dc_merge(hddm_s::ForwardDC &dst,
+                         std::vector<merge_input<hddm_s::ForwardDC> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::FdcChamberList> > chambers =
+                     children(srcs, &hddm_s::ForwardDC::getFdcChambers);
+      merge_channels(dst.getFdcChambers(), chambers,
+                     fdc_chamber_key, fdc_chamber_init, fdc_chamber_merge);
+   }
+
+   channel_key stc_paddle_key(hddm_s::StcPaddle &paddle) {
+      return make_key(paddle.getSector());
+   }
+
+   void stc_paddle_init(hddm_s::StcPaddle &dst, hddm_s::StcPaddle &src) {
+      dst.setSector(src.getSector());
+   }
+
+   void stc_paddle_merge(hddm_s::StcPaddle &dst,
+                         std::vector<merge_input<hddm_s::StcPaddle> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::StcPaddle::getStcHits);
+   }
+
+   void start_cntr_merge(hddm_s::StartCntr &dst,
+                         std::vector<merge_input<hddm_s::StartCntr> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::StcPaddleList> > paddles =
+                     children(srcs, &hddm_s::StartCntr::getStcPaddles);
+      merge_channels(dst.getStcPaddles(), paddles,
+                     stc_paddle_key, stc_paddle_init, stc_paddle_merge);
+   }
+
+   channel_key bcal_cell_key(hddm_s::BcalCell &cell) {
+      return make_key(cell.getModule(), cell.getLayer(), cell.getSector());
+   }
+
+   void bcal_cell_init(hddm_s::BcalCell &dst, hddm_s::BcalCell &src) {
+      dst.setModule(src.getModule());
+      dst.setLayer(src.getLayer());
+      dst.setSector(src.getSector());
+   }
+
+   void bcal_cell_merge(hddm_s::BcalCell &dst,
+                        std::vector<merge_input<hddm_s::BcalCell> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::BcalCell::getBcalfADCDigiHits);
+      fold_hits(dst, srcs, &hddm_s::BcalCell::getBcalTDCDigiHits);
+      fold_hits(dst, srcs, &hddm_s::BcalCell::getBcalfADCHits);
+      fold_hits(dst, srcs, &hddm_s::BcalCell::getBcalTDCHits);
+   }
+
+   void barrel_emcal_merge(hddm_s::BarrelEMcal &dst,
+                        std::vector<merge_input<hddm_s::BarrelEMcal> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::BcalCellList> > cells =
+                     children(srcs, &hddm_s::BarrelEMcal::getBcalCells);
+      merge_channels(dst.getBcalCells(), cells,
+                     bcal_cell_key, bcal_cell_init, bcal_cell_merge);
+   }
+
+   channel_key ftof_counter_key(hddm_s::FtofCounter &counter) {
+      return make_key(counter.getPlane(), counter.getBar());
+   }
+
+   void ftof_counter_init(hddm_s::FtofCounter &dst, hddm_s::FtofCounter &src) {
+      dst.setPlane(src.getPlane());
+      dst.setBar(src.getBar());
+   }
+
+   void ftof_counter_merge(hddm_s::FtofCounter &dst,
+                        std::vector<merge_input<hddm_s::FtofCounter> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::FtofCounter::getFtofHits);
+   }
+
+   void forward_tof_merge(hddm_s::ForwardTOF &dst,
+                          std::vector<merge_input<hddm_s::ForwardTOF> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::FtofCounterList> > counters =
+                     children(srcs, &hddm_s::ForwardTOF::getFtofCounters);
+      merge_channels(dst.getFtofCounters(), counters,
+                     ftof_counter_key, ftof_counter_init, ftof_counter_merge);
+   }
+
+   channel_key fcal_block_key(hddm_s::FcalBlock &block) {
+      return make_key(block.getColumn(), block.getRow());
+   }
+
+   void fcal_block_init(hddm_s::FcalBlock &dst, hddm_s::FcalBlock &src) {
+      dst.setColumn(src.getColumn());
+      dst.setRow(src.getRow());
+   }
+
+   void fcal_block_merge(hddm_s::FcalBlock &dst,
+                         std::vector<merge_input<hddm_s::FcalBlock> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::FcalBlock::getFcalHits);
+   }
+
+   void forward_emcal_merge(hddm_s::ForwardEMcal &dst,
+                        std::vector<merge_input<hddm_s::ForwardEMcal> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::FcalBlockList> > blocks =
+                     children(srcs, &hddm_s::ForwardEMcal::getFcalBlocks);
+      merge_channels(dst.getFcalBlocks(), blocks,
+                     fcal_block_key, fcal_block_init, fcal_block_merge);
+   }
+
+   channel_key ccal_block_key(hddm_s::CcalBlock &block) {
+      return make_key(block.getColumn(), block.getRow());
+   }
+
+   void ccal_block_init(hddm_s::CcalBlock &dst, hddm_s::CcalBlock &src) {
+      dst.setColumn(src.getColumn());
+      dst.setRow(src.getRow());
+   }
+
+   void ccal_block_merge(hddm_s::CcalBlock &dst,
+                         std::vector<merge_input<hddm_s::CcalBlock> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::CcalBlock::getCcalHits);
+   }
+
+   void compton_emcal_merge(hddm_s::ComptonEMcal &dst,
+                       std::vector<merge_input<hddm_s::ComptonEMcal> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::CcalBlockList> > blocks =
+                     children(srcs, &hddm_s::ComptonEMcal::getCcalBlocks);
+      merge_channels(dst.getCcalBlocks(), blocks,
+                     ccal_block_key, ccal_block_init, ccal_block_merge);
+   }
+
+   channel_key micro_channel_key(hddm_s::MicroChannel &channel) {
+      return make_key(channel.getColumn(), channel.getRow());
+   }
+
+   void micro_channel_init(hddm_s::MicroChannel &dst,
+                           hddm_s::MicroChannel &src)
+   {
+      dst.setColumn(src.getColumn());
+      dst.setRow(src.getRow());
+      dst.setE(src.getE());
+   }
+
+   void micro_channel_merge(hddm_s::MicroChannel &dst,
+                       std::vector<merge_input<hddm_s::MicroChannel> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::MicroChannel::getTaggerHits);
+   }
+
+   channel_key hodo_channel_key(hddm_s::HodoChannel &channel) {
+      return make_key(channel.getCounterId());
+   }
+
+   void hodo_channel_init(hddm_s::HodoChannel &dst, hddm_s::HodoChannel &src) {
+      dst.setCounterId(src.getCounterId());
+      dst.setE(src.getE());
+   }
+
+   void hodo_channel_merge(hddm_s::HodoChannel &dst,
+                        std::vector<merge_input<hddm_s::HodoChannel> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::HodoChannel::getTaggerHits);
+   }
+
+   void tagger_merge(hddm_s::Tagger &dst,
+                     std::vector<merge_input<hddm_s::Tagger> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::MicroChannelList> > micros =
+                     children(srcs, &hddm_s::Tagger::getMicroChannels);
+      merge_channels(dst.getMicroChannels(), micros, micro_channel_key,
+                     micro_channel_init, micro_channel_merge);
+      std::vector<merge_input<hddm_s::HodoChannelList> > hodos =
+                     children(srcs, &hddm_s::Tagger::getHodoChannels);
+      merge_channels(dst.getHodoChannels(), hodos, hodo_channel_key,
+                     hodo_channel_init, hodo_channel_merge);
+   }
+
+   channel_key ps_tile_key(hddm_s::PsTile &tile) {
+      return make_key(tile.getArm(), tile.getColumn());
+   }
+
+   void ps_tile_init(hddm_s::PsTile &dst, hddm_s::PsTile &src) {
+      dst.setArm(src.getArm());
+      dst.setColumn(src.getColumn());
+   }
+
+   void ps_tile_merge(hddm_s::PsTile &dst,
+                      std::vector<merge_input<hddm_s::PsTile> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::PsTile::getPsHits);
+   }
+
+   void ps_fine_merge(hddm_s::PairSpectrometerFine &dst,
+               std::vector<merge_input<hddm_s::PairSpectrometerFine> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::PsTileList> > tiles =
+                     children(srcs, &hddm_s::PairSpectrometerFine::getPsTiles);
+      merge_channels(dst.getPsTiles(), tiles,
+                     ps_tile_key, ps_tile_init, ps_tile_merge);
+   }
+
+   channel_key psc_paddle_key(hddm_s::PscPaddle &paddle) {
+      return make_key(paddle.getArm(), paddle.getModule());
+   }
+
+   void psc_paddle_init(hddm_s::PscPaddle &dst, hddm_s::PscPaddle &src) {
+      dst.setArm(src.getArm());
+      dst.setModule(src.getModule());
+   }
+
+   void psc_paddle_merge(hddm_s::PscPaddle &dst,
+                         std::vector<merge_input<hddm_s::PscPaddle> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::PscPaddle::getPscHits);
+   }
+
+   void ps_coarse_merge(hddm_s::PairSpectrometerCoarse &dst,
+             std::vector<merge_input<hddm_s::PairSpectrometerCoarse> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::PscPaddleList> > paddles =
+                 children(srcs, &hddm_s::PairSpectrometerCoarse::getPscPaddles);
+      merge_channels(dst.getPscPaddles(), paddles,
+                     psc_paddle_key, psc_paddle_init, psc_paddle_merge);
+   }
+
+   channel_key tpol_sector_key(hddm_s::TpolSector &sector) {
+      return make_key(sector.getSector());
+   }
+
+   void tpol_sector_init(hddm_s::TpolSector &dst, hddm_s::TpolSector &src) {
+      dst.setSector(src.getSector());
+   }
+
+   void tpol_sector_merge(hddm_s::TpolSector &dst,
+                          std::vector<merge_input<hddm_s::TpolSector> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::TpolSector::getTpolHits);
+   }
+
+   void tpol_merge(hddm_s::TripletPolarimeter &dst,
+               std::vector<merge_input<hddm_s::TripletPolarimeter> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::TpolSectorList> > sectors =
+                 children(srcs, &hddm_s::TripletPolarimeter::getTpolSectors);
+      merge_channels(dst.getTpolSectors(), sectors,
+                     tpol_sector_key, tpol_sector_init, tpol_sector_merge);
+   }
+
+   channel_key fmwpc_chamber_key(hddm_s::FmwpcChamber &chamber) {
+      return make_key(chamber.getLayer(), chamber.getWire());
+   }
+
+   void fmwpc_chamber_init(hddm_s::FmwpcChamber &dst,
+                           hddm_s::FmwpcChamber &src)
+   {
+      dst.setLayer(src.getLayer());
+      dst.setWire(src.getWire());
+   }
+
+   void fmwpc_chamber_merge(hddm_s::FmwpcChamber &dst,
+                       std::vector<merge_input<hddm_s::FmwpcChamber> > &srcs)
+   {
+      fold_hits(dst, srcs, &hddm_s::FmwpcChamber::getFmwpcHits);
+   }
+
+   void forward_mwpc_merge(hddm_s::ForwardMWPC &dst,
+                        std::vector<merge_input<hddm_s::ForwardMWPC> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::FmwpcChamberList> > chambers =
+                     children(srcs, &hddm_s::ForwardMWPC::getFmwpcChambers);
+      merge_channels(dst.getFmwpcChambers(), chambers, fmwpc_chamber_key,
+                     fmwpc_chamber_init, fmwpc_chamber_merge);
+   }
+
+   void hit_view_merge(hddm_s::HitView &dst,
+                       std::vector<merge_input<hddm_s::HitView> > &srcs)
+   {
+      if (enable_cdc_merging) {
+         std::vector<merge_input<hddm_s::CentralDCList> > cdcs =
+                     children(srcs, &hddm_s::HitView::getCentralDCs);
+         merge_container(dst.getCentralDCs(), cdcs, central_dc_merge);
+      }
+      if (enable_fdc_merging) {
+         std::vector<merge_input<hddm_s::ForwardDCList> > fdcs =
+                     children(srcs, &hddm_s::HitView::getForwardDCs);
+         merge_container(dst.getForwardDCs(), fdcs, forward_dc_merge);
+      }
+      if (enable_stc_merging) {
+         std::vector<merge_input<hddm_s::StartCntrList> > stcs =
+                     children(srcs, &hddm_s::HitView::getStartCntrs);
+         merge_container(dst.getStartCntrs(), stcs, start_cntr_merge);
+      }
+      if (enable_bcal_merging) {
+         std::vector<merge_input<hddm_s::BarrelEMcalList> > bcals =
+                     children(srcs, &hddm_s::HitView::getBarrelEMcals);
+         merge_container(dst.getBarrelEMcals(), bcals, barrel_emcal_merge);
+      }
+      if (enable_fcal_merging) {
+         std::vector<merge_input<hddm_s::ForwardEMcalList> > fcals =
+                     children(srcs, &hddm_s::HitView::getForwardEMcals);
+         merge_container(dst.getForwardEMcals(), fcals, forward_emcal_merge);
+      }
+      if (enable_ftof_merging) {
+         std::vector<merge_input<hddm_s::ForwardTOFList> > ftofs =
+                     children(srcs, &hddm_s::HitView::getForwardTOFs);
+         merge_container(dst.getForwardTOFs(), ftofs, forward_tof_merge);
+      }
+      if (enable_ccal_merging) {
+         std::vector<merge_input<hddm_s::ComptonEMcalList> > ccals =
+                     children(srcs, &hddm_s::HitView::getComptonEMcals);
+         merge_container(dst.getComptonEMcals(), ccals, compton_emcal_merge);
+      }
+      if (enable_tag_merging) {
+         std::vector<merge_input<hddm_s::TaggerList> > tags =
+                     children(srcs, &hddm_s::HitView::getTaggers);
+         merge_container(dst.getTaggers(), tags, tagger_merge);
+      }
+      if (enable_ps_merging) {
+         std::vector<merge_input<hddm_s::PairSpectrometerFineList> > pss =
+                     children(srcs, &hddm_s::HitView::getPairSpectrometerFines);
+         merge_container(dst.getPairSpectrometerFines(), pss, ps_fine_merge);
+      }
+      if (enable_psc_merging) {
+         std::vector<merge_input<hddm_s::PairSpectrometerCoarseList> > pscs =
+                   children(srcs, &hddm_s::HitView::getPairSpectrometerCoarses);
+         merge_container(dst.getPairSpectrometerCoarses(), pscs,
+                         ps_coarse_merge);
+      }
+      if (enable_tpol_merging) {
+         std::vector<merge_input<hddm_s::TripletPolarimeterList> > tpols =
+                   children(srcs, &hddm_s::HitView::getTripletPolarimeters);
+         merge_container(dst.getTripletPolarimeters(), tpols, tpol_merge);
+      }
+      if (enable_fmwpc_merging) {
+         std::vector<merge_input<hddm_s::ForwardMWPCList> > fmwpcs =
+                     children(srcs, &hddm_s::HitView::getForwardMWPCs);
+         merge_container(dst.getForwardMWPCs(), fmwpcs, forward_mwpc_merge);
+      }
+   }
+
+   void physics_event_merge(hddm_s::PhysicsEvent &dst,
+                       std::vector<merge_input<hddm_s::PhysicsEvent> > &srcs)
+   {
+      std::vector<merge_input<hddm_s::HitViewList> > views =
+                     children(srcs, &hddm_s::PhysicsEvent::getHitViews);
+      merge_container(dst.getHitViews(), views, hit_view_merge);
+   }
+}
+
+void hddm_s_merger::merge_records(hddm_s::HDDM &dst,
+                                  std::vector<hddm_s::HDDM*> &srcs,
+                                  std::vector<double> &t_shifts_ns)
+{
+   std::vector<merge_input<hddm_s::PhysicsEventList> > events;
+   for (size_t i=0; i < srcs.size(); ++i) {
+      merge_input<hddm_s::PhysicsEventList> input =
+                     {&srcs[i]->getPhysicsEvents(), t_shifts_ns[i]};
+      events.push_back(input);
+   }
+   merge_container(dst.getPhysicsEvents(), events, physics_event_merge);
+}
+
 void hddm_s_merger::truncate_hits(hddm_s::HDDM &record) {
    hddm_s::CdcStrawList straws = record.getCdcStraws();
    hddm_s::CdcStrawList::iterator istraw;
@@ -7,6 +7,8 @@
 #ifndef _HDDM_S_MERGER_H_
 #define _HDDM_S_MERGER_H_
 
+#include <vector>
+
 #include <HDDM/hddm_s.hpp>
 
 namespace hddm_s_merger {
@@ -140,6 +142,12 @@ namespace hddm_s_merger {
    double get_fmwpc_min_delta_t_ns();
    void set_fmwpc_min_delta_t_ns(double dt_ns);
 
+   // merge several records into dst at once, the hits of each shifted
+   // in time by the matching entry of t_shifts_ns; the result is the same
+   // as adding the records to dst one after the other with +=
+   void merge_records(hddm_s::HDDM &dst, std::vector<hddm_s::HDDM*> &srcs,
+                      std::vector<double> &t_shifts_ns);
+
    void truncate_hits(hddm_s::HDDM &record);
    void truncate_cdc_hits(hddm_s::CdcStrawHitList &hits);
    void truncate_fdc_wire_hits(hddm_s::FdcAnodeHitList &hits);
@@ -19,7 +19,9 @@ using namespace std;
 #include <time.h>
 
 #include <DANA/DApplication.h>
+#include <CALIB_SNAPSHOT/JCalibrationSnapshot.h>
 #include "MyProcessor.h"
+#include "DEventSourceHDDMSequenced.h"
 #include "JFactoryGenerator_ThreadCancelHandler.h"
 #include "mcsmear_config.h" 
 #include "hddm_s_merger.h"
@@ -51,8 +53,9 @@ using namespace jana;
 // be initialized using the UUID (see code for ROOT's
 // TRandom2 constructor) No argument, or an argument 
 // greater than zero will result in the same seeds 
-// being set every time mcsmear is run.
-DRandom2 gDRandom(0); // declared extern in DRandom2.h
+// being set every time mcsmear is run. Each thread gets
+// its own instance, reseeded at the start of every event.
+thread_local DRandom2 gDRandom(0); // declared extern in DRandom2.h
 
 const mcsmear_config_t *mcsmear_config;
 
@@ -68,6 +71,8 @@ int main(int narg,char* argv[])
    // Create DApplication object
    DApplication dapp(narg, argv);
    dapp.AddFactoryGenerator(new JFactoryGenerator_ThreadCancelHandler());
+   dapp.AddEventSourceGenerator(new JEventSourceGenerator_SequencedHDDM());
+   dapp.AddCalibrationGenerator(new JCalibrationGeneratorSnapshot());
 
    TFile *hfile = new TFile("smear.root","RECREATE","smearing histograms");  // note: not used for anything right now
 
@@ -107,6 +112,9 @@ void ParseCommandLineArguments(int narg, char* argv[], mcsmear_config_t *config)
           case 'E': config->FCAL_ADD_LIGHTGUIDE_HITS=true;       break;
 	      case 'R': config->SKIP_READING_RCDB=true;              break;
 	      case 't': config->MERGE_TAGGER_HITS=false;             break;
+	      case 'P':   // -Pkey=value is a JANA parameter
+	   		if (ptr[2] == '\0') config->MERGE_PAIRWISE=true;
+	   		break;
 	      case 'l': {
 	   		config->DETECTORS_TO_LOAD=&ptr[2];
 	   		cout << "Detector list: " << config->DETECTORS_TO_LOAD << endl;  
@@ -226,6 +234,7 @@ void Usage(void)
  //  cout << "    -Xsigma  BCAL fADC time resolution (def. " << BCAL_FADC_TIME_RESOLUTION << " ns)" << endl;
    cout << "    -R       Don't load information from RCDB" << endl;
    cout << "    -t       Don't merge random hits from tagger counters" << endl;
+   cout << "    -P       Merge background events one at a time (slower, for comparison)" << endl;
    cout << "    -D       Dump configuration debug information" << endl;
    cout << "    -G       Don't smear BCAL times (def. smear)" << endl;
    cout << "    -H       Don't add BCAL dark hits (def. add)" << endl;
@@ -29,6 +29,7 @@ mcsmear_config_t::mcsmear_config_t()
 	FCAL_ADD_LIGHTGUIDE_HITS = false;
 	SKIP_READING_RCDB = false;
 	MERGE_TAGGER_HITS = true;
+	MERGE_PAIRWISE = false;
 
           BCAL_NO_T_SMEAR = false;             
           BCAL_NO_DARK_PULSES = false;        
@@ -39,6 +40,11 @@ mcsmear_config_t::mcsmear_config_t()
 	  BCAL_NO_SIPM_SATURATION = false;    
 		
 	TRIGGER_LOOKBACK_TIME = -100; // ns
+	
+	// Key for per-event seeds when the input file seeds are ignored.
+	// Defaults to whatever the (UUID-seeded) main thread generator
+	// started with; overridden by -r on the command line.
+	gDRandom.GetSeeds(SEED_KEY[0], SEED_KEY[1], SEED_KEY[2]);
 		
 #ifdef HAVE_RCDB
 	// RCDB configuration
@@ -77,7 +83,9 @@ void mcsmear_config_t::SetSeeds(const char *vals)
    	UInt_t *useed1 = reinterpret_cast<UInt_t*>(&seed1);
    	UInt_t *useed2 = reinterpret_cast<UInt_t*>(&seed2);
    	UInt_t *useed3 = reinterpret_cast<UInt_t*>(&seed3);
-   	gDRandom.SetSeeds(*useed1, *useed2, *useed3);
+   	SEED_KEY[0] = *useed1;
+   	SEED_KEY[1] = *useed2;
+   	SEED_KEY[2] = *useed3;
 
    	cout << "Seeds set from command line. Any random number" << endl;
    	cout << "seeds found in the input file will be ignored!" << endl;
@@ -37,10 +37,12 @@ class mcsmear_config_t
 	bool DUMP_RCDB_CONFIG;
 	bool SKIP_READING_RCDB;
 	bool MERGE_TAGGER_HITS;
+	bool MERGE_PAIRWISE;  // merge background events one at a time, for comparison
 
 	//bool SMEAR_BCAL;
 	//bool FDC_ELOSS_OFF;
 	bool IGNORE_SEEDS;
+	UInt_t SEED_KEY[3];  // per-event seeds are derived from these when IGNORE_SEEDS is set
 	double TRIGGER_LOOKBACK_TIME;
 	bool APPLY_EFFICIENCY_CORRECTIONS;
 	bool APPLY_HITS_TRUNCATION;
@@ -90,9 +90,9 @@ Smear::~Smear()
 //-----------
 // SmearEvent
 //-----------
-void Smear::SmearEvent(hddm_s::HDDM *record)
+void Smear::SmearEvent(hddm_s::HDDM *record, uint64_t seqno)
 {
-    GetAndSetSeeds(record);
+    GetAndSetSeeds(record, seqno);
 
 	// Smear each detector system
 	for(map<DetectorSystem_t, Smearer *>::iterator smearer_it = smearers.begin();
@@ -113,33 +113,27 @@ void Smear::SetSeeds(const char *vals)
    /// the command line.
    //
    //
-   stringstream ss(vals);
-   Int_t seed1, seed2, seed3;
-   ss >> seed1 >> seed2 >> seed3;
-   UInt_t *useed1 = reinterpret_cast<UInt_t*>(&seed1);
-   UInt_t *useed2 = reinterpret_cast<UInt_t*>(&seed2);
-   UInt_t *useed3 = reinterpret_cast<UInt_t*>(&seed3);
-   gDRandom.SetSeeds(*useed1, *useed2, *useed3);
-
-   cout << "Seeds set from command line. Any random number" << endl;
-   cout << "seeds found in the input file will be ignored!" << endl;
-   config->IGNORE_SEEDS = true;
+   config->SetSeeds(vals);
 }
 
 //-----------
 // GetAndSetSeeds
 //-----------
-void Smear::GetAndSetSeeds(hddm_s::HDDM *record)
+void Smear::GetAndSetSeeds(hddm_s::HDDM *record, uint64_t seqno)
 {
    // Check if non-zero seed values exist in the input HDDM file.
    // If so, use them to set the seeds for the random number
    // generator. Otherwise, make sure the seeds that are used
    // are stored in the output event.
    
-   if (record == 0)
-      return;
-   else if (record->getReactions().size() == 0)
+   if (record == 0 || record->getReactions().size() == 0) {
+      // There is nowhere to take seeds from or store them. Derive
+      // them from the input position instead of carrying on from
+      // the thread's previous event. The run number is one no real
+      // run uses, so these never coincide with the seeds below.
+      gDRandom.SetSeedsFromCounter(config->SEED_KEY, 0xFFFFFF, seqno);
       return;
+   }
 
    hddm_s::ReactionList::iterator reiter = record->getReactions().begin();
    if (reiter->getRandoms().size() == 0) {
@@ -176,6 +170,15 @@ void Smear::GetAndSetSeeds(hddm_s::HDDM *record)
       // Set the seeds in the random generator.
       gDRandom.SetSeeds(seed1, seed2, seed3);
    }
+   else {
+      // Seeds in the file are ignored. Rather than letting the
+      // generator run on from the previous event (which depends
+      // on which thread got which events), derive this event's
+      // seeds from the seed key and the run/event numbers.
+      hddm_s::PhysicsEvent &pev = record->getPhysicsEvent();
+      gDRandom.SetSeedsFromCounter(config->SEED_KEY, pev.getRunNo(),
+                                   pev.getEventNo());
+   }
 
    // Copy seeds from generator to local variables
    gDRandom.GetSeeds(seed1, seed2, seed3);
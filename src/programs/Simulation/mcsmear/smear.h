@@ -4,6 +4,7 @@
 #define _SMEAR_H_
 
 #include <map>
+#include <stdint.h>
 using namespace std;
 
 #include "HDDM/hddm_s.hpp"
@@ -38,13 +39,14 @@ class Smear
 		Smear(mcsmear_config_t *in_config, JEventLoop *loop, string detectors_to_load="all");
 		~Smear();
 
-		// main entrance - takes an event and smears it
-		void SmearEvent(hddm_s::HDDM *record);
+		// main entrance - takes an event and smears it; seqno is
+		// its position in the input (see DEventSourceHDDMSequenced)
+		void SmearEvent(hddm_s::HDDM *record, uint64_t seqno);
 
     private:
     	// utility functions
 		void SetSeeds(const char *vals);
-		void GetAndSetSeeds(hddm_s::HDDM *record);
+		void GetAndSetSeeds(hddm_s::HDDM *record, uint64_t seqno);
 
 		// Detector digitization/smearing is implemented in a different class for each subdetector
 		map<DetectorSystem_t, Smearer *>  smearers;